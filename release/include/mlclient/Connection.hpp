@@ -30,10 +30,26 @@
 #include <mlclient/Document.hpp>
 #include <mlclient/DocumentSet.hpp>
 
+#include <memory>
+
+#ifndef SWIG
+#include <pplx/pplxtasks.h>
+#endif
+
 /**
  * \brief the namespace which wraps all Core Public C++ API classes.
  */
 namespace mlclient {
+
+#ifndef SWIG
+/**
+ * \brief The result of an asynchronous REST call. The Response is shared as pplx tasks require a copyable result.
+ *
+ * \since 8.0.3
+ */
+typedef pplx::task<std::shared_ptr<Response>> ResponseTask;
+#endif
+
 /**
  * \author Adam Fowler <adam.fowler@marklogic.com>
  * \since 8.0.0
@@ -451,6 +467,168 @@ public:
    */
   MLCLIENT_API virtual Response* listCollections(const std::string& parentCollection) = 0;
 
+#ifndef SWIG
+  /// \name async_rest Asynchronous variants of the above calls
+  ///
+  /// Each returns a task that completes with the Response, rather than blocking the calling thread while the
+  /// request is in flight. Chain work on to the response with then() rather than calling get() where possible.
+  ///
+  /// All arguments (including request bodies and search descriptions) are read before the function returns,
+  /// so need not outlive the call. The task throws if the request could not be sent.
+  ///
+  /// The default implementations in this class perform the synchronous call and return a completed task.
+  /// Connection overrides them all with non blocking versions.
+  // @{
+
+  /**
+   * \brief Asynchronously performs a HTTP GET Request against MarkLogic Server.
+   *
+   * See doGet for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask doGetAsync(const std::string& pathAndQuerystring);
+
+  /**
+   * \brief Asynchronously performs a HTTP PUT Request against MarkLogic Server.
+   *
+   * See doPut for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask doPutAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload);
+
+  /**
+   * \brief Asynchronously performs a HTTP POST Request against MarkLogic Server.
+   *
+   * See doPost for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask doPostAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload);
+
+  /**
+   * \brief Asynchronously performs a HTTP DELETE Request against MarkLogic Server.
+   *
+   * See doDelete for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask doDeleteAsync(const std::string& pathAndQueryString);
+
+  /**
+   * \brief Asynchronously retrieves a document from the server, at the given document URI
+   *
+   * See getDocument(const std::string&) for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask getDocumentAsync(const std::string& uri);
+
+  /**
+   * \brief Asynchronously saves a document to MarkLogic, at the given document URI
+   *
+   * See saveDocumentContent for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask saveDocumentContentAsync(const std::string& uri,const IDocumentContent& payload);
+
+  /**
+   * \brief Asynchronously saves a set of documents as a single batch to MarkLogic Server
+   *
+   * See saveDocuments for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive);
+
+  /**
+   * \brief Asynchronously saves the specified document to MarkLogic Server
+   *
+   * See saveDocument for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask saveDocumentAsync(const Document& doc);
+
+  /**
+   * \brief Asynchronously deletes the specified document by URI
+   *
+   * See deleteDocument for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask deleteDocumentAsync(const std::string& uri);
+
+  /**
+   * \brief Asynchronously performs a search against the MarkLogic database
+   *
+   * See search for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask searchAsync(const SearchDescription& desc);
+
+  /**
+   * \brief Asynchronously performs a search against a REST extension compatible with POST /v1/search
+   *
+   * See searchExtension for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask searchExtensionAsync(const std::string& extensionName,const SearchDescription& desc);
+
+  /**
+   * \brief Asynchronously saves search options to the server.
+   *
+   * See saveSearchOptions for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask saveSearchOptionsAsync(const std::string& optionsName,const IDocumentContent* optionsDoc);
+
+  /**
+   * \brief Asynchronously performs a values lookup in MarkLogic Server
+   *
+   * See values for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask valuesAsync(const std::string& valuesName,const std::string& optionsName);
+
+  /**
+   * \brief Asynchronously performs a values lookup against a REST extension
+   *
+   * See valuesExtension for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask valuesExtensionAsync(const std::string& extensionName,const std::string& valuesName,
+      const std::string& optionsName,const SearchDescription& desc);
+
+  /**
+   * \brief Asynchronously lists the top level collections.
+   *
+   * See listRootCollections for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask listRootCollectionsAsync();
+
+  /**
+   * \brief Asynchronously lists the immediate child collections of the specified parent Collection.
+   *
+   * See listCollections for details.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual ResponseTask listCollectionsAsync(const std::string& parentCollection);
+
+  // @}
+#endif /* SWIG */
+
 
   /*
 
@@ -525,6 +703,55 @@ public:
 
 
 
+/**
+ * \brief Statistics for the keep-alive HTTP client pool used by a Connection
+ *
+ * \since 8.0.3
+ */
+struct ConnectionPoolStats {
+  /// Requests that re-used an idle pooled client
+  unsigned long hits = 0;
+  /// Requests that found no idle client for their host
+  unsigned long misses = 0;
+  /// New clients (and thus new TCP/TLS sessions) created
+  unsigned long connects = 0;
+  /// Idle clients removed due to the idle timeout, pool resizing or disconnect()
+  unsigned long evictions = 0;
+  /// Clients dropped on return due to a transport failure, a full pool or a disconnect()
+  unsigned long discards = 0;
+  /// Clients currently idle in the pool
+  unsigned long idle = 0;
+  /// Clients currently leased by in progress requests
+  unsigned long inUse = 0;
+};
+
+/**
+ * \brief Statistics for HTTP Digest authentication on a Connection
+ *
+ * The challenge rate is challenges / requests. Once a nonce has been obtained this should be near 0,
+ * with the occasional stale nonce challenge.
+ *
+ * \since 8.0.3
+ */
+struct AuthenticationStats {
+  /// Requests made, excluding authentication retries
+  unsigned long requests = 0;
+  /// Requests whose first attempt carried a precomputed Authorization header
+  unsigned long preemptive = 0;
+  /// 401 challenges received, each costing an extra round trip
+  unsigned long challenges = 0;
+  /// Challenges that were due to a stale (expired) nonce
+  unsigned long staleChallenges = 0;
+  /// Authorization headers computed
+  unsigned long headerBuilds = 0;
+  /// Total time spent computing Authorization headers, in nanoseconds
+  unsigned long long headerBuildNanos = 0;
+  /// Bodiless probe requests sent to obtain a challenge before uploading a large body
+  unsigned long probes = 0;
+  /// Request body bytes sent a second time because the first attempt was challenged
+  unsigned long long retransmittedBodyBytes = 0;
+};
+
 /**
  * \class Connection
  * \author Adam Fowler <adam.fowler@marklogic.com>
@@ -600,6 +827,92 @@ public:
    */
   MLCLIENT_API std::string getDatabaseName() override;
 
+  /**
+   * \brief Sets the maximum number of idle keep-alive HTTP clients retained for re-use. Defaults to 8.
+   *
+   * Set this to at least the number of threads that use this Connection concurrently (E.g. the number
+   * of parallel tasks in a DocumentBatchWriter). Setting 0 disables connection re-use.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] maxIdle The maximum number of idle clients kept open
+   */
+  MLCLIENT_API void setConnectionPoolSize(const unsigned int maxIdle);
+
+  /**
+   * \brief Sets the number of seconds an idle HTTP client is kept before being closed. Defaults to 30.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] seconds The idle timeout in seconds
+   */
+  MLCLIENT_API void setConnectionPoolIdleTimeout(const unsigned long seconds);
+
+  /**
+   * \brief Returns the keep-alive HTTP client pool statistics for this connection
+   *
+   * \since 8.0.3
+   *
+   * \return A snapshot of the ConnectionPoolStats
+   */
+  MLCLIENT_API ConnectionPoolStats getConnectionPoolStats() const;
+
+  /**
+   * \brief Returns the Digest authentication statistics for this connection
+   *
+   * \since 8.0.3
+   *
+   * \return A snapshot of the AuthenticationStats
+   */
+  MLCLIENT_API AuthenticationStats getAuthenticationStats() const;
+
+  /**
+   * \brief Sets the request body size at which an authentication probe is sent first. Defaults to 64 KB.
+   *
+   * If a request body is at least this large and the connection has not yet been issued a Digest nonce,
+   * a bodiless HEAD request is sent first to obtain one. This avoids uploading a large body only for it to
+   * be rejected with a 401 and sent again. Set to 0 to disable probing.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] bytes The threshold in bytes
+   */
+  MLCLIENT_API void setAuthProbeThreshold(const unsigned long bytes);
+
+  /**
+   * \brief Sets the maximum number of HTTP requests this connection has in flight at once. Defaults to 8.
+   *
+   * Threads sharing this Connection block until a slot is free. Set to 0 for no limit, or 1 to
+   * serialise all requests as versions prior to 8.0.3 did.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] max The maximum number of concurrent requests
+   */
+  MLCLIENT_API void setMaxInFlightRequests(const unsigned int max);
+
+  /**
+   * \brief Sets a separate maximum for read requests (GET, search, suggest) in flight. Defaults to 0 (no separate limit).
+   *
+   * Applied in addition to setMaxInFlightRequests.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] max The maximum number of concurrent read requests
+   */
+  MLCLIENT_API void setMaxInFlightReads(const unsigned int max);
+
+  /**
+   * \brief Sets a separate maximum for write requests (PUT, DELETE, document POST) in flight. Defaults to 0 (no separate limit).
+   *
+   * Applied in addition to setMaxInFlightRequests. Useful to stop a large ingest starving searches on the same Connection.
+   *
+   * \since 8.0.3
+   *
+   * \param[in] max The maximum number of concurrent write requests
+   */
+  MLCLIENT_API void setMaxInFlightWrites(const unsigned int max);
+
   // @}
 
   /// \name http_raw RAW HTTP commands
@@ -795,6 +1108,130 @@ public:
 
   // @}
 
+#ifndef SWIG
+  /// \name async_rest Asynchronous variants of the above calls
+  ///
+  /// None of these block the calling thread, even whilst waiting for an in flight request slot. See IConnection
+  /// for how the tasks complete.
+  // @{
+
+  /**
+   * \brief Asynchronously performs a HTTP GET Request against MarkLogic Server.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask doGetAsync(const std::string& pathAndQuerystring) override;
+
+  /**
+   * \brief Asynchronously performs a HTTP PUT Request against MarkLogic Server.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask doPutAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) override;
+
+  /**
+   * \brief Asynchronously performs a HTTP POST Request against MarkLogic Server.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask doPostAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) override;
+
+  /**
+   * \brief Asynchronously performs a HTTP DELETE Request against MarkLogic Server.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask doDeleteAsync(const std::string& pathAndQueryString) override;
+
+  /**
+   * \brief Asynchronously retrieves a document from the server, at the given document URI
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask getDocumentAsync(const std::string& uri) override;
+
+  /**
+   * \brief Asynchronously saves a document to MarkLogic, at the given document URI
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask saveDocumentContentAsync(const std::string& uri,const IDocumentContent& payload) override;
+
+  /**
+   * \brief Asynchronously saves a set of documents as a single batch to MarkLogic Server
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive) override;
+
+  /**
+   * \brief Asynchronously saves the specified document to MarkLogic Server
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask saveDocumentAsync(const Document& doc) override;
+
+  /**
+   * \brief Asynchronously deletes the specified document by URI
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask deleteDocumentAsync(const std::string& uri) override;
+
+  /**
+   * \brief Asynchronously performs a search against the MarkLogic database
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask searchAsync(const SearchDescription& desc) override;
+
+  /**
+   * \brief Asynchronously performs a search against a REST extension compatible with POST /v1/search
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask searchExtensionAsync(const std::string& extensionName,const SearchDescription& desc) override;
+
+  /**
+   * \brief Asynchronously saves search options to the server.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask saveSearchOptionsAsync(const std::string& optionsName,const IDocumentContent* optionsDoc) override;
+
+  /**
+   * \brief Asynchronously performs a values lookup in MarkLogic Server
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask valuesAsync(const std::string& valuesName,const std::string& optionsName) override;
+
+  /**
+   * \brief Asynchronously performs a values lookup against a REST extension
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask valuesExtensionAsync(const std::string& extensionName,const std::string& valuesName,
+      const std::string& optionsName,const SearchDescription& desc) override;
+
+  /**
+   * \brief Asynchronously lists the top level collections.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask listRootCollectionsAsync() override;
+
+  /**
+   * \brief Asynchronously lists the immediate child collections of the specified parent Collection.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API ResponseTask listCollectionsAsync(const std::string& parentCollection) override;
+
+  // @}
+#endif /* SWIG */
+
 private:
   class Impl; // forward declaration - PIMPL idiom
   Impl* mImpl;
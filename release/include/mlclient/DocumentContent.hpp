@@ -67,6 +67,19 @@ public:
    */
   MLCLIENT_API virtual std::istream* getStream() const = 0;
 
+  /**
+   * \brief Returns the length in bytes of the stream returned by getStream(), if known without reading it, or -1 if not.
+   *
+   * Content reporting a length is streamed to MarkLogic Server by PUT and POST requests rather than first being read
+   * in to memory with getContent(). Only return a length if the stream returned by getStream() owns its data (E.g.
+   * opens its own file handle), as the request may still be in flight after this content instance is destroyed.
+   *
+   * \return The stream length in bytes, or -1 (the default) if unknown
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual long long getStreamLength() const;
+
   /**
    * \brief Returns the content of this IDocumentContent as a std::string.
    *
@@ -104,6 +117,13 @@ public:
   MLCLIENT_API static const std::string MIME_DOCX; //< The value application/vnd.openxmlformats-officedocument.wordprocessingml.document
   MLCLIENT_API static const std::string MIME_PPT; //< The value application/vnd.ms-powerpoint
   MLCLIENT_API static const std::string MIME_PPTX; //< The value application/vnd.openxmlformats-officedocument.presentationml.presentation
+  MLCLIENT_API static const std::string MIME_XLS; //< The value application/vnd.ms-excel \since 8.0.3
+  MLCLIENT_API static const std::string MIME_XLSX; //< The value application/vnd.openxmlformats-officedocument.spreadsheetml.sheet \since 8.0.3
+  MLCLIENT_API static const std::string MIME_PDF; //< The value application/pdf \since 8.0.3
+  MLCLIENT_API static const std::string MIME_ZIP; //< The value application/zip \since 8.0.3
+  MLCLIENT_API static const std::string MIME_HTML; //< The value text/html \since 8.0.3
+  MLCLIENT_API static const std::string MIME_CSV; //< The value text/csv \since 8.0.3
+  MLCLIENT_API static const std::string MIME_BINARY; //< The value application/octet-stream \since 8.0.3
 
 };
 
@@ -116,6 +136,10 @@ public:
  *
  * This is the base class for any Document Node within the Document Traversal API.
  *
+ * Nodes returned by at(), asArray() and asObject() are owned by the IDocumentNavigator they were reached from, and
+ * remain valid until it is deleted. Do not delete them. (Since 8.0.3 - they were previously allocated on every call
+ * and never freed.) A node created directly rather than by a navigator owns the nodes reached from it instead.
+ *
  * \author Adam Fowler <adam.fowler@marklogic.com>
  * \since 8.0.2
  * \date 2016-07-30
@@ -268,6 +292,9 @@ public:
  * with internal MarkLogic document structures from the REST API (like search options), or if parsing search
  * result sets that contain document content.
  *
+ * Every node returned by, or reached from, a navigator is allocated from an arena the navigator owns, so navigation
+ * performs no per node heap allocation. The nodes are all deleted along with the navigator (since 8.0.3).
+ *
  * \author Adam Fowler <adam.fowler@marklogic.com>
  * \since 8.0.2
  * \date 2016-07-30
@@ -484,7 +511,22 @@ private:
  */
 class FileDocumentContent : public IDocumentContent {
 public:
+  /**
+   * \brief Wraps the given file. The MIME type is taken from the file extension (case insensitive), defaulting to
+   * application/json if the extension is not known.
+   *
+   * Known extensions: xml, json, txt, csv, htm, html, jpg, jpeg, png, gif, pdf, zip, doc, docx, ppt, pptx, xls, xlsx
+   */
   MLCLIENT_API FileDocumentContent(std::string file);
+  /**
+   * \brief As above, but if sniffMimeType is true and the extension is not known (or there is none), the MIME type is
+   * instead guessed from the first bytes of the file when first needed.
+   *
+   * Recognises PNG, GIF, JPEG, PDF and ZIP signatures, and XML, JSON, plain text and binary content.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API FileDocumentContent(std::string file,const bool sniffMimeType);
   MLCLIENT_API virtual ~FileDocumentContent();
 
   /**
@@ -498,6 +540,13 @@ public:
    */
   MLCLIENT_API std::istream* getStream() const override;
 
+  /**
+   * \brief Returns the size of the file in bytes, or -1 if it cannot be opened. Causes the file to be streamed when uploaded.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API long long getStreamLength() const override;
+
   /**
    * \brief Returns the content of this IDocumentContent as a std::string.
    *
@@ -521,10 +570,19 @@ public:
    *
    * E.g. application/json or application/xml
    *
+   * Stored in lower case, so getMimeType() may be compared with the IDocumentContent MIME constants.
+   *
    * \param[in] mt The mimetype string, not including encoding, for this Document Content. Assume always UTF-8 for MarkLogic Server)
    */
   MLCLIENT_API void setMimeType(const std::string& mt) override;
 
+  /**
+   * \brief Returns the path of the file this content reads, as passed to the constructor
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API const std::string& getFilename() const;
+
 private:
   class Impl;
   std::unique_ptr<Impl> mImpl;
@@ -23,6 +23,7 @@
 #include <mlclient/mlclient.hpp>
 #include <mlclient/HttpHeaders.hpp>
 
+#include <cstddef>
 #include <iosfwd>
 
 namespace mlclient {
@@ -129,6 +130,13 @@ public:
   /// Constructor
   ///
   MLCLIENT_API Response();
+
+  /**
+   * \brief Move constructor. Takes other's content without copying it. other is left as if default constructed.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API Response(Response&& other);
   MLCLIENT_API ~Response();
 
   ///
@@ -206,6 +214,22 @@ public:
   ///
   MLCLIENT_API const std::string& getContent() const;
 
+  /**
+   * \brief Returns a pointer to the raw response body, without copying it. Valid until this Response is modified or destroyed.
+   *
+   * \note Not null terminated for binary content. Use with getContentLength().
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API const char* getContentData() const;
+
+  /**
+   * \brief Returns the length of the raw response body in bytes
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API std::size_t getContentLength() const;
+
   /**
    * \brief Sets the string content for this Response
    *
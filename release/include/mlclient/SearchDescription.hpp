@@ -173,6 +173,29 @@ public:
    * \return The MIME type string. See DocumentContent::MIME_JSON and DocumentContent::MIME_XML
    */
   MLCLIENT_API const std::string getResponseMimeType() const;
+
+  /**
+   * \brief Runs the search as at the given point in time (database timestamp), so that results are consistent across
+   * several page requests even whilst the database is being updated
+   *
+   * MarkLogic Server returns the timestamp each search ran at in the ML-Effective-Timestamp response header. Searching
+   * at a past timestamp needs the database to retain it (see its merge timestamp setting), so it is never set for you
+   * when iterating a SearchResultSet - set it here for consistent pages. SearchResultSet::exportAll() does pin its
+   * pages to the initial page's timestamp.
+   *
+   * \since 8.0.3
+   * \date 2026-10-16
+   *
+   * \param timestamp The timestamp, or an empty string (the default) to search the latest state of the database
+   */
+  MLCLIENT_API void setTimestamp(const std::string& timestamp);
+
+  /**
+   * \brief Returns the point in time the search is run at, or an empty string if the latest
+   * \since 8.0.3
+   * \date 2026-10-16
+   */
+  MLCLIENT_API const std::string& getTimestamp() const;
   // @}
 
 private:
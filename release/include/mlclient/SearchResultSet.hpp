@@ -19,6 +19,27 @@ namespace mlclient {
 
 class SearchResultSetIterator; // fwd declaration - see end of file
 
+/**
+ * \brief Receives each result of an export. See SearchResultSet::exportAll()
+ *
+ * \note consume() is never called concurrently, so implementations need not be thread safe
+ *
+ * \note Can be subclassed directly in other wrappers (E.g. C#)
+ *
+ * \since 8.0.3
+ */
+class ISearchResultConsumer {
+public:
+  MLCLIENT_API virtual ~ISearchResultConsumer();
+
+  /**
+   * \brief Called once for each search result
+   *
+   * \param result The result. Only valid for the duration of the call - copy it if needed afterwards.
+   */
+  MLCLIENT_API virtual void consume(const SearchResult& result) = 0;
+};
+
 /**
  * \brief A self-advancing result set class
  *
@@ -69,10 +90,6 @@ public:
    */
   MLCLIENT_API SearchResultSetIterator* end() const;
 
-  // TODO initially, no request
-  // TODO then just make a request at end of a collection
-  // TODO in future though, specify how many pages we pre-fetch asynchronously between page processing operations (provide subclass of iterator)
-
   /**
    * \brief Uses the provided Connection and SearchDescription to perform a request, and initial this object and the list of results.
    *
@@ -84,6 +101,19 @@ public:
    */
   MLCLIENT_API bool fetch();
 
+#ifndef SWIG
+  /**
+   * \brief As fetch(), but returns without waiting for the first page. Does not block a thread while the request is in flight.
+   *
+   * \note Do not call begin() or any other function on this object until the task has completed.
+   *
+   * \return A task completing with true if no errors were raised, false otherwise (see getFetchException())
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API pplx::task<bool> fetchAsync();
+#endif
+
   /**
    * \brief Returns the exception, if any, encountered by fetch(). nullptr is returned if no exception raised.
    *
@@ -169,6 +199,89 @@ public:
    */
   MLCLIENT_API void setMaxResults(long maxResults);
 
+  /**
+   * \brief Sets the maximum number of pages requested concurrently ahead of the iterator. Defaults to 4.
+   *
+   * Pages are requested in parallel, but always added to the result set in order. The number actually in flight adapts
+   * between 1 and maxPages: it doubles whenever the iterator has to wait for a page, and falls back when the iterator
+   * is slower than the server, so a sequential scan runs at network bandwidth without needlessly loading the server.
+   *
+   * \note Set to 1 to request one page at a time, as prior to 8.0.3
+   *
+   * \since 8.0.3
+   *
+   * \param maxPages The maximum number of page requests in flight (minimum 1)
+   */
+  MLCLIENT_API void setReadAhead(const long maxPages);
+
+  /**
+   * \brief Returns the maximum number of pages requested concurrently ahead of the iterator
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API const long getReadAhead() const;
+
+  /**
+   * \brief Sets whether to hold only a window of results whilst iterating, rather than every result fetched. Defaults to false.
+   *
+   * When streaming, results are held in a ring of a fixed number of pages (one more than getReadAhead()). Each result is
+   * freed, along with the response it was parsed from, once the iterator has moved on far enough for its slot to be
+   * reused. Pages are not requested until there is room for them. A single pass over any number of results thus runs
+   * in constant memory.
+   *
+   * \note Must be called before fetch() or fetchAsync(). Has no effect afterwards.
+   * \note Only the results within the window may be read. The reference returned by SearchResultSetIterator::first()
+   * is only valid until the iterator has moved a window further on - copy the result (as operator* does) to keep it.
+   *
+   * \since 8.0.3
+   *
+   * \param streaming Whether to hold only a window of results
+   */
+  MLCLIENT_API void setStreaming(const bool streaming);
+
+  /**
+   * \brief Returns whether only a window of results is held whilst iterating
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API const bool isStreaming() const;
+
+  /**
+   * \brief Passes every result (up to any maximum set by setMaxResults) to the consumer, fetching pages in parallel
+   *
+   * Use instead of iterating when all results are wanted, E.g. for an export. Performs the initial fetch if fetch() has
+   * not already been called. Once the total is known every remaining page's offset is calculated up front, and pages
+   * are fetched with up to parallelPages requests in flight.
+   *
+   * All pages are searched at the point in time (database timestamp) of the initial page, unless the description
+   * already sets one (SearchDescription::setTimestamp()), so offsets are consistent and no result is missed or repeated
+   * even if the database is updated during the export. This needs the database to retain that point in time (its
+   * merge timestamp) for the length of the export.
+   *
+   * Exported results are not kept in this result set, so memory use is bounded however many results there are.
+   *
+   * \note Do not iterate over this result set whilst an export is running
+   *
+   * \since 8.0.3
+   *
+   * \param consumer Receives each result. In, but not OWNS. Must outlive the export.
+   * \param parallelPages The maximum number of page requests in flight at once
+   * \param ordered If true results are consumed in result order, buffering pages that arrive early (at most
+   * 2 x parallelPages). If false each page is consumed as soon as it arrives.
+   * \return true if every page was fetched and consumed, false otherwise (see getFetchException())
+   */
+  MLCLIENT_API bool exportAll(ISearchResultConsumer* consumer,const long parallelPages = 4,const bool ordered = true);
+
+#ifndef SWIG
+  /**
+   * \brief As exportAll(), but returns without waiting. No thread is blocked whilst requests are in flight.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API pplx::task<bool> exportAllAsync(ISearchResultConsumer* consumer,const long parallelPages = 4,
+      const bool ordered = true);
+#endif
+
   friend class SearchResultSetIterator;
 
 private:
@@ -245,6 +358,10 @@ public:
   /**
    * \brief The iterator increment operator
    *
+   * If a page of results could not be fetched (an exception, or a response other than 200 OK) no later pages are
+   * fetched, and the fetch exception (see SearchResultSet::getFetchException()) is rethrown on moving to the first
+   * result that is missing.
+   *
    * \test SearchResultSetTest::testCustomSnippetJson
    */
   MLCLIENT_API void operator++();
@@ -19,7 +19,9 @@
 #define AUTHENTICATING_PROXY
 
 #include "mlclient/internals/Credentials.hpp"
+#include "mlclient/internals/ConcurrencyLimiter.hpp"
 
+#include "mlclient/Connection.hpp"
 #include "mlclient/Response.hpp"
 #include "mlclient/DocumentContent.hpp"
 #include "mlclient/DocumentSet.hpp"
@@ -30,14 +32,27 @@
 #include <cstdint>
 #include <cpprest/http_client.h>
 #include <cpprest/json.h>
+#include <atomic>
 #include <mutex>
 
 namespace mlclient {
 
 namespace internals {
 
+class HttpClientPool;
+class MultipartBuffer;
+struct RequestState;
+
 const mlclient::HttpHeaders blankHeaders;
 
+/**
+ * \brief The class of endpoint a request is for, used to apply separate in flight limits to reads and writes
+ */
+enum class RequestClass {
+  READ,
+  WRITE
+};
+
 /**
  * \brief AuthenticatingProxy to handle authenticated calls to MarkLogic
  *
@@ -74,6 +89,53 @@ public:
   ///
   const Credentials& getCredentials(void) const;
 
+  ///
+  /// Sets the keep-alive client pool to lease HTTP clients from. The pool must outlive this proxy.
+  /// If never set (or nullptr) a new HTTP client is created for every request.
+  ///
+  /// \param pool The pool, owned by the caller
+  ///
+  void setClientPool(HttpClientPool* pool);
+
+  ///
+  /// Sets the maximum number of requests in flight at once through this proxy. 0 means unlimited.
+  ///
+  /// \param max The maximum number of concurrent requests
+  ///
+  void setMaxInFlight(const unsigned int max);
+
+  ///
+  /// Sets the maximum number of read requests (RequestClass::READ) in flight at once. 0 means no separate limit.
+  ///
+  /// \param max The maximum number of concurrent read requests
+  ///
+  void setMaxInFlightReads(const unsigned int max);
+
+  ///
+  /// Sets the maximum number of write requests (RequestClass::WRITE) in flight at once. 0 means no separate limit.
+  ///
+  /// \param max The maximum number of concurrent write requests
+  ///
+  void setMaxInFlightWrites(const unsigned int max);
+
+  ///
+  /// Returns the number of requests currently in flight through this proxy
+  ///
+  unsigned int getInFlight() const;
+
+  ///
+  /// Returns a snapshot of the Digest authentication statistics for this proxy
+  ///
+  AuthenticationStats getAuthenticationStats() const;
+
+  ///
+  /// Sets the body size at and above which, if we do not yet have a Digest nonce, a bodiless HEAD probe
+  /// is sent to obtain the challenge before the body is uploaded. 0 disables probing.
+  ///
+  /// \param bytes The threshold in bytes
+  ///
+  void setAuthProbeThreshold(const std::size_t bytes);
+
   ///
   /// Invokes a synchronous GET operation on the MarkLogic server.
   ///
@@ -93,12 +155,14 @@ public:
    * \param[in] path The URL path (E.g. /v1/documents) to invoke
    * \param[in] body The content to send as the POST body
    * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers)
+   * \param[in] requestClass Whether this POST reads (E.g. search) or writes data (Optional. Defaults to WRITE)
    * \return A Response pointer that the call is responsible for deleting
    */
   Response* postSync(const std::string& host,
       const std::string& path,
       const IDocumentContent& body,
-      const mlclient::HttpHeaders& headers = blankHeaders);
+      const mlclient::HttpHeaders& headers = blankHeaders,
+      const RequestClass requestClass = RequestClass::WRITE);
   /**
    * \brief A Synchronous HTTP POST with multi part MIME content
    *
@@ -137,20 +201,122 @@ public:
   Response* deleteSync(const std::string& host,
        const std::string& path,
        const mlclient::HttpHeaders& headers = blankHeaders);
+
+  /**
+   * \brief An asynchronous HTTP GET. As getSync, but returns without waiting for the response.
+   *
+   * \param[in] host The hostname or IP Address to communicate with
+   * \param[in] path The URL path (E.g. /v1/documents) to invoke
+   * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers)
+   * \return A task yielding the Response. The task throws if the request could not be sent.
+   */
+  ResponseTask getAsync(const std::string& host,
+      const std::string& path,
+      const mlclient::HttpHeaders& headers = blankHeaders);
+
+  /**
+   * \brief An asynchronous HTTP POST. The body is read before this function returns, so need not outlive the call.
+   *
+   * \param[in] host The hostname or IP Address to communicate with
+   * \param[in] path The URL path (E.g. /v1/documents) to invoke
+   * \param[in] body The content to send as the POST body
+   * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers)
+   * \param[in] requestClass Whether this POST reads (E.g. search) or writes data (Optional. Defaults to WRITE)
+   * \return A task yielding the Response. The task throws if the request could not be sent.
+   */
+  ResponseTask postAsync(const std::string& host,
+      const std::string& path,
+      const IDocumentContent& body,
+      const mlclient::HttpHeaders& headers = blankHeaders,
+      const RequestClass requestClass = RequestClass::WRITE);
+
+  /**
+   * \brief An asynchronous HTTP POST with multi part MIME content. The payload is built before this function returns.
+   *
+   * \param[in] host The hostname or IP Address to communicate with
+   * \param[in] path The URL path (E.g. /v1/documents) to invoke
+   * \param[in] body The set of content to send as the POST body
+   * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers) - that are common to all content
+   * \return A task yielding the Response. The task throws if the request could not be sent.
+   */
+  ResponseTask multiPostAsync(const std::string& host,const std::string& path,
+      const DocumentSet& allContent,const long startPosInclusive,
+      const long endPosInclusive, const mlclient::HttpHeaders& commonHeaders = blankHeaders);
+
+  /**
+   * \brief An asynchronous HTTP PUT. The body is read before this function returns, so need not outlive the call.
+   *
+   * \param[in] host The hostname or IP Address to communicate with
+   * \param[in] path The URL path (E.g. /v1/documents) to invoke
+   * \param[in] body The content to send as the PUT body
+   * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers)
+   * \return A task yielding the Response. The task throws if the request could not be sent.
+   */
+  ResponseTask putAsync(const std::string& host,
+      const std::string& path,
+      const IDocumentContent& body,
+      const mlclient::HttpHeaders& headers = blankHeaders);
+
+  /**
+   * \brief An asynchronous HTTP DELETE.
+   *
+   * \param[in] host The hostname or IP Address to communicate with
+   * \param[in] path The URL path (E.g. /v1/documents) to invoke
+   * \param[in\ headers The HTTP Headers to use (Optional. Defaults to a blank set of headers)
+   * \return A task yielding the Response. The task throws if the request could not be sent.
+   */
+  ResponseTask deleteAsync(const std::string& host,
+      const std::string& path,
+      const mlclient::HttpHeaders& headers = blankHeaders);
 private:
    AuthenticatingProxy(const AuthenticatingProxy& rhs); // hide copy constructor - not a valid operation
 
-   void buildBulkPayload(const DocumentSet& set,const long startIdx,const long endIdx, std::ostringstream& out);
+   /* Returns the rapi:metadata XML (quality, properties, collections, permissions) for a document */
+   static std::string buildMetadata(const Document& doc);
+
+   /* Appends the multipart bulk write body for the given documents to out. Content is streamed where it has a known length.
+    * Metadata is sent as default metadata parts, one per run of documents with identical metadata.
+    */
+   static void buildBulkPayload(const DocumentSet& set,const long startIdx,const long endIdx, MultipartBuffer& out);
 
    /* Copies Microsoft CPPREST headers to useful mlclient::HttpHeaders class */
    static void copyHeaders(const web::http::http_headers& from, mlclient::HttpHeaders& to);
 
-   Response* doRequest(const std::string& mthd,const std::string& host,const std::string& path,const HttpHeaders& headers,const IDocumentContent* body = nullptr);
+   /* Builds a request. Called once per attempt as cpprest requests cannot be re-sent. bodyStream, if set, is rewound and streamed. */
+   static web::http::http_request buildRequest(const std::string& method,const std::string& path,const HttpHeaders& headers,
+       const std::string& authorization,const utility::string_t* bodyString,std::istream* bodyStream,
+       const utility::size64_t streamLength,const utility::string_t& mimeString);
+
+   /* Converts a cpprest response into an mlclient Response once its body has arrived */
+   static ResponseTask toResponseAsync(web::http::http_response raw);
+
+   /* Returns the Authorization header value to send, or blank if we have no nonce yet. Parses challenge if not null. */
+   std::string authorizationFor(const std::string& method,const std::string& path,const std::string* challenge);
+
+   /* Sends a request, waiting for an in flight slot without blocking. The body is read before this returns. */
+   ResponseTask doRequestAsync(const std::string& mthd,const RequestClass requestClass,const std::string& host,const std::string& path,
+       const HttpHeaders& headers,const IDocumentContent* body = nullptr);
+
+   /* Sends a fully prepared request. Shared by doRequestAsync and multiPostAsync. */
+   ResponseTask sendAsync(std::shared_ptr<RequestState> state);
+
+   Response* doRequest(const std::string& mthd,const RequestClass requestClass,const std::string& host,const std::string& path,
+       const HttpHeaders& headers,const IDocumentContent* body = nullptr);
+
+   /* Waits for a request to complete, returning a new Response the caller owns, or nullptr on failure */
+   static Response* waitFor(ResponseTask task);
 
    Credentials credentials;
    uint32_t attempts;
+   HttpClientPool* clientPool;
+
+   ConcurrencyLimiter allLimiter;
+   ConcurrencyLimiter readLimiter;
+   ConcurrencyLimiter writeLimiter;
 
-   std::mutex restMutex;
+   mutable std::mutex authMutex; // guards credentials (nonce, nc) and authStats
+   AuthenticationStats authStats;
+   std::atomic<std::size_t> authProbeThreshold;
 };
 
 } // end namespace internals
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ConcurrencyLimiter.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_CONCURRENCYLIMITER_HPP_
+#define SRC_INTERNALS_CONCURRENCYLIMITER_HPP_
+
+#include <cpprest/http_client.h> // for pplx
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief A resizable counting semaphore bounding the number of requests in flight.
+ *
+ * A limit of 0 means unlimited. Changing the limit wakes any waiting threads so they re-check it.
+ *
+ * This class is thread safe.
+ */
+class ConcurrencyLimiter {
+public:
+  ConcurrencyLimiter(const unsigned int limit = 0);
+  ~ConcurrencyLimiter();
+
+  void setLimit(const unsigned int limit);
+  unsigned int getLimit() const;
+
+  /**
+   * \brief Blocks until a permit is available, then takes it.
+   */
+  void acquire();
+
+  /**
+   * \brief Returns a task that completes once a permit has been taken on the caller's behalf.
+   *
+   * Does not block the calling thread. The permit must be returned with release().
+   */
+  pplx::task<void> acquireAsync();
+
+  /**
+   * \brief Returns a permit taken by acquire().
+   */
+  void release();
+
+  /**
+   * \brief Returns the number of permits currently held.
+   */
+  unsigned int getInFlight() const;
+
+private:
+  ConcurrencyLimiter(const ConcurrencyLimiter& rhs); // hide copy constructor - not a valid operation
+
+  mutable std::mutex mMutex;
+  std::condition_variable mAvailable;
+  unsigned int mLimit;
+  unsigned int mInFlight;
+  std::deque<pplx::task_completion_event<void>> mAsyncWaiters;
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief RAII holder for a permit from one or two ConcurrencyLimiter instances.
+ *
+ * Permits are always taken in the order given and released in reverse, so callers must always pass
+ * limiters in the same order (E.g. endpoint class limiter first, then the overall limiter).
+ */
+class ConcurrencyPermit {
+public:
+  ConcurrencyPermit(ConcurrencyLimiter* first,ConcurrencyLimiter* second = nullptr);
+
+  /**
+   * \brief Adopts permits already taken (E.g. via acquireAsync), releasing them on destruction.
+   */
+  ConcurrencyPermit(ConcurrencyLimiter* first,ConcurrencyLimiter* second,std::adopt_lock_t);
+  ~ConcurrencyPermit();
+
+private:
+  ConcurrencyPermit(const ConcurrencyPermit& rhs); // hide copy constructor - not a valid operation
+
+  ConcurrencyLimiter* mFirst;
+  ConcurrencyLimiter* mSecond;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_CONCURRENCYLIMITER_HPP_ */
@@ -38,8 +38,9 @@ namespace internals {
 class Credentials {
   friend class AuthenticatingProxy;
 
-  std::wstring user;
-  std::wstring pass;
+  // held narrow, as sent on the wire, so we don't convert them on every request
+  std::string user;
+  std::string pass;
 
   std::string nonce;
   std::string qop;
@@ -48,6 +49,11 @@ class Credentials {
   std::string uri;
   std::string cnonce;
   uint32_t nonce_count;
+  bool stale;
+
+  // HA1 = MD5(user:realm:pass) only changes with the realm, so is cached
+  std::string ha1;
+  std::string ha1Realm;
 
 protected:
   ///
@@ -66,7 +72,8 @@ protected:
   ///
   /// Generate the authentication header contents.  This is what goes into
   /// the Authorize header.  Requires that the credentials are set up to
-  /// perform authentication and have a qop and nonce.
+  /// perform authentication and have a qop and nonce. Increments the nonce
+  /// count, so may be called for each request re-using the same nonce.
   ///
   /// \param method The HTTP method used.
   /// \param uri The path portion of the URI
@@ -127,10 +134,11 @@ public:
   bool canAuthenticate(void) const;
 
   ///
-  /// Parses the Authenticate header to extract the nonce, the qop and the
-  /// realm.  Once the credentials have been provided the authenticate
-  /// header, the credentials will be capable of formulating a response
-  /// to the digest challenge.
+  /// Parses the Authenticate header to extract the nonce, the qop, the
+  /// realm, the opaque value and the stale flag.  Once the credentials have
+  /// been provided the authenticate header, the credentials will be capable
+  /// of formulating a response to the digest challenge.  A new nonce resets
+  /// the nonce count.
   ///
   /// \param _raw The raw WWW Authenticate header
   ///
@@ -164,6 +172,14 @@ public:
   ///
   std::string getRealm(void) const;
 
+  ///
+  /// Returns whether the last challenge was due to a stale nonce (stale=true),
+  /// rather than bad credentials.
+  ///
+  /// \return The stale flag
+  ///
+  bool isStale(void) const;
+
 };
 
 }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FileStream.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_FILESTREAM_HPP_
+#define SRC_INTERNALS_FILESTREAM_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief A read only, seekable streambuf over a file, read by position (pread) rather than through a shared offset.
+ *
+ * The size is taken once, when the file is opened. A file truncated whilst being read simply ends early (readAt()
+ * returns 0), and a file that grows is read only up to that size.
+ */
+class FileBuffer : public std::streambuf {
+public:
+  FileBuffer(const std::string& filename);
+  ~FileBuffer();
+
+  bool isOpen() const;
+
+  /**
+   * \brief The size of the file when opened
+   */
+  std::uint64_t size() const;
+
+  /**
+   * \brief Reads up to count bytes from offset in to buffer, without affecting the stream position.
+   *
+   * Used by MultipartBuffer to read straight in to its own buffer.
+   *
+   * \return The number of bytes read, 0 at the end of the file (as opened), or -1 on error
+   */
+  long long readAt(char* buffer,const std::size_t count,const std::uint64_t offset) const;
+
+protected:
+  int_type underflow() override;
+  std::streamsize showmanyc() override;
+  pos_type seekoff(off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which = std::ios_base::in) override;
+  pos_type seekpos(pos_type pos,std::ios_base::openmode which = std::ios_base::in) override;
+
+private:
+  FileBuffer(const FileBuffer& rhs); // hide copy constructor - not a valid operation
+
+#ifndef _WIN32
+  int mFile;
+#else
+  void* mFile;
+#endif
+  std::uint64_t mSize;
+  std::uint64_t mPosition; // of the end of the get area
+  std::vector<char> mBuffer; // only allocated if read through the streambuf interface
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief An istream over its own FileBuffer, as returned by FileDocumentContent::getStream(). Fails if the file could
+ * not be opened.
+ *
+ * MultipartBuffer recognises this type and reads the file straight in to its own buffer.
+ */
+class FileStream : public std::istream {
+public:
+  FileStream(const std::string& filename);
+  ~FileStream();
+
+  FileBuffer& buffer();
+
+  /**
+   * \brief Returns the length of stream as returned by IDocumentContent::getStream(), given the streamLength reported
+   * before it was opened.
+   *
+   * For a FileStream this is the size of the file actually opened, as it may have changed in between.
+   */
+  static std::uint64_t lengthOf(const std::istream& stream,const long long streamLength);
+
+private:
+  FileStream(const FileStream& rhs); // hide copy constructor - not a valid operation
+
+  FileBuffer mBuffer;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_FILESTREAM_HPP_ */
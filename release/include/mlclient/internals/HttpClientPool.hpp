@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * HttpClientPool.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_HTTPCLIENTPOOL_HPP_
+#define SRC_INTERNALS_HTTPCLIENTPOOL_HPP_
+
+#include "mlclient/Connection.hpp"
+
+#include <cpprest/http_client.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief A per host pool of keep-alive cpprest http_client instances.
+ *
+ * Each cpprest http_client holds its own TCP (and TLS) sessions open between requests. Re-using the
+ * client rather than creating a new one per request means we only pay for connection setup once
+ * per pooled client, rather than once per REST call.
+ *
+ * Clients are leased for the duration of a single request (including any authentication retry) and
+ * returned afterwards. A client is only returned to the idle list if it is healthy - i.e. the request
+ * did not fail at the transport level - and the idle list for its host is not already full. Idle
+ * clients that have not been used within the idle timeout are evicted, as the server will have closed
+ * their keep-alive sockets by then anyway.
+ *
+ * This class is thread safe.
+ */
+class HttpClientPool {
+public:
+  typedef std::shared_ptr<web::http::client::http_client> ClientPtr;
+
+  /**
+   * \brief Creates a pool with the default size (8 idle clients per host) and idle timeout (30 seconds)
+   */
+  HttpClientPool();
+  ~HttpClientPool();
+
+  /**
+   * \brief Sets the maximum number of idle clients retained per host. 0 disables pooling.
+   */
+  void setMaxIdlePerHost(const std::size_t maxIdle);
+  std::size_t getMaxIdlePerHost() const;
+
+  /**
+   * \brief Sets how long a client may sit idle before it is evicted.
+   */
+  void setIdleTimeout(const std::chrono::seconds& timeout);
+  std::chrono::seconds getIdleTimeout() const;
+
+  /**
+   * \brief Returns a healthy client for the given host, creating a new one if none are idle.
+   *
+   * \param[in] host The scheme, host and port of the server. E.g. http://localhost:8002
+   */
+  ClientPtr acquire(const std::string& host);
+
+  /**
+   * \brief Returns a client previously obtained from acquire() to the pool.
+   *
+   * \param[in] host The same host string passed to acquire()
+   * \param[in] client The client to return
+   * \param[in] healthy false if the client suffered a transport error. Unhealthy clients are discarded.
+   */
+  void release(const std::string& host,ClientPtr client,const bool healthy);
+
+  /**
+   * \brief Removes all idle clients that have exceeded the idle timeout.
+   */
+  void evictIdle();
+
+  /**
+   * \brief Removes all idle clients. Clients currently leased are discarded when returned.
+   */
+  void clear();
+
+  /**
+   * \brief Returns a snapshot of the pool statistics.
+   */
+  ConnectionPoolStats getStats() const;
+
+private:
+  HttpClientPool(const HttpClientPool& rhs); // hide copy constructor - not a valid operation
+
+  struct IdleClient {
+    ClientPtr client;
+    std::chrono::steady_clock::time_point lastUsed;
+  };
+
+  void evictIdleLocked(const std::chrono::steady_clock::time_point& now);
+
+  mutable std::mutex mMutex;
+  std::map<std::string,std::deque<IdleClient>> mIdle;
+  std::size_t mMaxIdlePerHost;
+  std::chrono::seconds mIdleTimeout;
+  unsigned long mGeneration;
+  std::map<web::http::client::http_client*,unsigned long> mLeased;
+  ConnectionPoolStats mStats;
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief RAII holder for a client leased from a HttpClientPool.
+ *
+ * If constructed with a null pool, a private client is created for this lease alone, as was done
+ * prior to pooling.
+ */
+class HttpClientLease {
+public:
+  HttpClientLease(HttpClientPool* pool,const std::string& host);
+  ~HttpClientLease();
+
+  web::http::client::http_client& client();
+
+  /**
+   * \brief Marks the leased client as unhealthy, so it is not returned to the pool.
+   */
+  void markFailed();
+
+private:
+  HttpClientLease(const HttpClientLease& rhs); // hide copy constructor - not a valid operation
+
+  HttpClientPool* mPool;
+  std::string mHost;
+  HttpClientPool::ClientPtr mClient;
+  bool mHealthy;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_HTTPCLIENTPOOL_HPP_ */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MultipartStream.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_MULTIPARTSTREAM_HPP_
+#define SRC_INTERNALS_MULTIPARTSTREAM_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace mlclient {
+
+namespace internals {
+
+class FileBuffer;
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief A read only streambuf that concatenates a sequence of string and stream segments, producing bytes only as they are read.
+ *
+ * Used to send multipart bodies. Part headers are held as strings and handed to the reader without copying. Stream
+ * segments (E.g. files) are read through a fixed size buffer as the HTTP layer pulls bytes, so they are never held in
+ * memory in full (a FileStream is read by position straight in to that buffer). The total length is known up front, so the request can carry an exact Content-Length.
+ *
+ * Supports rewinding to the start (seek to position 0) so the body can be re-sent after an authentication challenge.
+ */
+class MultipartBuffer : public std::streambuf {
+public:
+  MultipartBuffer();
+  ~MultipartBuffer();
+
+  /**
+   * \brief Appends text. Merged with the previous segment if that is also text, so adjacent part headers become one segment.
+   */
+  void append(const std::string& text);
+
+  /**
+   * \brief Appends (large) text by taking ownership of it, without copying.
+   */
+  void append(std::string&& text);
+
+  /**
+   * \brief Appends a stream of exactly length bytes, read lazily. The stream must be positioned at its start.
+   *
+   * A FileStream is read by position, straight in to this buffer's read buffer. If a stream turns out shorter than
+   * length (E.g. a file truncated since its length was taken) the body ends early, and the server rejects it.
+   */
+  void append(std::unique_ptr<std::istream> stream,const std::uint64_t length);
+
+  /**
+   * \brief Returns the total number of bytes this buffer will produce
+   */
+  std::uint64_t getLength() const;
+
+protected:
+  int_type underflow() override;
+  pos_type seekoff(off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which = std::ios_base::in) override;
+  pos_type seekpos(pos_type pos,std::ios_base::openmode which = std::ios_base::in) override;
+
+private:
+  MultipartBuffer(const MultipartBuffer& rhs); // hide copy constructor - not a valid operation
+
+  struct Segment {
+    std::string text;
+    std::unique_ptr<std::istream> stream; // if null, this is a text segment
+    FileBuffer* file; // if not null, the stream is a FileStream and this is its buffer
+    std::uint64_t length;
+    std::uint64_t delivered;
+  };
+
+  bool rewind();
+
+  std::vector<Segment> mSegments;
+  std::size_t mCurrent;
+  std::uint64_t mLength;
+  std::uint64_t mPosition; // of the start of the current get area
+  std::vector<char> mReadBuffer;
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief An istream over its own MultipartBuffer
+ */
+class MultipartStream : public std::istream {
+public:
+  MultipartStream();
+  ~MultipartStream();
+
+  MultipartBuffer& buffer();
+
+private:
+  MultipartStream(const MultipartStream& rhs); // hide copy constructor - not a valid operation
+
+  MultipartBuffer mBuffer;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_MULTIPARTSTREAM_HPP_ */
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * NodeArena.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_NODEARENA_HPP_
+#define SRC_INTERNALS_NODEARENA_HPP_
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief A monotonic arena for the IDocumentNode instances (and their Impls) created while navigating a document.
+ *
+ * Objects are bump allocated from blocks that are only freed, after every object made in the arena has been
+ * destroyed in reverse order, when the arena itself is. Nothing is allocated until the first object is made, so an
+ * arena that is never used (E.g. that of a node whose children are never asked for) costs only its own few words.
+ * The first block is 256 bytes, and each further block is twice the size of the last, up to 64 KB.
+ *
+ * Memory is never reused within an arena, so a navigator asked for the same node many times holds a copy for each
+ * call until it is deleted.
+ *
+ * Not thread safe - as with the navigator that owns it.
+ */
+class NodeArena {
+public:
+  NodeArena();
+  ~NodeArena();
+
+  /**
+   * \brief Constructs a T in the arena, which will destroy it when the arena is destroyed. Never returns nullptr.
+   */
+  template<class T,class... Args> T* make(Args&&... args) {
+    void* mem = allocate(sizeof(T),alignof(T));
+    Destructor* dtor = static_cast<Destructor*>(allocate(sizeof(Destructor),alignof(Destructor)));
+    T* obj = new (mem) T(std::forward<Args>(args)...);
+    dtor->destroy = &NodeArena::destroy<T>;
+    dtor->object = obj;
+    dtor->previous = mLast;
+    mLast = dtor; // only once constructed - a constructor that throws leaves nothing to destroy
+    return obj;
+  }
+
+  /**
+   * \brief Copies a string in to the arena, returning the null terminated copy
+   */
+  const char* copy(const std::string& str);
+
+  /**
+   * \brief The bytes allocated for blocks so far, including any space not yet used. Zero until the first allocation.
+   */
+  std::size_t getReservedBytes() const;
+
+private:
+  NodeArena(const NodeArena& rhs); // hide copy constructor - not a valid operation
+
+  struct Destructor {
+    void (*destroy)(void* object);
+    void* object;
+    Destructor* previous;
+  };
+
+  struct Block {
+    Block* previous;
+  };
+
+  template<class T> static void destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+
+  void* allocate(const std::size_t size,const std::size_t align);
+
+  char* mNext; // nullptr until the first block is allocated
+
+  char* mEnd;
+  std::size_t mBlockSize; // of the next block
+  std::size_t mReserved;
+  Block* mBlocks; // most recent first
+  Destructor* mLast; // most recent first
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief The arena a node makes its child nodes in.
+ *
+ * A node that was itself made in an arena borrows that arena, so the whole tree reached from a navigator is freed
+ * with it. A node created directly (E.g. by new) has no arena until its first child is asked for, then creates one
+ * of its own that is freed along with the node.
+ */
+class NodeArenaRef {
+public:
+  NodeArenaRef(NodeArena* borrowed) : mArena(borrowed), mOwned(false) {
+    ;
+  }
+  ~NodeArenaRef() {
+    if (mOwned) {
+      delete mArena;
+    }
+  }
+
+  /**
+   * \brief Whether the node holding this ref was made in (and so will be destroyed by) the arena
+   */
+  bool isBorrowed() const {
+    return nullptr != mArena && !mOwned;
+  }
+
+  NodeArena& get() {
+    if (nullptr == mArena) {
+      mArena = new NodeArena;
+      mOwned = true;
+    }
+    return *mArena;
+  }
+
+  /**
+   * \brief Makes a child node, passing it the arena as its first constructor argument
+   */
+  template<class T,class... Args> T* make(Args&&... args) {
+    NodeArena& arena = get();
+    return arena.make<T>(arena,std::forward<Args>(args)...);
+  }
+
+private:
+  NodeArenaRef(const NodeArenaRef& rhs); // hide copy constructor - not a valid operation
+
+  NodeArena* mArena;
+  bool mOwned;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_NODEARENA_HPP_ */
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SearchResponseDecoder.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_SEARCHRESPONSEDECODER_HPP_
+#define SRC_INTERNALS_SEARCHRESPONSEDECODER_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \brief A range of the buffer being decoded. Empty (nullptr data) if not present.
+ */
+struct DecodedSpan {
+  const char* data;
+  std::size_t length;
+
+  bool empty() const {
+    return nullptr == data;
+  }
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief Decodes a /v1/search response, in JSON or XML, in a single pass over the response buffer.
+ *
+ * Nothing is built for the response as a whole. Each result's fields are decoded into a Row whose strings are reused
+ * from one result to the next, so no memory is allocated per field once the first few rows have been seen. The
+ * content, snippet and matches of each result are returned as spans of the buffer instead, for the caller to parse
+ * only if it needs them.
+ *
+ * A malformed response is reported by the decode functions returning false - no exceptions are thrown.
+ *
+ * The summary (snippet format, total, etc.) precedes the results in both formats, so is available when the first
+ * row is passed to the handler. Metrics follow the results, so are only available once decoding completes.
+ *
+ * An instance is not thread safe, but is cheap to create, so use one per response.
+ */
+class SearchResponseDecoder {
+public:
+  struct Summary {
+    bool hasSnippetFormat;
+    std::string snippetFormat;
+    long total;
+    long start;
+    long pageLength;
+    bool hasMetrics;
+    std::string queryResolutionTime; // W3C Duration String
+    std::string snippetResolutionTime; // W3C Duration String
+    std::string totalTime; // W3C Duration String
+  };
+
+  struct Row {
+    long index;
+    std::string uri;
+    std::string path;
+    long score;
+    double confidence;
+    double fitness;
+    std::string mimeType;
+    std::string format;
+    DecodedSpan result; // the whole result object or element
+    DecodedSpan content; // the content value or search:content element
+    DecodedSpan snippet; // the snippet value or search:snippet element
+    DecodedSpan matches; // the matches value or search:matches element
+  };
+
+  /**
+   * Called with each result, in order. The Row, and the strings within it, are only valid during the call.
+   */
+  typedef std::function<void(const Row& row)> RowHandler;
+
+  SearchResponseDecoder();
+  ~SearchResponseDecoder();
+
+  /**
+   * \brief Decodes a JSON search response, passing each result to the handler
+   *
+   * \return false if the response is malformed (see getError()). Rows before the error will have been handled.
+   */
+  bool decodeJson(const char* data,const std::size_t length,const RowHandler& handler);
+
+  /**
+   * \brief Decodes an XML search response, passing each result to the handler
+   *
+   * \return false if the response is malformed (see getError()). Rows before the error will have been handled.
+   */
+  bool decodeXml(const char* data,const std::size_t length,const RowHandler& handler);
+
+  const Summary& getSummary() const;
+
+  const std::string& getError() const;
+
+  /**
+   * \brief Unescapes a span holding a JSON string value (including its quotes)
+   *
+   * \return false if the span is not a JSON string
+   */
+  static bool jsonString(const DecodedSpan& span,std::string& out);
+
+private:
+  SearchResponseDecoder(const SearchResponseDecoder& rhs); // hide copy constructor - not a valid operation
+
+  void reset();
+
+  Summary mSummary;
+  Row mRow;
+  std::string mKey; // scratch, reused for each key or attribute name
+  std::string mValue; // scratch, reused for each scalar value
+  std::string mError;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_SEARCHRESPONSEDECODER_HPP_ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SyncManifest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_INTERNALS_SYNCMANIFEST_HPP_
+#define SRC_INTERNALS_SYNCMANIFEST_HPP_
+
+#include "mlclient/Document.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mlclient {
+
+namespace internals {
+
+/**
+ * \brief Returns the XXH64 hash of the given bytes
+ */
+std::uint64_t xxhash64(const char* data,const std::size_t length,const std::uint64_t seed = 0);
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief Computes the XXH64 hash of bytes given in pieces, so a file can be hashed without holding it in memory.
+ *
+ * The result is as xxhash64() over all the pieces in order, however they are split.
+ */
+class XxHash64 {
+public:
+  XxHash64(const std::uint64_t seed = 0);
+
+  void update(const char* data,const std::size_t length);
+
+  /**
+   * \brief Returns the hash of the bytes given so far
+   */
+  std::uint64_t digest() const;
+
+private:
+  std::uint64_t mSeed;
+  std::uint64_t mV1;
+  std::uint64_t mV2;
+  std::uint64_t mV3;
+  std::uint64_t mV4;
+  std::uint64_t mTotal;
+  char mBuffer[32]; // the start of a 32 byte stripe not yet given in full
+  std::size_t mBuffered;
+};
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief The state of each document as last uploaded, so that unchanged documents need not be uploaded again.
+ *
+ * Holds, per URI, the content size, modification time (for files), and XXH64 hashes of the content and the metadata
+ * (collections, permissions and properties). A file whose size and modification time are unchanged is not read at
+ * all. Otherwise its content is hashed, so a file that was merely touched is still recognised as unchanged.
+ *
+ * Saved as one tab separated line per URI, written to a temporary file then renamed over the manifest, so a crash
+ * never leaves a partial manifest.
+ *
+ * This class is thread safe.
+ */
+class SyncManifest {
+public:
+  struct Entry {
+    std::uint64_t size;
+    std::int64_t modified; // seconds since the epoch, or 0 if not a file
+    std::uint64_t contentHash;
+    std::uint64_t metadataHash;
+  };
+
+  SyncManifest();
+  ~SyncManifest();
+
+  /**
+   * \brief Loads the manifest at path. A missing file is an empty manifest (everything will be uploaded).
+   *
+   * \return false if the file exists but could not be read
+   */
+  bool load(const std::string& path);
+
+  /**
+   * \brief Calculates the document's current state into current, and marks its URI as seen in this run.
+   *
+   * \return true if the document is unchanged since the last upload recorded, and so need not be sent
+   */
+  bool check(const Document& doc,Entry& current);
+
+  /**
+   * \brief Records that a document has been uploaded in the given state
+   */
+  void commit(const std::string& uri,const Entry& entry);
+
+  /**
+   * \brief Returns the URIs in the manifest not passed to check() in this run - those whose source has gone
+   */
+  std::vector<std::string> getUnseen() const;
+
+  /**
+   * \brief Removes a URI (E.g. once deleted from the server)
+   */
+  void remove(const std::string& uri);
+
+  /**
+   * \brief Writes the manifest back to the path it was loaded from
+   */
+  bool save() const;
+
+private:
+  SyncManifest(const SyncManifest& rhs); // hide copy constructor - not a valid operation
+
+  struct Record {
+    Entry entry;
+    bool seen;
+  };
+
+  static std::uint64_t metadataHash(const Document& doc);
+
+  mutable std::mutex mMutex;
+  std::string mPath;
+  std::unordered_map<std::string,Record> mRecords;
+};
+
+} // end namespace internals
+
+} // end namespace mlclient
+
+#endif /* SRC_INTERNALS_SYNCMANIFEST_HPP_ */
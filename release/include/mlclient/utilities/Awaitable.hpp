@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * \file Awaitable.hpp
+ *
+ * \date 16 Oct 2026
+ *
+ * \brief C++20 coroutine (co_await) adapters for the asynchronous mlclient API.
+ *
+ * The library itself is built as C++11, so this header is header only and its content is only enabled when
+ * included from a translation unit compiled with coroutine support. Including it elsewhere is harmless.
+ *
+ * Example:-
+ * \code
+ * std::shared_ptr<Response> resp = co_await mlclient::utilities::awaitable(conn.searchAsync(desc));
+ * \endcode
+ *
+ * Fan out / fan in is done by starting several *Async calls, then awaiting pplx::when_all over their tasks.
+ */
+
+#ifndef INCLUDE_MLCLIENT_UTILITIES_AWAITABLE_HPP_
+#define INCLUDE_MLCLIENT_UTILITIES_AWAITABLE_HPP_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && !defined(SWIG)
+
+#include <mlclient/Connection.hpp>
+
+#include <coroutine>
+#include <functional>
+#include <utility>
+
+namespace mlclient {
+
+namespace utilities {
+
+/**
+ * \brief Resumes an awaiting coroutine. Called with a function that performs the resumption, which the executor
+ * may run wherever it likes (E.g. post it to an io_context, or a UI thread).
+ *
+ * \since 8.0.3
+ */
+typedef std::function<void(std::function<void()>)> Executor;
+
+/**
+ * \since 8.0.3
+ * \date 2026-10-16
+ *
+ * \brief An awaiter for a pplx::task, so any mlclient *Async call can be used with co_await.
+ *
+ * With no Executor the coroutine is resumed directly on the thread that completed the task (for requests, the
+ * cpprest thread that received the response), so there is no thread switch per request. Supply an Executor to
+ * resume elsewhere.
+ *
+ * If the task throws, the exception is rethrown from the co_await expression.
+ */
+template <typename T>
+class TaskAwaiter {
+public:
+  TaskAwaiter(pplx::task<T> task,Executor executor = Executor()) : mTask(std::move(task)), mExecutor(std::move(executor)) {
+    ;
+  }
+
+  bool await_ready() const {
+    return mTask.is_done(); // no need to suspend at all if already complete
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    Executor executor(mExecutor);
+    // Chain from a copy. If the task is already done the continuation may resume (and so destroy) the coroutine
+    // frame, which holds this awaiter, before then() returns.
+    pplx::task<T> task = mTask;
+    // task based continuation, so we resume on failure too
+    task.then([handle,executor] (pplx::task<T>) {
+      if (executor) {
+        executor([handle] () {
+          handle.resume();
+        });
+      } else {
+        handle.resume();
+      }
+    });
+  }
+
+  T await_resume() {
+    return mTask.get();
+  }
+
+private:
+  pplx::task<T> mTask;
+  Executor mExecutor;
+};
+
+/**
+ * \brief Wraps a task returned by any of the mlclient *Async functions so that it can be co_await'ed.
+ *
+ * E.g. conn.searchAsync(desc), conn.saveDocumentsAsync(set,0,99), resultSet.fetchAsync() or writer.sendAsync()
+ *
+ * \param[in] task The task to await
+ * \param[in] executor Where to resume the coroutine (Optional. Defaults to the thread completing the task)
+ * \return An awaiter yielding the task's result
+ *
+ * \since 8.0.3
+ */
+template <typename T>
+TaskAwaiter<T> awaitable(pplx::task<T> task,Executor executor = Executor()) {
+  return TaskAwaiter<T>(std::move(task),std::move(executor));
+}
+
+} // end namespace utilities
+
+} // end namespace mlclient
+
+#endif /* coroutine support */
+
+#endif /* INCLUDE_MLCLIENT_UTILITIES_AWAITABLE_HPP_ */
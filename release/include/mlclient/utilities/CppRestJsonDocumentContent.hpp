@@ -28,6 +28,10 @@
 
 namespace mlclient {
 
+namespace internals {
+class NodeArena; // forward declaration
+}
+
 namespace utilities {
 
 /**
@@ -68,6 +72,12 @@ public:
 class CppRestJsonArrayNode : public CppRestJsonContainerNode {
 public:
   MLCLIENT_API CppRestJsonArrayNode(web::json::array& root);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API CppRestJsonArrayNode(internals::NodeArena& arena,web::json::array& root);
   MLCLIENT_API virtual ~CppRestJsonArrayNode();
 
   MLCLIENT_API bool isArray() const override;
@@ -99,6 +109,12 @@ private:
 class CppRestJsonObjectNode : public CppRestJsonContainerNode {
 public:
   MLCLIENT_API CppRestJsonObjectNode(web::json::object& root);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API CppRestJsonObjectNode(internals::NodeArena& arena,web::json::object& root);
   MLCLIENT_API virtual ~CppRestJsonObjectNode();
 
   MLCLIENT_API bool isArray() const override;
@@ -133,6 +149,12 @@ private:
 class CppRestJsonDocumentNode : public IDocumentNode {
 public:
   MLCLIENT_API CppRestJsonDocumentNode(web::json::value& root);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API CppRestJsonDocumentNode(internals::NodeArena& arena,web::json::value& root);
   MLCLIENT_API CppRestJsonDocumentNode(CppRestJsonDocumentNode&& from);
   MLCLIENT_API virtual ~CppRestJsonDocumentNode();
 
@@ -172,6 +194,8 @@ private:
  * \date 2016-07-30
  *
  * \brief Provides a navigator interface over a CppRestJsonDocumentContent's root web::json::value instance.
+ *
+ * All nodes reached from this navigator are made in its arena, and are deleted along with it (since 8.0.3).
  */
 class CppRestJsonDocumentNavigator : public IDocumentNavigator {
 public:
@@ -23,8 +23,13 @@
 #include <mlclient/Document.hpp>
 #include <mlclient/DocumentContent.hpp>
 #include <mlclient/DocumentSet.hpp>
+#include <mlclient/utilities/DocumentSource.hpp>
 #include <mlclient/mlclient.hpp>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace mlclient {
 
 namespace utilities {
@@ -54,6 +59,87 @@ public:
 
 };
 
+/**
+ * \brief An IDocumentSource that lists the files in a folder and its subfolders as the upload proceeds
+ *
+ * Unlike DocumentBatchHelper::addFilesToDocumentSet, which must read the whole tree before uploading can start,
+ * several walker threads read folders in parallel and yield a Document (holding a FileDocumentContent) for each
+ * file as it is found. Pass this to DocumentBatchWriter::assignSource and the first batch can be sent within
+ * milliseconds, with the rest of the enumeration overlapping the upload. This matters most on network file systems
+ * where listing a large tree can take minutes.
+ *
+ * At most capacity documents are held waiting for upload. Walkers pause whilst the writer catches up.
+ *
+ * On Linux folders are read with getdents64 using a large buffer, which needs far fewer round trips on network file
+ * systems than readdir. File types are taken from the directory entry where the file system provides them, only
+ * falling back to stat() when it does not.
+ *
+ * Documents are produced in no particular order.
+ *
+ * A folder that cannot be opened, or whose listing fails part way through (E.g. a network error), does not stop the
+ * listing of other folders. Check getFoldersFailed() once the upload has finished - a non zero count means some
+ * files may not have been uploaded.
+ *
+ * See the cppbatchupload sample for example usage.
+ *
+ * \since 8.0.3
+ */
+class DirectoryDocumentSource : public IDocumentSource {
+public:
+  /**
+   * \brief Begins listing folder immediately, on walkerThreads background tasks
+   *
+   * Parameters other than the last three are as for DocumentBatchHelper::addFilesToDocumentSet.
+   *
+   * \param walkerThreads The number of folders to read in parallel (minimum 1)
+   * \param capacity The maximum number of Documents found but not yet pulled by next()
+   * \param showHiddenDirs Whether to descend into folders whose names begin with a '.'
+   */
+  MLCLIENT_API DirectoryDocumentSource(const std::string& folder,const std::string& baseFolder,const bool stripBase,
+      const std::string& appendBase,const CollectionSet& collections,const PermissionSet& permissions,
+      IDocumentContent* properties,const int walkerThreads = 4,const long capacity = 1000,bool showHiddenDirs = false);
+  /**
+   * \brief The DELETED copy constructor
+   */
+  MLCLIENT_API DirectoryDocumentSource(const DirectoryDocumentSource& other) = delete;
+  /**
+   * \brief Stops any listing still in progress, and waits for the walker threads to finish
+   */
+  MLCLIENT_API ~DirectoryDocumentSource();
+
+  MLCLIENT_API bool next(Document& out) override;
+  MLCLIENT_API void cancel() override;
+
+  /**
+   * \brief Returns the number of files found so far
+   */
+  MLCLIENT_API const long getFilesFound() const;
+  /**
+   * \brief Returns the number of folders read so far
+   */
+  MLCLIENT_API const long getFoldersRead() const;
+  /**
+   * \brief Returns the number of folders that could not be read in full so far
+   */
+  MLCLIENT_API const long getFoldersFailed() const;
+  /**
+   * \brief Returns the paths of the folders that could not be read in full so far
+   */
+  MLCLIENT_API std::vector<std::string> getFailedFolders() const;
+  /**
+   * \brief Returns getFoldersFailed()
+   */
+  MLCLIENT_API const long getFailureCount() const override;
+  /**
+   * \brief Returns whether all folders have been read (some documents may still be waiting to be pulled)
+   */
+  MLCLIENT_API const bool isEnumerationComplete() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> mImpl;
+};
+
 } // end namespace utilities
 
 } // end namespace mlclient
@@ -23,6 +23,7 @@
 #include <mlclient/DocumentSet.hpp>
 #include <mlclient/Document.hpp>
 #include <mlclient/Connection.hpp>
+#include <mlclient/utilities/DocumentSource.hpp>
 
 #include <mlclient/mlclient.hpp>
 
@@ -40,6 +41,10 @@ enum class TransactionMode {
 
 /**
  * \brief The progress of the upload within DocumentBatchWriter
+ *
+ * \note When uploading from an IDocumentSource, total is -1 (and percentageComplete and durationEstimateRemaining are not
+ * meaningful) until the source has been exhausted.
+ *
  * \since 8.0.2
  */
 struct Progress {
@@ -47,8 +52,145 @@ struct Progress {
   long total;
   double percentageComplete;
   long duration;
+  /**
+   * \brief Milliseconds remaining at the windowRate (or the overall rate, until a window has passed), or -1 if unknown
+   */
   long durationEstimateRemaining;
+  /**
+   * \brief Documents completed per second over the whole upload
+   */
   double rate;
+  /**
+   * \brief Documents completed per second over the last few (DocumentBatchWriter::METRICS_WINDOW_SECONDS) seconds
+   *
+   * Unlike rate, this falls as soon as throughput does
+   * \since 8.0.3
+   */
+  double windowRate;
+  /**
+   * \brief Megabytes of document content sent per second over the same window as windowRate, including retries
+   * \since 8.0.3
+   */
+  double windowMegabytesPerSecond;
+  /**
+   * \brief Bytes of document content sent over the whole upload, including retries
+   * \since 8.0.3
+   */
+  long long bytesSent;
+  /**
+   * \brief An exponentially weighted moving average of batch request latency, in milliseconds. Tracks recent latency.
+   * \since 8.0.3
+   */
+  double latencyAverage;
+  /**
+   * \brief The median batch request latency over the whole upload, in milliseconds (within 19%, from a histogram)
+   * \since 8.0.3
+   */
+  long latencyP50;
+  /**
+   * \brief The 95th percentile batch request latency over the whole upload, in milliseconds
+   * \since 8.0.3
+   */
+  long latencyP95;
+  /**
+   * \brief The 99th percentile batch request latency over the whole upload, in milliseconds
+   * \since 8.0.3
+   */
+  long latencyP99;
+  /**
+   * \brief The number of batch requests awaiting a response right now
+   * \since 8.0.3
+   */
+  int inFlight;
+  /**
+   * \brief The number of batches currently allowed in flight (changes over time in adaptive mode)
+   * \since 8.0.3
+   */
+  int parallelTasks;
+  /**
+   * \brief The number of documents per batch currently in use (changes over time in adaptive mode)
+   * \since 8.0.3
+   */
+  long batchSize;
+  /**
+   * \brief The target bytes per batch in adaptive mode, or 0 if not in adaptive mode
+   * \since 8.0.3
+   */
+  long batchBytes;
+  /**
+   * \brief The number of documents (included in completed) whose batch failed
+   * \since 8.0.3
+   */
+  long failed;
+  /**
+   * \brief The number of documents (included in completed) not sent because the sync manifest shows them unchanged, or
+   * the journal shows a previous run committed them
+   * \since 8.0.3
+   */
+  long skipped;
+  /**
+   * \brief The number of documents deleted because they were in the sync manifest but not in this upload
+   * \since 8.0.3
+   */
+  long deleted;
+  /**
+   * \brief The number of batch requests re-sent after a retryable failure (E.g. a 503 response or a timeout)
+   * \since 8.0.3
+   */
+  long retries;
+};
+
+/**
+ * \brief The bounds within which DocumentBatchWriter tunes itself in adaptive mode
+ *
+ * Batches are sized by bytes rather than document count, so small and large documents both produce sensibly sized
+ * requests. Batch size grows while batches complete within targetBatchDuration and shrinks when they are slower.
+ * Concurrency increases additively after each round of healthy batches, and decreases multiplicatively on failures,
+ * 503 (service unavailable) responses, or when latency per byte rises well above the best observed (server queueing).
+ *
+ * \since 8.0.3
+ */
+struct AdaptiveBatchParameters {
+  AdaptiveBatchParameters() : minParallelTasks(1), maxParallelTasks(16), minBatchBytes(64 * 1024),
+      maxBatchBytes(16 * 1024 * 1024), maxBatchSize(1000), targetBatchDuration(2000) {
+    ;
+  }
+
+  int minParallelTasks;
+  int maxParallelTasks;
+  long minBatchBytes;
+  long maxBatchBytes;
+  long maxBatchSize; // maximum documents per batch, however small they are
+  long targetBatchDuration; // milliseconds
+};
+
+/**
+ * \brief How DocumentBatchWriter handles failed batches
+ *
+ * A batch that fails with a retryable status (408, 429, 502, 503 or 504) or a connection error (E.g. a timeout) is
+ * re-sent up to maxRetries times. Each wait doubles from initialBackoff up to maxBackoff, and a random half of it is
+ * jittered so that parallel tasks do not all retry at once.
+ *
+ * A batch the server rejects (E.g. 400 for malformed content), or that fails with any other exception (E.g. a file
+ * that cannot be read), will fail however often it is sent. If bisectFailures is true it is split in half and each
+ * half sent separately, recursively, until the bad documents are isolated and the rest are saved.
+ *
+ * Documents that finally fail are reported to IBatchNotifiable listeners as before, and if deadLetterFile is set
+ * appended to it, one JSON object per line, with their URI, position in the upload, status code, error, and the file
+ * name (for FileDocumentContent) or content (for JSON, XML and text content) so they can be fixed and re-sent.
+ *
+ * \since 8.0.3
+ */
+struct RetryParameters {
+  RetryParameters() : maxRetries(3), initialBackoff(500), maxBackoff(30000), bisectFailures(true), deadLetterFile() {
+    ;
+  }
+
+  int maxRetries; // 0 to never retry
+  long initialBackoff; // milliseconds
+  long maxBackoff; // milliseconds
+  bool bisectFailures;
+  std::string deadLetterFile; // empty for none
 };
 
 /**
@@ -81,6 +223,12 @@ public:
  */
 class DocumentBatchWriter {
 public:
+  /**
+   * \brief The period over which Progress::windowRate and Progress::windowMegabytesPerSecond are measured
+   * \since 8.0.3
+   */
+  static const int METRICS_WINDOW_SECONDS = 10;
+
   /**
    * \brief Constructs a DocumentBatchWriter that wraps the provided IConnection instance
    * \since 8.0.2
@@ -92,7 +240,7 @@ public:
    */
   MLCLIENT_API DocumentBatchWriter(const DocumentBatchWriter& other) = delete;
   /**
-   * \brief The destructor
+   * \brief The destructor. Stops the batch operation, and waits for any in flight batches to complete.
    */
   MLCLIENT_API ~DocumentBatchWriter();
 
@@ -107,22 +255,107 @@ public:
    */
   MLCLIENT_API void assignDocuments(DocumentSet&& set);
 
+  /**
+   * \brief Assigns a source of documents to upload, instead of a DocumentSet.
+   *
+   * Documents are pulled from the source a batch at a time as the upload proceeds, so the upload can begin before
+   * all documents are known, and memory use is bounded by the documents in flight rather than the total. Use
+   * BoundedDocumentQueue to feed documents in from producer threads, with backpressure.
+   *
+   * The writer has finished once the source is exhausted (next() returns false) and all batches have completed.
+   *
+   * \note Each pulled Document's content is deleted once its batch has been sent. Properties are not deleted, as they are
+   * commonly shared between documents.
+   *
+   * \since 8.0.3
+   *
+   * \param source The source to drain. In, but not OWNS. Must outlive the upload (E.g. until wait() returns).
+   */
+  MLCLIENT_API void assignSource(IDocumentSource* source);
+
   /**
    * \brief Sets the parameters for this batch
    *
    * \note Defaults to 5 parallel tasks, each holding 10 documents, with mode of PER_BATCH transactions.
    *
-   * \note parallelTasks performs a lot of work before the (thin) call to perform a REST request. Each Connection instance
-   * only ever executes one REST request at a time - never in parallel - so be aware of that when loading content. This
-   * restriction may be removed in future versions.
+   * \note parallelTasks is the maximum number of batches in flight at once. Each task takes the next unsent batch as soon
+   * as its previous batch completes, so slow (large) batches do not hold up the rest of the upload. Parameters changed
+   * after send() apply to the next writer only.
    *
    * \since 8.0.2
    *
    * \param parallelTasks The number of paralleltasks to use
    * \param batchSize The number of documents to submit in each batch (also submits their metadata)
    * \param mode The batch mode to use
+   * \param retry How to retry failed batches, and where to record documents that cannot be saved (since 8.0.3)
+   */
+  MLCLIENT_API void setBatchParameters(const int parallelTasks,const int batchSize,const TransactionMode& mode,
+      const RetryParameters& retry = RetryParameters());
+  /**
+   * \brief Enables adaptive mode, where batch size and the number of batches in flight are tuned during the upload
+   *
+   * Use this when the best settings are not known in advance (E.g. they vary with document size or server load). The
+   * current settings are reported in getProgress(). Calling setBatchParameters disables adaptive mode.
+   *
+   * \since 8.0.3
+   *
+   * \param params The bounds to tune within
+   * \param mode The batch mode to use
+   * \param retry How to retry failed batches, and where to record documents that cannot be saved
+   */
+  MLCLIENT_API void setAdaptiveBatchParameters(const AdaptiveBatchParameters& params,const TransactionMode& mode,
+      const RetryParameters& retry = RetryParameters());
+  /**
+   * \brief Records the outcome of every batch in an append only journal file, so an interrupted upload can be resumed
+   *
+   * Call before send(). Each completed batch appends one line: OK or FAIL, the positions in the upload of its first and
+   * last documents, and its URIs (tab separated). Documents skipped as unchanged or already committed are not sent, so
+   * a batch's positions need not be consecutive - its URIs are the documents it contained. Lines are flushed as they
+   * are written, so a crash loses at most the batches in flight.
+   *
+   * To resume, run the same upload again with the same journal file and resume set to true. Documents recorded as
+   * committed are skipped (counted in Progress::skipped) and all others, including those in failed batches, are sent.
+   * Documents are matched by URI, so this works for DocumentSet and IDocumentSource uploads alike, whatever order the
+   * documents arrive in.
+   *
+   * \since 8.0.3
+   *
+   * \param journalFile The journal file path
+   * \param resume If true, skip documents the existing journal shows as committed, and append to it. If false, start a
+   * new journal, replacing any existing file.
+   * \return Whether the journal file could be opened
+   */
+  MLCLIENT_API bool setJournal(const std::string& journalFile,const bool resume = true);
+  /**
+   * \brief Enables incremental sync. Only documents changed since the last upload using the same manifest file are sent.
+   *
+   * Call before send(). The manifest records each URI's size, modification time (for FileDocumentContent) and hashes of
+   * its content and metadata (collections, permissions and properties) as last saved. A document is skipped (counted in
+   * Progress::skipped) if these are unchanged. Files whose size and modification time are unchanged are not read at all,
+   * so re-running over a large, mostly unchanged tree costs time in proportion to the changes.
+   *
+   * If deleteMissing is true, once all documents have been sent, documents in the manifest that were not in this upload
+   * are deleted from the server (counted in Progress::deleted). This is skipped if the upload is stopped, or if the
+   * source reports that it could not enumerate everything (IDocumentSource::getFailureCount(), E.g. a folder
+   * DirectoryDocumentSource could not read). Only use this where each upload contains the whole of the content the
+   * manifest describes.
+   *
+   * The manifest is saved when the upload completes. Documents in failed batches are sent again next time.
+   *
+   * \since 8.0.3
+   *
+   * \param manifestFile The manifest file path. If it does not exist, every document is sent, and it is created.
+   * \param deleteMissing Whether to delete documents no longer in the upload. Off by default.
+   * \return Whether the manifest could be read
+   */
+  MLCLIENT_API bool setSyncManifest(const std::string& manifestFile,const bool deleteMissing = false);
+
+  /**
+   * \brief Returns whether adaptive mode is enabled
+   *
+   * \since 8.0.3
    */
-  MLCLIENT_API void setBatchParameters(const int parallelTasks,const int batchSize,const TransactionMode& mode);
+  MLCLIENT_API const bool isAdaptive() const;
   /**
    * \brief Returns the number of parallel tasks being used
    *
@@ -141,6 +374,14 @@ public:
    * \return The TransactionMode in use
    */
   MLCLIENT_API const TransactionMode getMode() const;
+  /**
+   * \brief Returns how failed batches are retried
+   *
+   * \since 8.0.3
+   *
+   * \return The RetryParameters in use
+   */
+  MLCLIENT_API const RetryParameters& getRetryParameters() const;
 
   /**
    * \brief Adds a listener for batch events
@@ -158,13 +399,15 @@ public:
   /**
    * \brief Begins the batch operation
    *
-   * \note This is where the underlying tasks are created and allocated to threads
+   * \note This is where the underlying tasks are created. A task holds no thread whilst waiting for a response, a retry
+   * backoff or (in adaptive mode) its turn to send.
    */
   MLCLIENT_API void send();
   /**
    * \brief Cancels the batch operation
    *
-   * \note Some tasks may be in flight still when this is called. They still run to completion.
+   * \note No further batches are sent once this is called. Batches already in flight still run to completion, so call
+   * wait() if you need to know when all work has stopped. The destructor stops and waits automatically.
    */
   MLCLIENT_API void stop();
 
@@ -175,6 +418,17 @@ public:
    */
   MLCLIENT_API void wait() const;
 
+#ifndef SWIG
+  /**
+   * \brief Begins the batch operation, as send(), returning a task that completes once all batches have been processed
+   *
+   * Allows batch submission to be chained or co_await'ed (See Awaitable.hpp) rather than blocking in wait().
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API pplx::task<void> sendAsync();
+#endif
+
   /**
    * \brief Has this class ran to completion?
    *
@@ -200,7 +454,7 @@ public:
   /**
    * \brief Returns the current progress data for this class
    *
-   * \note This is currently an Overall progress, not for the last X seconds.
+   * \note Whilst sending, this is recalculated on each call, so the windowed figures fall even if no batch completes.
    *
    * \return The current Progress of the batch upload.
    */
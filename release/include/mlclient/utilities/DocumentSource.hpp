@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * \file DocumentSource.hpp
+ *
+ * \date 16 Oct 2026
+ */
+
+#ifndef INCLUDE_MLCLIENT_UTILITIES_DOCUMENTSOURCE_HPP_
+#define INCLUDE_MLCLIENT_UTILITIES_DOCUMENTSOURCE_HPP_
+
+#include <mlclient/Document.hpp>
+#include <mlclient/mlclient.hpp>
+
+#include <memory>
+
+namespace mlclient {
+
+namespace utilities {
+
+/**
+ * \brief A pull based source of Documents, drained by DocumentBatchWriter as it uploads.
+ *
+ * Allows uploads of more documents than would fit in memory in a DocumentSet, and for uploading to begin before
+ * all documents are known. Implement this to generate documents on demand, or use BoundedDocumentQueue to have
+ * one or more producer threads feed documents in.
+ *
+ * \note next() may be called from several threads, but never concurrently - DocumentBatchWriter serialises calls.
+ *
+ * \note Can be subclassed directly in other wrappers (E.g. C#)
+ *
+ * \since 8.0.3
+ */
+class IDocumentSource {
+public:
+  MLCLIENT_API virtual ~IDocumentSource();
+
+  /**
+   * \brief Provides the next Document to upload, blocking until one is available if necessary
+   *
+   * \note The caller takes ownership of out's content (Document::getContent()), and deletes it once it is no longer
+   * needed (DocumentBatchWriter does so once the document's batch has been sent). A source must therefore give each
+   * Document its own content instance, and must not use or delete it after returning it. Properties are not owned by
+   * the caller, as they are commonly shared between documents.
+   *
+   * \param out The Document to populate. Its content becomes OWNED by the caller.
+   * \return true if out was populated, false if there are no more documents (the source is exhausted)
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual bool next(Document& out) = 0;
+
+  /**
+   * \brief Called when the consumer stops early (E.g. DocumentBatchWriter::stop()). Any call blocked in next() must
+   * return promptly. The default implementation does nothing.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual void cancel();
+
+  /**
+   * \brief Returns the number of items (E.g. folders) the source failed to enumerate, so whose documents next() may
+   * not have provided. The default implementation returns 0.
+   *
+   * A non zero count means the documents provided are not the complete set, so DocumentBatchWriter will not delete
+   * documents missing from a sync upload.
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API virtual const long getFailureCount() const;
+};
+
+/**
+ * \brief A thread safe, fixed capacity queue of Documents, for producers to feed whilst DocumentBatchWriter drains it
+ *
+ * push() blocks whilst the queue is full, so producers can never get more than capacity documents ahead of the
+ * upload (backpressure), keeping memory use bounded however many documents there are in total.
+ *
+ * Producers must call close() once they have pushed their last document, so the writer knows when it has finished.
+ *
+ * See the cppproducer and cppbatchupload samples for example usage.
+ *
+ * \since 8.0.3
+ */
+class BoundedDocumentQueue : public IDocumentSource {
+public:
+  /**
+   * \brief Creates a queue holding at most capacity documents (minimum 1)
+   */
+  MLCLIENT_API BoundedDocumentQueue(const long capacity = 1000);
+  /**
+   * \brief The DELETED copy constructor
+   */
+  MLCLIENT_API BoundedDocumentQueue(const BoundedDocumentQueue& other) = delete;
+  MLCLIENT_API ~BoundedDocumentQueue();
+
+  /**
+   * \brief Adds a document to the queue, blocking whilst the queue is full
+   *
+   * \param doc The Document to add. Moved in. The queue takes ownership of its content, which passes on to the caller
+   * of next() that receives it.
+   * \return true if added, false if the queue has been closed or cancelled (the document is discarded, and its
+   * content deleted)
+   */
+  MLCLIENT_API bool push(Document&& doc);
+
+  /**
+   * \brief Signals that no more documents will be pushed. Documents already queued are still provided by next().
+   */
+  MLCLIENT_API void close();
+
+  /**
+   * \brief Returns whether close() or cancel() has been called
+   */
+  MLCLIENT_API const bool isClosed() const;
+
+  /**
+   * \brief Returns the number of documents currently queued
+   */
+  MLCLIENT_API const long size() const;
+
+  /**
+   * \brief Returns the maximum number of documents that may be queued
+   */
+  MLCLIENT_API const long getCapacity() const;
+
+  MLCLIENT_API bool next(Document& out) override;
+
+  /**
+   * \brief Discards all queued documents (deleting their content) and wakes any blocked producers (whose push() then
+   * returns false) and consumers
+   */
+  MLCLIENT_API void cancel() override;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> mImpl;
+};
+
+} // end namespace utilities
+
+} // end namespace mlclient
+
+#endif /* INCLUDE_MLCLIENT_UTILITIES_DOCUMENTSOURCE_HPP_ */
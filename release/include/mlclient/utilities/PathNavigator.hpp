@@ -52,7 +52,7 @@ public:
      *
      * \param node The top level IDocumentNavigator within which to apply the path
      * \param path The path to apply to the IDocumentNavigator
-     * \return The IDocumentNode at the end of the path. 
+     * \return The IDocumentNode at the end of the path. Owned by the navigator - do not delete it.
      * \throws InvalidFormatException if the node does not exist
      */
     MLCLIENT_API static IDocumentNode* navigate(const IDocumentNavigator* nav,const std::string& path);
@@ -67,7 +67,7 @@ public:
      *
      * \param node The current level node within which to apply the subpath
      * \param subpath The subpath to apply to the IDocumentNode
-     * \return The IDocumentNode at the end of the subpath. 
+     * \return The IDocumentNode at the end of the subpath. Owned by the same navigator (or node) as node is.
      * \throws InvalidFormatException if the node does not exist
      */
     MLCLIENT_API static IDocumentNode* at(const IDocumentNode* node,const std::string& subpath);
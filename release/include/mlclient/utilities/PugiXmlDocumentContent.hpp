@@ -27,6 +27,10 @@
 
 namespace mlclient {
 
+namespace internals {
+class NodeArena; // forward declaration
+}
+
 namespace utilities {
 
 /**
@@ -64,6 +68,12 @@ public:
 class PugiXmlArrayNode : public PugiXmlContainerNode {
 public:
   MLCLIENT_API PugiXmlArrayNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API PugiXmlArrayNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key);
   MLCLIENT_API virtual ~PugiXmlArrayNode();
 
   MLCLIENT_API bool isArray() const override;
@@ -93,6 +103,12 @@ private:
 class PugiXmlObjectNode : public PugiXmlContainerNode {
 public:
   MLCLIENT_API PugiXmlObjectNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& root);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API PugiXmlObjectNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& root);
   MLCLIENT_API virtual ~PugiXmlObjectNode();
 
   MLCLIENT_API bool isArray() const override;
@@ -117,6 +133,12 @@ private:
 class PugiXmlAttributeNode : public PugiXmlContainerNode {
   public:
   MLCLIENT_API PugiXmlAttributeNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API PugiXmlAttributeNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr);
   MLCLIENT_API virtual ~PugiXmlAttributeNode();
 
   MLCLIENT_API bool isNull() const override;
@@ -159,6 +181,12 @@ class PugiXmlAttributeNode : public PugiXmlContainerNode {
 class PugiXmlDocumentNode : public IDocumentNode {
 public:
   MLCLIENT_API PugiXmlDocumentNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& result);
+  /**
+   * \brief Creates a node within a navigator's arena, which owns it and the nodes reached from it
+   *
+   * \since 8.0.3
+   */
+  MLCLIENT_API PugiXmlDocumentNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& result);
   MLCLIENT_API PugiXmlDocumentNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& root,const std::string& key);
   MLCLIENT_API PugiXmlDocumentNode(PugiXmlDocumentNode&& from);
   MLCLIENT_API virtual ~PugiXmlDocumentNode();
@@ -208,6 +236,8 @@ IDocumentNode* createNode(std::shared_ptr<pugi::xml_document> doc,pugi::xml_node
  * \date 2016-07-30
  *
  * \brief Provides a navigator interface over a PugiXmlDocumentContent's root pugi::xml_document instance.
+ *
+ * All nodes reached from this navigator are made in its arena, and are deleted along with it (since 8.0.3).
  */
 class PugiXmlDocumentNavigator : public IDocumentNavigator {
 public:
@@ -60,8 +60,9 @@ int main(int argc, const char * argv[])
   if (argc < 3) {
     std::cout << "Must specify the root load folder as first parameter" << std::endl;
     std::cout << "Must specify the collection as second parameter" << std::endl;
-    std::cout << "Usage: " << argv[0] << " <folder> <collection>" << std::endl;
-    std::cout << "Example Usage: " << argv[0] << " ./some/folder mydocs" << std::endl;
+    std::cout << "Optionally specify a sync manifest file as third parameter, to only upload changes" << std::endl;
+    std::cout << "Usage: " << argv[0] << " <folder> <collection> [manifest]" << std::endl;
+    std::cout << "Example Usage: " << argv[0] << " ./some/folder mydocs ./mydocs.manifest" << std::endl;
     return 1;
   }
 
@@ -73,35 +74,49 @@ int main(int argc, const char * argv[])
 
   DocumentBatchWriter writer(ml);
   writer.addBatchListener(&obs);
+  // Retry overloaded server responses, and record any documents that cannot be saved
+  RetryParameters retry;
+  retry.deadLetterFile = "batchupload-failed.ndjson";
+  writer.setBatchParameters(5,10,TransactionMode::PER_BATCH,retry);
   std::vector<std::string> collections;
   collections.emplace_back(argv[2]);
   std::vector<Permission> perms;
   perms.emplace_back("admin",Capability::EXECUTE); // good test as this isn't normally default assigned
 
-  DocumentSet set;
-
-  DocumentBatchHelper::addFilesToDocumentSet(argv[1],argv[1],true,"/cppbatchupload/",
-      collections,perms,nullptr,set);
-
-  LOG(DEBUG) << "DocumentBatchWriterTest: set size: " << set.size();
-
-  long setSize = set.size(); // set is reassigned by the next line, move!
-
-  writer.assignDocuments(std::move(set));
-
+  // Upload whilst the folder is still being listed, rather than listing it all first
+  DirectoryDocumentSource source(argv[1],argv[1],true,"/cppbatchupload/",collections,perms,nullptr);
+  writer.assignSource(&source);
+  if (argc > 3) {
+    // only send changed files, and (opting in, as it is off by default) delete documents whose files have gone
+    if (!writer.setSyncManifest(argv[3],true)) {
+      std::cout << "Could not read sync manifest: " << argv[3] << std::endl;
+      return 1;
+    }
+  }
   writer.send();
 
   // now just wait for it to finish...
 
   writer.wait();
 
+  std::cout << "Files found: " << source.getFilesFound() << " in " << source.getFoldersRead() << " folders" << std::endl;
+  if (0 != source.getFoldersFailed()) {
+    std::cout << "WARNING: " << source.getFoldersFailed() << " folders could not be read, so their files were not uploaded:-" << std::endl;
+    for (auto& folder : source.getFailedFolders()) {
+      std::cout << "  " << folder << std::endl;
+    }
+  }
+
   //std::cout << "Exception is nullptr?: " << (nullptr == obs.ex) << std::endl;
 
   Progress p = writer.getProgress();
-  std::cout << "Document set size: " << setSize << ", complete size: " << p.completed << std::endl;
   std::cout << "Progress: Complete: " << p.completed << ", total: " << p.total << ", pct: " << p.percentageComplete << std::endl;
   std::cout << "Progress: duration: " << p.duration << ", est remaining duration: " << p.durationEstimateRemaining << std::endl;
   std::cout << "Progress: overall rate: " << p.rate << std::endl;
+  std::cout << "Progress: unchanged: " << p.skipped << ", deleted: " << p.deleted << ", failed: " << p.failed << std::endl;
+  std::cout << "Progress: retries: " << p.retries << std::endl;
+  std::cout << "Progress: latency ms p50: " << p.latencyP50 << ", p95: " << p.latencyP95 << ", p99: " << p.latencyP99 <<
+      ", MB sent: " << (p.bytesSent / (1024 * 1024)) << std::endl;
 
   std::cout << "batch upload complete" << std::endl;
   return 0;
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  coroutine.cpp
+ *  Created on 16 Oct 2026.
+ *
+ *  Performs a search with co_await, then fetches the next few pages of results concurrently and awaits them all.
+ *  Requires a C++20 compiler - the library itself remains C++11.
+ */
+
+#include "ConnectionFactory.hpp"
+
+#include <mlclient/utilities/Awaitable.hpp>
+
+#include <mlclient/Connection.hpp>
+#include <mlclient/Response.hpp>
+#include <mlclient/SearchDescription.hpp>
+#include <mlclient/logging.hpp>
+
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if !defined(__cpp_impl_coroutine)
+#error "This sample must be compiled with C++20 coroutine support (E.g. -std=c++20)"
+#endif
+
+using namespace mlclient;
+using namespace mlclient::utilities;
+
+/*
+ * The simplest coroutine type - runs eagerly, and reports completion through a std::promise
+ */
+struct Job {
+  struct promise_type {
+    Job get_return_object() {
+      return Job();
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() {
+      ;
+    }
+    void unhandled_exception() {
+      std::terminate(); // searchPages catches everything itself
+    }
+  };
+};
+
+Job searchPages(IConnection* ml,std::string query,long pages,std::promise<long>& done) {
+  try {
+    SearchDescription first;
+    first.setQueryText(query);
+    std::shared_ptr<Response> resp = co_await awaitable(ml->searchAsync(first));
+    std::cout << "First page response code: " << resp->getResponseCode() << std::endl;
+
+    // fan out the remaining pages, then fan in
+    std::vector<SearchDescription> descs(pages - 1);
+    std::vector<ResponseTask> tasks;
+    for (long p = 1;p < pages;p++) {
+      SearchDescription& desc = descs[p - 1];
+      desc.setQueryText(query);
+      desc.setStart(1 + p * 10);
+      tasks.push_back(ml->searchAsync(desc));
+    }
+    long bytes = resp->getContentLength();
+    if (!tasks.empty()) {
+      std::vector<std::shared_ptr<Response>> rest = co_await awaitable(pplx::when_all(tasks.begin(),tasks.end()));
+      for (auto& page : rest) {
+        bytes += page->getContentLength();
+      }
+    }
+    done.set_value(bytes);
+  } catch (...) {
+    done.set_exception(std::current_exception());
+  }
+}
+
+int main(int argc, const char * argv[])
+{
+  mlclient::reconfigureLogging(argc,argv);
+
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <querytext> [pages (default 3)]" << std::endl;
+    return 1;
+  }
+  const long pages = (argc > 2) ? std::atol(argv[2]) : 3;
+
+  IConnection* ml = ConnectionFactory::getConnection();
+  std::promise<long> done;
+  std::future<long> result = done.get_future();
+  searchPages(ml,argv[1],pages < 1 ? 1 : pages,done);
+  try {
+    std::cout << "Fetched " << result.get() << " bytes of search results" << std::endl;
+  } catch (std::exception& ex) {
+    std::cout << "Search failed: " << ex.what() << std::endl;
+  }
+  delete ml;
+  return 0;
+}
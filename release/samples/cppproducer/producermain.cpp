@@ -1,158 +1,105 @@
-
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  producermain.cpp
+ *
+ *  Shows a producer thread generating documents into a BoundedDocumentQueue whilst a DocumentBatchWriter uploads
+ *  them. The producer is held back (backpressure) whenever it gets a full queue ahead of the upload, so memory use
+ *  stays flat however many documents are generated.
+ */
+
+#include "ConnectionFactory.hpp"
+
+#include <mlclient/utilities/DocumentBatchWriter.hpp>
+#include <mlclient/utilities/DocumentSource.hpp>
+
+#include <mlclient/Connection.hpp>
+#include <mlclient/Document.hpp>
+#include <mlclient/DocumentContent.hpp>
 #include <mlclient/logging.hpp>
 
-
 #include <cpprest/http_client.h>
-#include <array>
+#include <chrono>
 #include <iostream>
-
-
-class ResultsHolder {
-public:
-  ResultsHolder() : total(-1), lastFetched(0), results() {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    ;
-  };
-
-  void setResult(int idx,int value) {
-    //TIMED_FUNC(ResultsHolder_setResult);
-    results[idx] = value;
-  };
-  void incrementLastFetched(int by) {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    lastFetched += by;
-  };
-  int getResult(int idx) {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    return results[idx];
-  };
-  int getTotal() {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    return total;
-  };
-  void setTotal(int t) {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    total = t;
-  };
-  int getLastFetched() {
-    //TIMED_FUNC(ResultsHolder_ResultsHolder);
-    return lastFetched;
-  };
-
-private:
-  int total; // not fetched results yet
-  int lastFetched;
-  std::array<int,100000> results;
-};
-
-
-
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
 
 int main(int argc, const char * argv[])
 {
+  using namespace mlclient;
+  using namespace mlclient::utilities;
 
   mlclient::reconfigureLogging(argc,argv);
 
-  std::cout << "In Main Func" << std::endl;
-  //std::cout << "Easy logging started" << std::endl;
-/*
-  el::Configurations defaultConf;
-  defaultConf.setToDefault();
-  // Values are always std::string
-  defaultConf.setGlobally(el::ConfigurationType::Format, "%datetime %level %fbase:%line %msg");
-  //defaultConf.setGlobally(el::ConfigurationType::ToStandardOutput, "false");
-  // default logger uses default configurations
-  el::Loggers::reconfigureLogger("default", defaultConf);
-  std::cout << "default logger configured" << std::endl;
-
-  el::Configurations performanceConf;
-  performanceConf.setToDefault();
-  performanceConf.set(el::Level::Info, el::ConfigurationType::Format, "%msg");
-  performanceConf.set(el::Level::Info,el::ConfigurationType::Filename,"../performance.log"); /// TODO make output file include version number of this upcoming release
-  //performanceConf.set(el::Level::Info,el::ConfigurationType::MillisecondsWidth,"6");
-  el::Loggers::reconfigureLogger("performance", performanceConf);
-  el::Loggers::addFlag(el::LoggingFlag::FixedTimeFormat); // ensures performance numbers are always quoted as seconds, never formatted
-*/
-  //std::cout << "perf logger configured" << std::endl;
-
-  //el::Logger* logger = el::Loggers::getLogger("cppproducer");
-
-  //std::cout << "Running producer..." << std::endl;
-
-  ResultsHolder rh;
-
-  //std::cout << "Creating initial results task" << std::endl;
-  pplx::task<void> runningTask([&rh] () {
-/*
-    for (int j = 0;j < 100000000;j++) {
-      float k = j * 47 / 0.33;
-    }
-*/
-    for (int i3 = 0;i3 <= 9;i3++) {
-      //std::cout << "initial populating: " << i3 << std::endl;
-      LOG(DEBUG) << "initial populating...";
-      rh.setResult(i3,i3 * i3);
+  LOG(DEBUG) << "Running producer...";
+  if (argc < 3) {
+    std::cout << "Must specify the number of documents to generate as first parameter" << std::endl;
+    std::cout << "Must specify the collection as second parameter" << std::endl;
+    std::cout << "Usage: " << argv[0] << " <count> <collection>" << std::endl;
+    std::cout << "Example Usage: " << argv[0] << " 100000 mydocs" << std::endl;
+    return 1;
+  }
+  const long count = std::atol(argv[1]);
+  const std::string collection(argv[2]);
+
+  IConnection* ml = ConnectionFactory::getConnection();
+
+  BoundedDocumentQueue queue(1000); // at most 1000 documents held waiting for upload
+
+  DocumentBatchWriter writer(ml);
+  writer.setBatchParameters(4,100,TransactionMode::PER_BATCH);
+  writer.assignSource(&queue);
+  writer.send(); // starts draining the queue straight away
+
+  pplx::task<void> producer([&queue,count,collection] () {
+    std::vector<std::string> collections;
+    collections.push_back(collection);
+    for (long i = 0;i < count;i++) {
+      std::ostringstream json;
+      json << "{\"id\": " << i << ", \"square\": " << (i * i) << "}";
+      GenericTextDocumentContent* content = new GenericTextDocumentContent;
+      content->setContent(json.str());
+      content->setMimeType(IDocumentContent::MIME_JSON);
+
+      std::ostringstream uri;
+      uri << "/cppproducer/" << i << ".json";
+      Document doc(uri.str(),content);
+      doc.setCollections(collections);
+      if (!queue.push(std::move(doc))) { // blocks whilst the queue is full
+        std::cout << "Upload stopped. Producer exiting early at document: " << i << std::endl;
+        return;
+      }
     }
-    rh.incrementLastFetched(9);
-    rh.setTotal(100000);
+    queue.close(); // no more documents - the writer finishes once the queue drains
   });
 
-
-  if (-1 == rh.getTotal()) {
-    LOG(DEBUG) << "Waiting for initial population";
-    //std::cout << "No results fetched yet. Waiting for initial results task." << std::endl;
-    runningTask.wait();
+  // report progress whilst both sides run
+  while (!writer.isComplete()) {
+    Progress p = writer.getProgress();
+    std::cout << "Uploaded: " << p.completed << ", queued: " << queue.size() << ", rate: " << p.rate << "/s" << std::endl;
+    std::this_thread::sleep_for(std::chrono::seconds(1));
   }
 
+  producer.wait();
+  writer.wait();
 
-  for (int i = 0;i < rh.getTotal();i++) {
-    if (i > rh.getLastFetched()) {
-      LOG(DEBUG) << "Waiting for result last page runningTask: " << i;
-      std::cout << "Waiting for result: " << i << std::endl;
-      runningTask.wait();
-    }
-    //std::cout << "Result at index: " << i << " is: " << rh.getResult(i) << std::endl;
-    LOG(DEBUG) << "Result at index: " << i  << " is: " << rh.getResult(i);
-    std::cout << "Result at index: " << i  << " is: " << rh.getResult(i) << std::endl;
-    // now check to see if we need to continue the task
-    if (runningTask.is_done() && i > rh.getLastFetched() - 10 && rh.getLastFetched() < rh.getTotal()) {
-      //std::cout << "Scheduling the next fetch task (fire and forget)" << std::endl;
-      runningTask = pplx::task<void>([&rh] () {
-
-        for (int j = 0;j < 100000;j++) {
-          float k = j * 47 / 0.33;
-        }
-
-        int max = rh.getLastFetched() + 10;
-        // make sure we don't overflow the array
-        if (max > rh.getTotal() - 1) {
-          max = rh.getTotal() - 1;
-        }
-        for (int i2 = rh.getLastFetched() + 1;i2 <= max;i2++) {
-          LOG(DEBUG) << "second task populating: " << i2;
-          std::cout << "second task populating: " << i2 << std::endl;
-          rh.setResult(i2,i2 * i2);
-        }
-        rh.incrementLastFetched(10);
-        std::cout << "Just finished fetching results up to: " << rh.getLastFetched() << std::endl;
-        LOG(DEBUG) << "Just finished fetching results up to: " << rh.getLastFetched();
-      });
-    }
-
-    // now add our own thread delay, increasing as we process more of the result set (so we see both sides of the performance curve)
-    // At start of test - we see main thread wait for initial results
-    // Toward start of test - we see main thread wait for second page
-    // Toward end of test - we see fetching thread keeps almost 2 pages ahead of processing thread
-
-
-    for (int j = 0;j < 100 * i ;j++) {
-      float k = j * 47 / 0.33;
-    }
-
-  }
-
-  std::cout << "Completing main thread" << std::endl;
-  LOG(DEBUG) << "Completing main thread";
+  Progress p = writer.getProgress();
+  std::cout << "Progress: Complete: " << p.completed << ", total: " << p.total << ", pct: " << p.percentageComplete << std::endl;
+  std::cout << "Progress: duration: " << p.duration << ", overall rate: " << p.rate << std::endl;
 
+  std::cout << "producer upload complete" << std::endl;
   return 0;
 }
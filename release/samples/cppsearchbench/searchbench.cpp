@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  searchbench.cpp
+ *  Created on 16 Oct 2026.
+ *
+ *  Measures how many search results per second can be parsed from /v1/search response pages, both by walking the
+ *  response with IDocumentNavigator (as SearchResultSet did prior to 8.0.3) and with the single pass
+ *  SearchResponseDecoder that SearchResultSet now uses. No server is needed - pages are generated in memory.
+ */
+
+#include <mlclient/internals/SearchResponseDecoder.hpp>
+
+#include <mlclient/utilities/CppRestJsonDocumentContent.hpp>
+#include <mlclient/utilities/CppRestJsonHelper.hpp>
+#include <mlclient/utilities/PugiXmlDocumentContent.hpp>
+#include <mlclient/utilities/PugiXmlHelper.hpp>
+
+#include <mlclient/DocumentContent.hpp>
+#include <mlclient/Response.hpp>
+#include <mlclient/SearchResult.hpp>
+#include <mlclient/logging.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace mlclient;
+
+/*
+ * Generates a page of results, as MarkLogic would return them for the snippet format
+ */
+std::string generatePage(const bool xml,const bool raw,const long rows) {
+  std::ostringstream os;
+  if (xml) {
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<search:response snippet-format=\"" << (raw ? "raw" : "snippet")
+       << "\" total=\"1000000\" start=\"1\" page-length=\"" << rows
+       << "\" selected=\"include\" xmlns:search=\"http://marklogic.com/appservices/search\">\n";
+    for (long i = 1;i <= rows;i++) {
+      os << "<search:result index=\"" << i << "\" uri=\"/claims/claim-" << i << ".xml\" path=\"fn:doc(&quot;/claims/claim-"
+         << i << ".xml&quot;)\" score=\"" << (i * 7) << "\" confidence=\"0.4183" << i << "\" fitness=\"0.5094" << i
+         << "\" href=\"/v1/documents?uri=%2Fclaims%2Fclaim-" << i << ".xml\" mimetype=\"application/xml\" format=\"xml\">";
+      if (raw) {
+        os << "<search:content><claim><id>" << i << "</id><patient-ssn>406-36-4065</patient-ssn><amount>" << (i * 13)
+           << ".50</amount><notes>Routine check up &amp; follow up</notes></claim></search:content>";
+      } else {
+        os << "<search:snippet><search:match path=\"fn:doc(&quot;/claims/claim-" << i
+           << ".xml&quot;)/claim/notes\">Routine <search:highlight>check</search:highlight> up</search:match>"
+           << "</search:snippet>";
+      }
+      os << "</search:result>\n";
+    }
+    os << "<search:metrics><search:query-resolution-time>PT0.002S</search:query-resolution-time>"
+       << "<search:snippet-resolution-time>PT0.004S</search:snippet-resolution-time>"
+       << "<search:total-time>PT0.01S</search:total-time></search:metrics>\n</search:response>";
+  } else {
+    os << "{\"snippet-format\":\"" << (raw ? "raw" : "snippet") << "\",\"total\":1000000,\"start\":1,\"page-length\":"
+       << rows << ",\"selected\":\"include\",\"results\":[";
+    for (long i = 1;i <= rows;i++) {
+      os << (1 == i ? "" : ",") << "{\"index\":" << i << ",\"uri\":\"/claims/claim-" << i
+         << ".json\",\"path\":\"fn:doc(\\\"/claims/claim-" << i << ".json\\\")\",\"score\":" << (i * 7)
+         << ",\"confidence\":0.4183" << i << ",\"fitness\":0.5094" << i << ",\"href\":\"/v1/documents?uri=%2Fclaims%2Fclaim-"
+         << i << ".json\",\"mimetype\":\"application/json\",\"format\":\"json\",";
+      if (raw) {
+        os << "\"content\":{\"claim\":{\"id\":" << i << ",\"patient-ssn\":\"406-36-4065\",\"amount\":" << (i * 13)
+           << ".5,\"notes\":\"Routine check up & follow up\"}}}";
+      } else {
+        os << "\"matches\":[{\"path\":\"fn:doc(\\\"/claims/claim-" << i
+           << ".json\\\")/claim/notes\",\"match-text\":[\"Routine \",{\"highlight\":\"check\"},\" up\"]}]}";
+      }
+    }
+    os << "],\"qtext\":\"\",\"metrics\":{\"query-resolution-time\":\"PT0.002S\","
+       << "\"snippet-resolution-time\":\"PT0.004S\",\"total-time\":\"PT0.01S\"}}";
+  }
+  return os.str();
+}
+
+Format toFormat(const std::string& format) {
+  return ("json" == format) ? Format::JSON : (("xml" == format) ? Format::XML : Format::NONE);
+}
+
+/*
+ * The navigator walk performed by SearchResultSet prior to 8.0.3 (less its logging)
+ */
+long parseWithNavigator(const Response& resp,const bool raw,std::vector<SearchResult*>& results) {
+  std::shared_ptr<ITextDocumentContent> respDoc((ResponseType::XML == resp.getResponseType()) ?
+      mlclient::utilities::PugiXmlHelper::toDocument(resp) : mlclient::utilities::CppRestJsonHelper::toDocument(resp));
+  // the navigator owns every node reached from it, so the content shares it (and it the document)
+  std::shared_ptr<IDocumentNavigator> nav(respDoc->navigate(true),[respDoc] (IDocumentNavigator* n) {
+    delete n;
+  });
+
+  // the summary, which SearchResultSet reads before the results
+  nav->at("snippet-format")->asString();
+  nav->at("total")->asInteger();
+  nav->at("page-length")->asInteger();
+  try {
+    nav->at("search:metrics")->at("search:total-time")->asString();
+  } catch (std::exception&) {
+    // no metrics
+  }
+  IDocumentNode* res = nav->has("search:result") ? nav->at("search:result") : nav->at("search:results");
+  const int arrayLength = res->size();
+  for (int i = 0;i < arrayLength;i++) {
+    IDocumentNode* row = res->at(i);
+    std::shared_ptr<IDocumentNode> content;
+    SearchResult::Detail detail = SearchResult::Detail::NONE;
+    try {
+      content = std::shared_ptr<IDocumentNode>(nav,row->at(raw ? "search:content" : "search:matches")->asObject());
+      detail = raw ? detail : SearchResult::Detail::SNIPPETS;
+    } catch (std::exception&) {
+      detail = SearchResult::Detail::CONTENT;
+    }
+    results.push_back(new SearchResult(row->at("index")->asInteger(),row->at("uri")->asString(),
+        row->at("path")->asString(),row->at("score")->asInteger(),row->at("confidence")->asDouble(),
+        row->at("fitness")->asDouble(),detail,content,row->at("mimetype")->asString(),
+        toFormat(row->at("format")->asString())));
+  }
+  return arrayLength;
+}
+
+/*
+ * The single pass decode performed by SearchResultSet since 8.0.3. Content is parsed as the raw content's value only.
+ */
+long parseWithDecoder(const Response& resp,const bool raw,std::vector<SearchResult*>& results) {
+  const bool isXml = (ResponseType::XML == resp.getResponseType());
+  mlclient::internals::SearchResponseDecoder decoder;
+  auto handler = [&results,raw,isXml] (const mlclient::internals::SearchResponseDecoder::Row& row) {
+    std::shared_ptr<IDocumentNode> content;
+    SearchResult::Detail detail = raw ? SearchResult::Detail::NONE : SearchResult::Detail::CONTENT;
+    if (raw && !row.content.empty()) {
+      if (isXml) {
+        std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+        doc->load_buffer(row.content.data,row.content.length);
+        content.reset(new mlclient::utilities::PugiXmlObjectNode(doc,doc->document_element()));
+      } else {
+        std::shared_ptr<web::json::value> value = std::make_shared<web::json::value>(
+            mlclient::utilities::CppRestJsonHelper::fromString(std::string(row.content.data,row.content.length)));
+        content = std::shared_ptr<IDocumentNode>(new mlclient::utilities::CppRestJsonObjectNode(value->as_object()),
+            [value] (IDocumentNode* n) { delete n; });
+      }
+    }
+    results.push_back(new SearchResult(row.index,row.uri,row.path,row.score,row.confidence,row.fitness,detail,content,
+        row.mimeType,toFormat(row.format)));
+  };
+  const bool ok = isXml ? decoder.decodeXml(resp.getContentData(),resp.getContentLength(),handler) :
+      decoder.decodeJson(resp.getContentData(),resp.getContentLength(),handler);
+  if (!ok) {
+    std::cout << "  Decode failed: " << decoder.getError() << std::endl;
+  }
+  return (long)results.size();
+}
+
+typedef long (*Parser)(const Response& resp,const bool raw,std::vector<SearchResult*>& results);
+
+/*
+ * Returns the rows parsed per second
+ */
+double run(Parser parser,const Response& resp,const bool raw,const long pages) {
+  long rows = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (long p = 0;p < pages;p++) {
+    std::vector<SearchResult*> results;
+    rows += parser(resp,raw,results);
+    for (auto& res : results) {
+      delete res;
+    }
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return (elapsed.count() > 0) ? rows / elapsed.count() : 0;
+}
+
+int main(int argc, const char * argv[])
+{
+  mlclient::reconfigureLogging(argc,argv);
+
+  const long rows = (argc > 1) ? std::atol(argv[1]) : 100;
+  const long pages = (argc > 2) ? std::atol(argv[2]) : 200;
+  if (rows < 1 || pages < 1) {
+    std::cout << "Usage: " << argv[0] << " [rows per page (default 100)] [pages (default 200)]" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Parsing " << pages << " pages of " << rows << " results each" << std::endl;
+  std::cout << "Response  Snippets   Navigator rows/s   Decoder rows/s   Speedup" << std::endl;
+  for (const bool xml : {false,true}) {
+    for (const bool raw : {false,true}) {
+      Response resp;
+      resp.setContent(generatePage(xml,raw,rows));
+      resp.setResponseType(xml ? ResponseType::XML : ResponseType::JSON);
+
+      const double before = run(&parseWithNavigator,resp,raw,pages);
+      const double after = run(&parseWithDecoder,resp,raw,pages);
+      std::cout << (xml ? "XML       " : "JSON      ") << (raw ? "raw        " : "snippet    ")
+                << before << "   " << after << "   " << ((before > 0) ? after / before : 0) << "x" << std::endl;
+    }
+  }
+  return 0;
+}
@@ -20,6 +20,7 @@
 
 #include "mlclient/internals/Credentials.hpp"
 #include "mlclient/internals/AuthenticatingProxy.hpp"
+#include "mlclient/internals/HttpClientPool.hpp"
 
 #include "mlclient/utilities/DocumentHelper.hpp"
 #include "mlclient/utilities/CppRestJsonHelper.hpp"
@@ -28,14 +29,73 @@
 
 #include <string>
 #include <sstream>
+#include <chrono>
 
 namespace mlclient {
 
+namespace {
+
+// Request paths and bodies shared by the synchronous and asynchronous calls
+
+std::string searchPath(const SearchDescription& desc) {
+  std::ostringstream urlss;
+  urlss << "/v1/search?format=";
+  const std::string type = desc.getResponseMimeType();
+  if (IDocumentContent::MIME_JSON == type) {
+    urlss << "json";
+  } else {
+    urlss << "xml";
+  }
+  urlss << "&start=" << desc.getStart();
+  urlss << "&pageLength=" <<  desc.getPageLength();
+  if (!desc.getTimestamp().empty()) {
+    urlss << "&timestamp=" << desc.getTimestamp();
+  }
+  return urlss.str();
+}
+
+std::string searchExtensionPath(const std::string& extensionName,const SearchDescription& desc) {
+  std::ostringstream urlss;
+  urlss << "/v1/resources/" << extensionName << "?format=json";
+  urlss << "&rs:start=" << desc.getStart();
+  urlss << "&rs:pageLength=" <<  desc.getPageLength();
+  return urlss.str();
+}
+
+std::string saveSearchOptionsPath(const std::string& name) {
+  std::ostringstream urlss;
+  urlss << "/v1/config/query/" << name;
+  return urlss.str();
+}
+
+std::string valuesPath(const std::string& valuesName,const std::string& optionsName) {
+  std::ostringstream urlss;
+  urlss << "/v1/values/" << valuesName << "?options=" << optionsName;
+  return urlss.str();
+}
+
+std::string valuesExtensionPath(const std::string& extensionName) {
+  std::ostringstream urlss;
+  urlss << "/v1/resources/" << extensionName;// << "?rs:values=" << valuesName << "&rs:options=" << optionsName;
+  return urlss.str();
+}
+
+void listCollectionsQuery(const std::string& parentCollection,GenericTextDocumentContent& tdc) {
+  std::ostringstream os;
+  os << "{\"search\": {\"query\": {\"collection-query\" : {\"uri\": [\"" << parentCollection << "\"]}},";
+  os << "\"options\": {\"default-suggestion-source\": {\"collection\": {\"prefix\":\"" << parentCollection << "\"}}}}}";
+  tdc.setMimeType(IDocumentContent::MIME_JSON);
+  tdc.setContent(os.str());
+}
+
+} // end anonymous namespace
+
 class Connection::Impl {
 public:
-  Impl() : proxy(), databaseName("Documents"), serverUrl("http://localhost:8002") {
+  Impl() : pool(), proxy(), databaseName("Documents"), serverUrl("http://localhost:8002") {
     TIMED_FUNC(Connection_Impl_defaultConstructor);
     LOG(DEBUG) << "    Connection::Impl::defaultConstructor @" << &*this;
+    proxy.setClientPool(&pool);
   };
 
   ~Impl() {
@@ -44,6 +104,7 @@ public:
 
   std::string serverUrl;
   std::string databaseName;
+  internals::HttpClientPool pool; // MUST be declared before proxy, which holds a pointer to it
   internals::AuthenticatingProxy proxy;
 };
 
@@ -61,6 +122,7 @@ Connection::~Connection() {
 void Connection::configure(const std::string& hostname, const std::string& port, const std::string& username, const std::string& password, bool usessl) {
   TIMED_FUNC(Connection_configure);
   mImpl->serverUrl = std::string("http") + (usessl ? "s" : "") + "://" + hostname + ":" + port;
+  mImpl->pool.clear(); // any pooled clients are for the previous host
   internals::Credentials c(username, password);
   mImpl->proxy.addCredentials(c);
 }
@@ -70,7 +132,8 @@ bool Connection::connect() {
 }
 
 void Connection::disconnect() {
-  ; // TODO remove any TCP connections (if they have a keep-alive, they will still exist)
+  TIMED_FUNC(Connection_disconnect);
+  mImpl->pool.clear(); // closes idle keep-alive connections. Leased clients are closed when their request completes.
 }
 
 void Connection::setDatabaseName(const std::string& db) {
@@ -81,6 +144,38 @@ std::string Connection::getDatabaseName() {
   return mImpl->databaseName;
 }
 
+void Connection::setConnectionPoolSize(const unsigned int maxIdle) {
+  mImpl->pool.setMaxIdlePerHost(maxIdle);
+}
+
+void Connection::setConnectionPoolIdleTimeout(const unsigned long seconds) {
+  mImpl->pool.setIdleTimeout(std::chrono::seconds(seconds));
+}
+
+ConnectionPoolStats Connection::getConnectionPoolStats() const {
+  return mImpl->pool.getStats();
+}
+
+AuthenticationStats Connection::getAuthenticationStats() const {
+  return mImpl->proxy.getAuthenticationStats();
+}
+
+void Connection::setAuthProbeThreshold(const unsigned long bytes) {
+  mImpl->proxy.setAuthProbeThreshold(bytes);
+}
+
+void Connection::setMaxInFlightRequests(const unsigned int max) {
+  mImpl->proxy.setMaxInFlight(max);
+}
+
+void Connection::setMaxInFlightReads(const unsigned int max) {
+  mImpl->proxy.setMaxInFlightReads(max);
+}
+
+void Connection::setMaxInFlightWrites(const unsigned int max) {
+  mImpl->proxy.setMaxInFlightWrites(max);
+}
+
 
 
 
@@ -186,63 +281,42 @@ Response* Connection::deleteDocument(const std::string& uri) {
 Response* Connection::search(const SearchDescription& desc) {
   TIMED_FUNC(Connection_search);
   LOG(DEBUG) << "In Connection::search";
-  std::ostringstream urlss;
-  urlss << "/v1/search?format=";
-  const std::string type = desc.getResponseMimeType();
-  if (IDocumentContent::MIME_JSON == type) {
-    urlss << "json";
-  } else {
-    urlss << "xml";
-  }
-  urlss << "&start=" << desc.getStart();
-  urlss << "&pageLength=" <<  desc.getPageLength();
-  LOG(DEBUG) << "  Got page length";
   ITextDocumentContent* payload = desc.getPayload();
   LOG(DEBUG) << "  Payload:-";
   LOG(DEBUG) << payload->getContent();
-  return mImpl->proxy.postSync(mImpl->serverUrl,urlss.str(), *payload);
+  return mImpl->proxy.postSync(mImpl->serverUrl,searchPath(desc), *payload, internals::blankHeaders, internals::RequestClass::READ);
 }
 
 Response* Connection::searchExtension(const std::string& extensionName,const SearchDescription& desc) {
   TIMED_FUNC(Connection_searchExtension);
   LOG(DEBUG) << "In Connection::searchExtension";
-  std::ostringstream urlss;
-  urlss << "/v1/resources/" << extensionName << "?format=json";
-  urlss << "&rs:start=" << desc.getStart();
-  urlss << "&rs:pageLength=" <<  desc.getPageLength();
-  LOG(DEBUG) << "  Got page length";
   ITextDocumentContent* payload = desc.getPayload();
   LOG(DEBUG) << "  Payload:-";
   LOG(DEBUG) << payload->getContent();
-  return mImpl->proxy.postSync(mImpl->serverUrl,urlss.str(), *payload);
+  return mImpl->proxy.postSync(mImpl->serverUrl,searchExtensionPath(extensionName,desc), *payload, internals::blankHeaders,
+      internals::RequestClass::READ);
 }
 
 Response* Connection::saveSearchOptions(const std::string& name,const IDocumentContent* optionsDoc) {
   TIMED_FUNC(Connection_saveSearchOptions);
   LOG(DEBUG) << "In Connection::saveSearchOptions";
-  std::ostringstream urlss;
-  urlss << "/v1/config/query/" << name;
-  return mImpl->proxy.putSync(mImpl->serverUrl,urlss.str(), *optionsDoc);
+  return mImpl->proxy.putSync(mImpl->serverUrl,saveSearchOptionsPath(name), *optionsDoc);
 }
 
 Response* Connection::values(const std::string& valuesName,const std::string& optionsName) {
   TIMED_FUNC(Connection_valuesAggregate);
-  std::ostringstream urlss;
-  urlss << "/v1/values/" << valuesName << "?options=" << optionsName;
-  return mImpl->proxy.getSync(mImpl->serverUrl,urlss.str());
+  return mImpl->proxy.getSync(mImpl->serverUrl,valuesPath(valuesName,optionsName));
 }
 
 Response* Connection::valuesExtension(const std::string& extensionName,const std::string& valuesName,
     const std::string& optionsName,const SearchDescription& desc) {
   TIMED_FUNC(Connection_valuesAggregate);
-  std::ostringstream urlss;
-  urlss << "/v1/resources/" << extensionName;// << "?rs:values=" << valuesName << "&rs:options=" << optionsName;
   //ITextDocumentContent* payload = desc.getPayload();
   //LOG(DEBUG) << "  Payload:-";
   //LOG(DEBUG) << payload->getContent();
-  return mImpl->proxy.getSync(mImpl->serverUrl,urlss.str());
+  return mImpl->proxy.getSync(mImpl->serverUrl,valuesExtensionPath(extensionName));
   // TODO replace this with POST once working...
-  //return mImpl->proxy.postSync(mImpl->serverUrl,urlss.str(),*payload);
+  //return mImpl->proxy.postSync(mImpl->serverUrl,valuesExtensionPath(extensionName),*payload);
 }
 
 Response* Connection::listRootCollections() {
@@ -252,15 +326,174 @@ Response* Connection::listRootCollections() {
 
 Response* Connection::listCollections(const std::string& parentCollection) {
   TIMED_FUNC(Connection_listCollections);
-  std::ostringstream os;
-  os << "{\"search\": {\"query\": {\"collection-query\" : {\"uri\": [\"" << parentCollection << "\"]}},";
-  os << "\"options\": {\"default-suggestion-source\": {\"collection\": {\"prefix\":\"" << parentCollection << "\"}}}}}";
   GenericTextDocumentContent tdc;
-  tdc.setMimeType(IDocumentContent::MIME_JSON);
-  tdc.setContent(os.str());
+  listCollectionsQuery(parentCollection,tdc);
   // TODO handle query for /some that matches /some/col1 returns just /col1 - should correct to /some/col1???
   // TODO Find out why Accept: application/json is not being sent correctly (it works in PostMan)
-  return mImpl->proxy.postSync(mImpl->serverUrl,"/v1/suggest?format=json",tdc);
+  return mImpl->proxy.postSync(mImpl->serverUrl,"/v1/suggest?format=json",tdc,internals::blankHeaders,internals::RequestClass::READ);
+}
+
+
+
+// Asynchronous variants. The proxy reads all request content before returning, so nothing here need outlive the call.
+
+ResponseTask Connection::doGetAsync(const std::string& pathAndQuerystring) {
+  TIMED_FUNC(Connection_doGetAsync);
+  return mImpl->proxy.getAsync(mImpl->serverUrl, pathAndQuerystring);
+}
+
+ResponseTask Connection::doPutAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) {
+  TIMED_FUNC(Connection_doPutAsync);
+  return mImpl->proxy.putAsync(mImpl->serverUrl,pathAndQuerystring,payload);
+}
+
+ResponseTask Connection::doPostAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) {
+  TIMED_FUNC(Connection_doPostAsync);
+  return mImpl->proxy.postAsync(mImpl->serverUrl,pathAndQuerystring,payload);
+}
+
+ResponseTask Connection::doDeleteAsync(const std::string& pathAndQueryString) {
+  TIMED_FUNC(Connection_doDeleteAsync);
+  return mImpl->proxy.deleteAsync(mImpl->serverUrl,pathAndQueryString);
+}
+
+ResponseTask Connection::getDocumentAsync(const std::string& uri) {
+  TIMED_FUNC(Connection_getDocumentAsync);
+  return mImpl->proxy.getAsync(mImpl->serverUrl, "/v1/documents?uri=" + uri); // TODO escape URI for URL rules
+}
+
+ResponseTask Connection::saveDocumentContentAsync(const std::string& uri,const IDocumentContent& payload) {
+  TIMED_FUNC(Connection_saveDocumentContentAsync);
+  return mImpl->proxy.putAsync(mImpl->serverUrl,"/v1/documents?uri=" + uri,payload);
+}
+
+ResponseTask Connection::saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive) {
+  TIMED_FUNC(Connection_saveDocumentsAsync);
+  return mImpl->proxy.multiPostAsync(mImpl->serverUrl,"/v1/documents",documents,startPosInclusive,endPosInclusive);
+}
+
+ResponseTask Connection::saveDocumentAsync(const Document& doc) {
+  TIMED_FUNC(Connection_saveDocumentAsync);
+  DocumentSet set;
+  set.push_back(doc);
+  return mImpl->proxy.multiPostAsync(mImpl->serverUrl,"/v1/documents",set,0,set.size() - 1);
+}
+
+ResponseTask Connection::deleteDocumentAsync(const std::string& uri) {
+  TIMED_FUNC(Connection_deleteDocumentAsync);
+  return mImpl->proxy.deleteAsync(mImpl->serverUrl,"/v1/documents?uri=" + uri);
+}
+
+ResponseTask Connection::searchAsync(const SearchDescription& desc) {
+  TIMED_FUNC(Connection_searchAsync);
+  return mImpl->proxy.postAsync(mImpl->serverUrl,searchPath(desc), *desc.getPayload(), internals::blankHeaders,
+      internals::RequestClass::READ);
+}
+
+ResponseTask Connection::searchExtensionAsync(const std::string& extensionName,const SearchDescription& desc) {
+  TIMED_FUNC(Connection_searchExtensionAsync);
+  return mImpl->proxy.postAsync(mImpl->serverUrl,searchExtensionPath(extensionName,desc), *desc.getPayload(),
+      internals::blankHeaders, internals::RequestClass::READ);
+}
+
+ResponseTask Connection::saveSearchOptionsAsync(const std::string& name,const IDocumentContent* optionsDoc) {
+  TIMED_FUNC(Connection_saveSearchOptionsAsync);
+  return mImpl->proxy.putAsync(mImpl->serverUrl,saveSearchOptionsPath(name), *optionsDoc);
+}
+
+ResponseTask Connection::valuesAsync(const std::string& valuesName,const std::string& optionsName) {
+  TIMED_FUNC(Connection_valuesAsync);
+  return mImpl->proxy.getAsync(mImpl->serverUrl,valuesPath(valuesName,optionsName));
+}
+
+ResponseTask Connection::valuesExtensionAsync(const std::string& extensionName,const std::string& valuesName,
+    const std::string& optionsName,const SearchDescription& desc) {
+  TIMED_FUNC(Connection_valuesExtensionAsync);
+  return mImpl->proxy.getAsync(mImpl->serverUrl,valuesExtensionPath(extensionName));
+}
+
+ResponseTask Connection::listRootCollectionsAsync() {
+  TIMED_FUNC(Connection_listRootCollectionsAsync);
+  return listCollectionsAsync("");
+}
+
+ResponseTask Connection::listCollectionsAsync(const std::string& parentCollection) {
+  TIMED_FUNC(Connection_listCollectionsAsync);
+  GenericTextDocumentContent tdc;
+  listCollectionsQuery(parentCollection,tdc);
+  return mImpl->proxy.postAsync(mImpl->serverUrl,"/v1/suggest?format=json",tdc,internals::blankHeaders,internals::RequestClass::READ);
+}
+
+
+
+// Default asynchronous implementations for IConnection subclasses (E.g. FakeConnection) that only implement the
+// synchronous calls. These complete before returning.
+
+ResponseTask IConnection::doGetAsync(const std::string& pathAndQuerystring) {
+  return pplx::task_from_result(std::shared_ptr<Response>(doGet(pathAndQuerystring)));
+}
+
+ResponseTask IConnection::doPutAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) {
+  return pplx::task_from_result(std::shared_ptr<Response>(doPut(pathAndQuerystring,payload)));
+}
+
+ResponseTask IConnection::doPostAsync(const std::string& pathAndQuerystring,const IDocumentContent& payload) {
+  return pplx::task_from_result(std::shared_ptr<Response>(doPost(pathAndQuerystring,payload)));
+}
+
+ResponseTask IConnection::doDeleteAsync(const std::string& pathAndQueryString) {
+  return pplx::task_from_result(std::shared_ptr<Response>(doDelete(pathAndQueryString)));
+}
+
+ResponseTask IConnection::getDocumentAsync(const std::string& uri) {
+  return pplx::task_from_result(std::shared_ptr<Response>(getDocument(uri)));
+}
+
+ResponseTask IConnection::saveDocumentContentAsync(const std::string& uri,const IDocumentContent& payload) {
+  return pplx::task_from_result(std::shared_ptr<Response>(saveDocumentContent(uri,payload)));
+}
+
+ResponseTask IConnection::saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive) {
+  return pplx::task_from_result(std::shared_ptr<Response>(saveDocuments(documents,startPosInclusive,endPosInclusive)));
+}
+
+ResponseTask IConnection::saveDocumentAsync(const Document& doc) {
+  return pplx::task_from_result(std::shared_ptr<Response>(saveDocument(doc)));
+}
+
+ResponseTask IConnection::deleteDocumentAsync(const std::string& uri) {
+  return pplx::task_from_result(std::shared_ptr<Response>(deleteDocument(uri)));
+}
+
+ResponseTask IConnection::searchAsync(const SearchDescription& desc) {
+  return pplx::task_from_result(std::shared_ptr<Response>(search(desc)));
+}
+
+ResponseTask IConnection::searchExtensionAsync(const std::string& extensionName,const SearchDescription& desc) {
+  return pplx::task_from_result(std::shared_ptr<Response>(searchExtension(extensionName,desc)));
+}
+
+ResponseTask IConnection::saveSearchOptionsAsync(const std::string& optionsName,const IDocumentContent* optionsDoc) {
+  return pplx::task_from_result(std::shared_ptr<Response>(saveSearchOptions(optionsName,optionsDoc)));
+}
+
+ResponseTask IConnection::valuesAsync(const std::string& valuesName,const std::string& optionsName) {
+  return pplx::task_from_result(std::shared_ptr<Response>(values(valuesName,optionsName)));
+}
+
+ResponseTask IConnection::valuesExtensionAsync(const std::string& extensionName,const std::string& valuesName,
+      const std::string& optionsName,const SearchDescription& desc) {
+  return pplx::task_from_result(std::shared_ptr<Response>(valuesExtension(extensionName,valuesName,optionsName,desc)));
+}
+
+ResponseTask IConnection::listRootCollectionsAsync() {
+  return pplx::task_from_result(std::shared_ptr<Response>(listRootCollections()));
+}
+
+ResponseTask IConnection::listCollectionsAsync(const std::string& parentCollection) {
+  return pplx::task_from_result(std::shared_ptr<Response>(listCollections(parentCollection)));
 }
 
 } // end namespace mlclient
@@ -26,7 +26,12 @@
 #include <memory>
 #include <fstream>
 #include <map>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include "mlclient/logging.hpp"
+#include "mlclient/internals/FileStream.hpp"
 
 namespace mlclient {
 
@@ -49,6 +54,13 @@ const std::string IDocumentContent::MIME_DOC("application/msword");
 const std::string IDocumentContent::MIME_DOCX("application/vnd.openxmlformats-officedocument.wordprocessingml.document");
 const std::string IDocumentContent::MIME_PPT("application/vnd.ms-powerpoint");
 const std::string IDocumentContent::MIME_PPTX("application/vnd.openxmlformats-officedocument.presentationml.presentation");
+const std::string IDocumentContent::MIME_XLS("application/vnd.ms-excel");
+const std::string IDocumentContent::MIME_XLSX("application/vnd.openxmlformats-officedocument.spreadsheetml.sheet");
+const std::string IDocumentContent::MIME_PDF("application/pdf");
+const std::string IDocumentContent::MIME_ZIP("application/zip");
+const std::string IDocumentContent::MIME_HTML("text/html");
+const std::string IDocumentContent::MIME_CSV("text/csv");
+const std::string IDocumentContent::MIME_BINARY("application/octet-stream");
 
 IDocumentNode::IDocumentNode() {
   return;
@@ -72,6 +84,10 @@ IDocumentContent::IDocumentContent() {
   LOG(DEBUG) << "    IDocumentContent::defaultConstructor @" << &*this;
 }
 
+long long IDocumentContent::getStreamLength() const {
+  return -1; // unknown - read via getContent()
+}
+
 IDocumentContent::~IDocumentContent() {
   //TIMED_FUNC(IDocumentContent_destructor);
   LOG(DEBUG) << "    IDocumentContent::destructor @" << &*this;
@@ -230,109 +246,209 @@ IDocumentNavigator* GenericTextDocumentContent::navigate(bool firstElementAsRoot
 
 
 
+namespace {
+
+/*
+ * Packs a (lower case) extension of up to 8 characters into an integer, so extensions can be matched with a switch.
+ * constexpr so that the table below is built by the compiler, which also rejects any duplicate entries.
+ */
+constexpr uint64_t packExtension(const char* ext,const int idx = 0) {
+  return ('\0' == ext[idx]) ? 0 : (((uint64_t)(unsigned char)ext[idx] << (8 * idx)) | packExtension(ext,idx + 1));
+}
+
+/*
+ * Returns the MIME type for a filename's extension (case insensitive), or nullptr if not known. Allocates nothing.
+ */
+const std::string* mimeForFilename(const std::string& filename) {
+  const size_t dot = filename.find_last_of("./\\");
+  if (std::string::npos == dot || '.' != filename[dot] || filename.size() - dot - 1 > 8) {
+    return nullptr; // no extension, or too long to be one we know
+  }
+  uint64_t key = 0;
+  for (size_t idx = dot + 1, shift = 0;idx < filename.size();++idx, shift += 8) {
+    key |= (uint64_t)(unsigned char)std::tolower((unsigned char)filename[idx]) << shift;
+  }
+  switch (key) {
+    case packExtension("xml"): return &IDocumentContent::MIME_XML;
+    case packExtension("json"): return &IDocumentContent::MIME_JSON;
+    case packExtension("txt"): return &IDocumentContent::MIME_TXT;
+    case packExtension("csv"): return &IDocumentContent::MIME_CSV;
+    case packExtension("htm"):
+    case packExtension("html"): return &IDocumentContent::MIME_HTML;
+    case packExtension("jpg"):
+    case packExtension("jpeg"): return &IDocumentContent::MIME_JPG;
+    case packExtension("png"): return &IDocumentContent::MIME_PNG;
+    case packExtension("gif"): return &IDocumentContent::MIME_GIF;
+    case packExtension("pdf"): return &IDocumentContent::MIME_PDF;
+    case packExtension("zip"): return &IDocumentContent::MIME_ZIP;
+    case packExtension("doc"): return &IDocumentContent::MIME_DOC;
+    case packExtension("docx"): return &IDocumentContent::MIME_DOCX;
+    case packExtension("ppt"): return &IDocumentContent::MIME_PPT;
+    case packExtension("pptx"): return &IDocumentContent::MIME_PPTX;
+    case packExtension("xls"): return &IDocumentContent::MIME_XLS;
+    case packExtension("xlsx"): return &IDocumentContent::MIME_XLSX;
+    default: return nullptr;
+  }
+}
+
+/*
+ * Guesses the MIME type from the first bytes of content. Returns nullptr if the content is empty.
+ */
+const std::string* mimeForContent(const char* data,const size_t length) {
+  if (0 == length) {
+    return nullptr;
+  }
+  const unsigned char* b = reinterpret_cast<const unsigned char*>(data);
+  if (length >= 8 && 0 == memcmp(b,"\x89PNG\r\n\x1a\n",8)) {
+    return &IDocumentContent::MIME_PNG;
+  }
+  if (length >= 6 && (0 == memcmp(b,"GIF87a",6) || 0 == memcmp(b,"GIF89a",6))) {
+    return &IDocumentContent::MIME_GIF;
+  }
+  if (length >= 3 && 0xFF == b[0] && 0xD8 == b[1] && 0xFF == b[2]) {
+    return &IDocumentContent::MIME_JPG;
+  }
+  if (length >= 5 && 0 == memcmp(b,"%PDF-",5)) {
+    return &IDocumentContent::MIME_PDF;
+  }
+  if (length >= 4 && 0 == memcmp(b,"PK\x03\x04",4)) {
+    return &IDocumentContent::MIME_ZIP; // also docx, pptx and xlsx, which cannot be told apart this early
+  }
+  // text formats - skip any UTF-8 byte order mark and leading white space
+  size_t pos = (length >= 3 && 0xEF == b[0] && 0xBB == b[1] && 0xBF == b[2]) ? 3 : 0;
+  while (pos < length && (' ' == b[pos] || '\t' == b[pos] || '\r' == b[pos] || '\n' == b[pos])) {
+    ++pos;
+  }
+  if (pos < length && '<' == b[pos]) {
+    return &IDocumentContent::MIME_XML;
+  }
+  if (pos < length && ('{' == b[pos] || '[' == b[pos])) {
+    return &IDocumentContent::MIME_JSON;
+  }
+  for (size_t idx = pos;idx < length;++idx) {
+    if (b[idx] < 0x20 && '\t' != b[idx] && '\r' != b[idx] && '\n' != b[idx]) {
+      return &IDocumentContent::MIME_BINARY;
+    }
+  }
+  return &IDocumentContent::MIME_TXT;
+}
+
+const size_t MIME_SNIFF_LENGTH = 512;
+
+} // end anonymous namespace
+
 class FileDocumentContent::Impl {
 public:
-  Impl(const std::string & filename) : filename(filename), mime(IDocumentContent::MIME_JSON), fs(), mimeMap() {
-
-	// Filename extension (XML).
-    static const std::string XML("xml");
-    // Filename extension (JSON).
-    static const std::string JSON("json");
-     // Filename extension (TXT).
-    static const std::string TXT("txt");
-	// Filename extension (JPG).
-    static const std::string JPG("jpg");
- 	// Filename extension (PNG).
-    static const std::string PNG("png");
-	// Filename extension (GIF).
-    static const std::string GIF("gif");
-	// Filename extension (DOC).
-    static const std::string DOC("doc");
-	// Filename extension (DOCX).
-    static const std::string DOCX("docx");
-	// Filename extension (PPT).
-    static const std::string PPT("ppt");
-	// Filename extension (PPTX).
-    static const std::string PPTX("pptx");
-
-    // Store the mappings between extensions and mime types.
-    this->mimeMap.emplace(XML, IDocumentContent::MIME_XML);
-    this->mimeMap.emplace(JSON, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(TXT, IDocumentContent::MIME_TXT);
-    this->mimeMap.emplace(JPG, IDocumentContent::MIME_JPG);
-    this->mimeMap.emplace(PNG, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(GIF, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(DOC, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(DOCX, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(PPT, IDocumentContent::MIME_JSON);
-    this->mimeMap.emplace(PPTX, IDocumentContent::MIME_JSON);
-
-    // get file extension
-    // TODO to lower case this extension
-    // derive mime type
-    auto loc = this->mimeMap.find(this->filename.substr(this->filename.find_last_of(".") + 1));
-    if (this->mimeMap.end() != loc) {
-    	this->mime = loc->second;
+  Impl(const std::string & filename,const bool sniff) : filename(filename), mime(mimeForFilename(filename)),
+      sniff(sniff && nullptr == mime), sniffed(), mimeOverride() {
+    if (nullptr == mime && !this->sniff) {
+      mime = &IDocumentContent::MIME_JSON; // as always
     }
-    return;
   }
-  ~Impl() {
-    return; // fstream automatically destroyed
+
+  const std::string& getMime() {
+    if (!mimeOverride.empty()) {
+      return mimeOverride;
+    }
+    // sniff once, on first use, as this requires reading the file. Once only even if called from several threads at
+    // once, as getMimeType() is const.
+    std::call_once(sniffed,[this] () {
+      if (nullptr != mime) {
+        return;
+      }
+      char head[MIME_SNIFF_LENGTH];
+      std::ifstream is(filename, std::ifstream::in | std::ifstream::binary);
+      is.read(head,MIME_SNIFF_LENGTH);
+      mime = mimeForContent(head,(size_t)is.gcount());
+      if (nullptr == mime) {
+        mime = &IDocumentContent::MIME_JSON;
+      }
+    });
+    return *mime;
   }
 
   std::string const filename;
-  std::string mime; // TODO This really should be const.
-  std::ifstream fs;
-
-private:
-  std::map<std::string,std::string> mimeMap; // TODO Handle this statically, and it should be const.
+  const std::string* mime; // one of the shared IDocumentContent MIME constants, or nullptr if not yet sniffed
+  const bool sniff;
+  std::once_flag sniffed;
+  std::string mimeOverride; // set by setMimeType
 };
 
 
-FileDocumentContent::FileDocumentContent(std::string file) : mImpl(mlclient::make_unique<Impl>(file)) {
+FileDocumentContent::FileDocumentContent(std::string file) : mImpl(mlclient::make_unique<Impl>(file,false)) {
 	  return;
 }
 
+FileDocumentContent::FileDocumentContent(std::string file,const bool sniffMimeType) :
+    mImpl(mlclient::make_unique<Impl>(file,sniffMimeType)) {
+  return;
+}
+
 FileDocumentContent::~FileDocumentContent() {
 	  return;
 }
 
 std::istream* FileDocumentContent::getStream() const {
-  std::ifstream* is = new std::ifstream(this->mImpl->filename, std::ifstream::in);
-  //std::string str(getContent());
-  //std::ostringstream* os = new std::ostringstream;
-  //(*os) << str;
-  return is;
+  // Read by position, so a multipart upload reads straight in to its own buffer. Not mapped - a file truncated mid
+  // upload would raise SIGBUS. See FileStream::lengthOf for the length of the file actually opened.
+  return new mlclient::internals::FileStream(this->mImpl->filename);
+}
+
+long long FileDocumentContent::getStreamLength() const {
+  std::ifstream is(this->mImpl->filename, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+  if (!is.is_open()) {
+    return -1;
+  }
+  return (long long)is.tellg();
 }
 
 std::string FileDocumentContent::getContent() const {
   LOG(DEBUG) << "FileDocumentContent::getContent() entered";
-  this->mImpl->fs.open(this->mImpl->filename, std::fstream::in);
+  mlclient::internals::FileBuffer file(this->mImpl->filename);
+  if (file.isOpen()) {
+    // one copy, rather than character by character. Ends early if the file is truncated meanwhile.
+    std::string str((size_t)file.size(),'\0');
+    std::size_t total = 0;
+    long long read;
+    while (total < str.size() && (read = file.readAt(&str[total],str.size() - total,total)) > 0) {
+      total += (std::size_t)read;
+    }
+    str.resize(total);
+    return str;
+  }
+  std::ifstream fs(this->mImpl->filename, std::fstream::in);
   std::string str;
 
-  this->mImpl->fs.seekg(0, std::ios::end);
-  str.reserve(this->mImpl->fs.tellg());
-  this->mImpl->fs.seekg(0, std::ios::beg);
+  fs.seekg(0, std::ios::end);
+  str.reserve(fs.tellg());
+  fs.seekg(0, std::ios::beg);
 
-  str.assign((std::istreambuf_iterator<char>(this->mImpl->fs)),
+  str.assign((std::istreambuf_iterator<char>(fs)),
              (std::istreambuf_iterator<char>()));
 
-  this->mImpl->fs.close();
-
   LOG(DEBUG) << "FileDocumentContent::getContent() returning: " << str;
 
   return str;
 }
 
 std::string FileDocumentContent::getMimeType() const {
-  return this->mImpl->mime;
+  return this->mImpl->getMime();
 }
 
 void FileDocumentContent::setMimeType(const std::string& mt) {
-  this->mImpl->mime = mt; // TODO enforce to lower case on this input
+  // MIME types are case insensitive, but are compared with the lower case IDocumentContent constants
+  std::string lower(mt);
+  for (auto& c : lower) {
+    c = (char)std::tolower((unsigned char)c);
+  }
+  this->mImpl->mimeOverride = lower;
   return;
 }
 
+const std::string& FileDocumentContent::getFilename() const {
+  return this->mImpl->filename;
+}
+
 
 
 } // end mlclient namespace
@@ -248,6 +248,11 @@ Response::Response() : mImpl(new Impl) {
   LOG(DEBUG) << "    Response::defaultConstructor @" << &*this;
 }
 
+Response::Response(Response&& other) : mImpl(other.mImpl) {
+  TIMED_FUNC(Response_moveConstructor);
+  other.mImpl = new Impl;
+}
+
 Response::~Response() {
   TIMED_FUNC(Response_destructor);
   delete mImpl;
@@ -306,6 +311,14 @@ const std::string& Response::getContent() const {
   return mImpl->content; // TODO check this - force copy cstor - WHY!?! const return type
 }
 
+const char* Response::getContentData() const {
+  return mImpl->content.data();
+}
+
+std::size_t Response::getContentLength() const {
+  return mImpl->content.size();
+}
+
 void Response::setContent(const std::string& content) {
   TIMED_FUNC(Response_setContent);
   LOG(DEBUG) << "Setting response body @" << &*this << " to: " << content;
@@ -31,7 +31,7 @@ namespace mlclient {
 
 class SearchDescription::Impl {
 public:
-  Impl() : start(1), pageLength(10),responseMime(IDocumentContent::MIME_JSON) {
+  Impl() : start(1), pageLength(10),responseMime(IDocumentContent::MIME_JSON), timestamp() {
     TIMED_FUNC(SearchDescription_Impl_defaultConstructor);
     LOG(DEBUG) << "    SearchDescription::Impl::defaultConstructor @" << &*this;
     GenericTextDocumentContent* qtdc = new GenericTextDocumentContent();
@@ -57,6 +57,7 @@ public:
   long start;
   long pageLength;
   std::string responseMime;
+  std::string timestamp;
 }; // end SearchDescription::Impl class
 
 
@@ -120,6 +121,7 @@ SearchDescription::SearchDescription(const SearchDescription& desc) : mImpl(new
   }
   //LOG(DEBUG) << 10;
   mImpl->start = desc.mImpl->start;
+  mImpl->timestamp = desc.mImpl->timestamp;
   LOG(DEBUG) << "    SearchDescription::copyConstructor @ " << &*this << " complete.";
 }
 
@@ -244,4 +246,12 @@ const std::string SearchDescription::getResponseMimeType() const {
   return mImpl->responseMime;
 }
 
+void SearchDescription::setTimestamp(const std::string& timestamp) {
+  mImpl->timestamp = timestamp;
+}
+
+const std::string& SearchDescription::getTimestamp() const {
+  return mImpl->timestamp;
+}
+
 } // end namespace mlclient
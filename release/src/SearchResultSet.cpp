@@ -12,19 +12,192 @@
 #include "mlclient/Response.hpp"
 #include "mlclient/NoCredentialsException.hpp"
 
+#include "mlclient/internals/SearchResponseDecoder.hpp"
+
 #include "mlclient/utilities/CppRestJsonDocumentContent.hpp"
+#include "mlclient/utilities/PugiXmlDocumentContent.hpp"
 #include "mlclient/utilities/PugiXmlHelper.hpp"
-#include "mlclient/utilities/DocumentHelper.hpp"
 
 #include "mlclient/logging.hpp"
 
 // We can use the following, because cpprest is an internal API dependency
 #include "mlclient/utilities/CppRestJsonHelper.hpp"
 #include <cpprest/json.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 namespace mlclient {
 
+ISearchResultConsumer::~ISearchResultConsumer() {
+  ;
+}
+
+
+
+namespace {
+
+/*
+ * Owns a parsed response (or custom snippet) document and its navigator. Shared by the content of each result parsed
+ * from it, as their nodes refer to the document's memory, so it is freed once the last of those results is.
+ */
+struct ParsedDocument {
+  ParsedDocument(IDocumentContent* doc,IDocumentNavigator* nav) : doc(doc), nav(nav) {
+    ;
+  }
+  ~ParsedDocument() {
+    delete nav;
+    delete doc;
+  }
+
+  IDocumentContent* doc;
+  IDocumentNavigator* nav;
+};
+
+/*
+ * Wraps a node for a SearchResult, keeping what it refers to (E.g. a parsed JSON value) alive for as long as the node is
+ */
+std::shared_ptr<IDocumentNode> ownNode(IDocumentNode* node,std::shared_ptr<void> owner) {
+  return std::shared_ptr<IDocumentNode>(node,[owner] (IDocumentNode* n) {
+    delete n;
+  });
+}
+
+const std::string RAW("raw");
+const std::string CUSTOM("custom");
+
+bool hasChildElements(const pugi::xml_node& element) {
+  for (pugi::xml_node child : element.children()) {
+    if (pugi::node_element == child.type()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Parses the JSON value or XML element in span. Returns the node asObject() would have for it: nullptr if it is not
+ * a JSON object, or is an XML element without child elements.
+ */
+std::shared_ptr<IDocumentNode> objectNode(const internals::DecodedSpan& span,const bool isXml) {
+  if (isXml) {
+    std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+    if (!doc->load_buffer(span.data,span.length) || !hasChildElements(doc->document_element())) {
+      return nullptr;
+    }
+    return std::shared_ptr<IDocumentNode>(new mlclient::utilities::PugiXmlObjectNode(doc,doc->document_element()));
+  }
+  if ('{' != span.data[0]) {
+    return nullptr; // E.g. the array of matches
+  }
+  std::shared_ptr<web::json::value> value = std::make_shared<web::json::value>(
+      mlclient::utilities::CppRestJsonHelper::fromString(std::string(span.data,span.length)));
+  return ownNode(new mlclient::utilities::CppRestJsonObjectNode(value->as_object()),value);
+}
+
+/*
+ * Parses the whole of a result object or element in span, for raw results without a separate content element
+ */
+std::shared_ptr<IDocumentNode> resultNode(const internals::DecodedSpan& span,const bool isXml) {
+  if (isXml) {
+    std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+    if (!doc->load_buffer(span.data,span.length)) {
+      return nullptr;
+    }
+    if (hasChildElements(doc->document_element())) {
+      return std::shared_ptr<IDocumentNode>(new mlclient::utilities::PugiXmlObjectNode(doc,doc->document_element()));
+    }
+    return std::shared_ptr<IDocumentNode>(new mlclient::utilities::PugiXmlDocumentNode(doc,doc->document_element()));
+  }
+  std::shared_ptr<web::json::value> value = std::make_shared<web::json::value>(
+      mlclient::utilities::CppRestJsonHelper::fromString(std::string(span.data,span.length)));
+  return ownNode(new mlclient::utilities::CppRestJsonDocumentNode(*value),value);
+}
+
+/*
+ * Parses the JSON document held as text in a custom snippet. Returns nullptr if the snippet holds no text.
+ */
+std::shared_ptr<IDocumentNode> customJsonNode(const internals::DecodedSpan& span,const bool isXml) {
+  std::string json;
+  if (isXml) {
+    pugi::xml_document snippet;
+    if (!snippet.load_buffer(span.data,span.length)) {
+      return nullptr;
+    }
+    json = snippet.document_element().text().get();
+  } else if (!internals::SearchResponseDecoder::jsonString(span,json)) {
+    return nullptr;
+  }
+  web::json::value val = mlclient::utilities::CppRestJsonHelper::fromString(json);
+  // owned before navigating, so the document is freed if that throws
+  std::shared_ptr<ParsedDocument> parsed =
+      std::make_shared<ParsedDocument>(mlclient::utilities::CppRestJsonHelper::toDocument(val),nullptr);
+  parsed->nav = ((ITextDocumentContent*)parsed->doc)->navigate(false);
+  IDocumentNode* root = parsed->nav->firstChild();
+  if (nullptr == root) {
+    return nullptr;
+  }
+  // the navigator owns the root node, so the result points at the root but keeps the whole parsed document alive
+  return std::shared_ptr<IDocumentNode>(parsed,root);
+}
+
+/*
+ * Creates the SearchResult for a decoded row. Its detail content depends on the snippet format:-
+ *  - raw: the search:content, or if there is none the whole result (the document itself)
+ *  - custom: the search:snippet, parsed as JSON if the document is JSON
+ *  - otherwise: the search:matches
+ */
+SearchResult* toSearchResult(const internals::SearchResponseDecoder::Row& row,const std::string& snippetFormat,
+    const bool isXml) {
+  SearchResult::Detail detail = SearchResult::Detail::NONE;
+  std::shared_ptr<IDocumentNode> content;
+  try {
+    if (RAW == snippetFormat) {
+      content = row.content.empty() ? resultNode(row.result,isXml) : objectNode(row.content,isXml);
+    } else if (CUSTOM == snippetFormat) {
+      if (!row.snippet.empty()) {
+        content = ("json" == row.format) ? customJsonNode(row.snippet,isXml) : objectNode(row.snippet,isXml);
+      }
+      detail = (nullptr == content) ? SearchResult::Detail::CONTENT : SearchResult::Detail::SNIPPETS;
+    } else {
+      if (!row.matches.empty()) {
+        content = objectNode(row.matches,isXml);
+      }
+      detail = (nullptr == content) ? SearchResult::Detail::CONTENT : SearchResult::Detail::SNIPPETS;
+    }
+  } catch (std::exception& ex) {
+    // content is not well formed - the result is still returned, without it
+    LOG(DEBUG) << "SearchResultSet could not parse the content of result " << row.uri << ": " << ex.what();
+    content.reset();
+    detail = (RAW == snippetFormat) ? SearchResult::Detail::NONE : SearchResult::Detail::CONTENT;
+  }
+
+  Format format;
+  if ("json" == row.format) {
+    format = Format::JSON;
+  } else if ("xml" == row.format) {
+    format = Format::XML;
+  } else if ("binary" == row.format) {
+    format = Format::BINARY;
+  } else if ("text" == row.format) {
+    format = Format::TEXT;
+  } else {
+    format = Format::NONE;
+  }
+
+  return new SearchResult(row.index,row.uri,row.path,row.score,row.confidence,row.fitness,detail,content,
+      row.mimeType,format);
+}
+
+} // end anonymous namespace
+
 
 
 class SearchResultSet::Impl {
@@ -32,7 +205,10 @@ public:
   Impl(SearchResultSet* set,IConnection* conn,SearchDescription* desc) : mConn(conn), mInitialDescription(desc),
     mResults(), mFetchException(), mIter(new SearchResultSetIterator(set)), mCachedEnd(nullptr), start(0),
     pageLength(0), total(0),totalTime(""), queryResolutionTime(""),snippetResolutionTime(""),m_maxResults(0), lastFetched(-1),
-    fetchTask(nullptr) /*, fetchMtx(), resultsMtx()*/ {
+    fetchTask(nullptr), maxReadAhead(4), readAhead(1), nextStart(0), requestPageLength(0), lastAdaptedPage(0),
+    inflight(), lastHandled(), timestamp(), exceptionMutex(), fetchError(), fetchFailed(false), streaming(false), ring(),
+    consumerIndex(0)
+    /*, fetchMtx(), resultsMtx()*/ {
 
     //TIMED_FUNC(SearchResultSet_Impl_constructor);
     //LOG(DEBUG) << "In SearchResultSet::Impl ctor";
@@ -50,308 +226,95 @@ public:
   }
 
   bool handleFetchResults(Response * resp) {
+    if (!streaming) {
+      return parseResults(resp,mResults,true);
+    }
+    std::vector<SearchResult*> page;
+    const bool ok = parseResults(resp,page,true);
+    if (ring.empty() && !page.empty()) {
+      // room for every page that may be in flight, plus the page being iterated
+      const long pageSize = std::max((long)page.size(),(pageLength < 1) ? 10L : pageLength);
+      ring.assign((maxReadAhead + 1) * pageSize,nullptr);
+    }
+    for (auto& res : page) {
+      const long index = lastFetched.load() + 1;
+      SearchResult*& slot = ring[index % ring.size()];
+      delete slot; // already iterated past - fillPipeline never lets fetched results lap the iterator
+      slot = res;
+      lastFetched = index;
+    }
+    return ok;
+  }
+
+  /*
+   * Parses a page of results into results. If updateSummary is set, also updates the set's total, page and metrics
+   * details, and lastFetched (unless streaming). Otherwise only reads this object's state, so may run concurrently
+   * (E.g. when exporting).
+   *
+   * The response is decoded in a single pass, straight from its buffer. Only each result's content is parsed into
+   * a document.
+   */
+  bool parseResults(Response * resp,std::vector<SearchResult*>& results,const bool updateSummary) {
     //TIMED_FUNC(SearchResultSet_Impl_handleFetchResults);
     //LOG(DEBUG) << "SearchResultSet::handleFetchResults Response value: " << resp->getContent();
 
     // TODO handle request errors
 
-    //const web::json::value value(utilities::CppRestJsonHelper::fromResponse(*resp));
-    ITextDocumentContent* respDoc = (ITextDocumentContent*)mlclient::utilities::DocumentHelper::contentFromResponse(*resp);
-    IDocumentNavigator* nav = respDoc->navigate(true); // look below first element, if response is XML
-
-    //std::unique_lock<std::mutex> lck (resultsMtx,std::defer_lock);
-
-    {
-      //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processMetrics()");
-
+    const bool isXml = (ResponseType::XML == resp->getResponseType());
+    internals::SearchResponseDecoder decoder;
+    bool summarised = false;
+    Impl* self = this;
+    auto handler = [self,&decoder,&summarised,&results,updateSummary,isXml] (const internals::SearchResponseDecoder::Row& row) {
+      const internals::SearchResponseDecoder::Summary& summary = decoder.getSummary();
+      if (!summarised) {
+        summarised = true;
+        if (updateSummary) {
+          self->applySummary(summary); // before any results, so total is known (and reserved) first
+        }
+      }
+      results.push_back(toSearchResult(row,summary.hasSnippetFormat ? summary.snippetFormat : CUSTOM,isXml));
+      if (updateSummary && !self->streaming) {
+        self->lastFetched = results.size() - 1;
+      }
+    };
+    const bool ok = isXml ? decoder.decodeXml(resp->getContentData(),resp->getContentLength(),handler) :
+        decoder.decodeJson(resp->getContentData(),resp->getContentLength(),handler);
+    if (updateSummary) {
+      applySummary(decoder.getSummary()); // again, as the metrics follow the results
+    }
+    if (!ok) {
+      LOG(DEBUG) << "SearchResultSet could not decode the search response: " << decoder.getError();
+    }
+    return ok;
+  };
 
-    // extract top level summary information for the result set
-    IDocumentNode* snNode = nav->at("snippet-format");
-    if (nullptr == snNode) {
-      LOG(DEBUG) << "WARNING: snippet-format not found in results";
-      snippetFormat = "custom"; // should never happen unless snippeting is disabled
+  /*
+   * Updates the set's total, page and metrics details from a page's summary
+   */
+  void applySummary(const internals::SearchResponseDecoder::Summary& summary) {
+    if (summary.hasSnippetFormat) {
+      snippetFormat = summary.snippetFormat;
     } else {
-      snippetFormat = snNode->asString();
+      LOG(DEBUG) << "WARNING: snippet-format not found in results";
+      snippetFormat = CUSTOM; // should never happen unless snippeting is disabled
     }
-    LOG(DEBUG) << "Snippet format: " << snippetFormat;
-    total = nav->at("total")->asInteger();
-    if (0 == m_maxResults) {
-      //lck.lock();
+    total = summary.total;
+    if (streaming) {
+      // only a window of results is held - see handleFetchResults
+    } else if (0 == m_maxResults) {
       mResults.reserve(total);
-      //lck.unlock();
     } else {
-      //lck.lock();
       mResults.reserve(m_maxResults);
-      //lck.unlock();
     }
-    pageLength = nav->at("page-length")->asInteger();
-    start = nav->at("start")->asInteger();
-
-    // extract metrics, if they exist
-    // TODO better way to check for response metrics being present, without exception throwing
-    try {
-      IDocumentNode* metrics = nav->at("search:metrics");
-      queryResolutionTime = metrics->at("search:query-resolution-time")->asString();
-      snippetResolutionTime = metrics->at("search:snippet-resolution-time")->asString();
-      totalTime = metrics->at("search:total-time")->asString();
-      //CLOG(INFO, "performance") << "Executed [marklogic::rest::search::queryResolutionTime()] in [" << queryResolutionTime.substr(2,queryResolutionTime.length() - 3) << " ms]";
-      //CLOG(INFO, "performance") << "Executed [marklogic::rest::search::snippetResolutionTime()] in [" << snippetResolutionTime.substr(2,snippetResolutionTime.length() - 3) << " ms]";
-      //CLOG(INFO, "performance") << "Executed [marklogic::rest::search::totalTime()] in [" << totalTime.substr(2,totalTime.length() - 3) << " ms]";
-    } catch (std::exception& me) {
-      // no metrics element - possible due to search options
-      // silently fail - not a huge issue
-      // TODO flag this to support hasMetrics()
-      //LOG(DEBUG) << "SearchResultSet::handleFetchResults   COULD NOT PARSE RESPONSE METRICS!!!" << me.what();
+    pageLength = summary.pageLength;
+    start = summary.start;
+    if (summary.hasMetrics) {
+      queryResolutionTime = summary.queryResolutionTime;
+      snippetResolutionTime = summary.snippetResolutionTime;
+      totalTime = summary.totalTime;
     }
-
-    } // end timed scope for metrics
-
-    LOG(DEBUG) << "Extracted metrics";
-
-    // TODO preallocate total results (or limit, if set and lower) in mImpl->mResults vector - speeds up append operations
-
-    //SearchResult::DETAIL detail(SearchResult::DETAIL::NONE);
-    static std::string raw("raw"); // always the same
-    static std::string custom("custom"); // always the same
-    //std::string ct;
-
-    {
-      //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processResultSet()");
-
-
-    bool isRaw = (raw == snippetFormat);
-    bool isCustom = (custom == snippetFormat);
-    
-    // take the response, and parse it
-    // NOT NEEDED const web::json::value& resv = value.at(U("results"));
-    //const web::json::array res(value.at(U("results")).as_array());
-    bool hasResults = nav->has("search:result");
-    IDocumentNode* res = nullptr;
-    if (hasResults) {
-      res = nav->at("search:result"); // this fails if it doesn't exist
-    
-    } else {
-      //res = res->asArray();
-      if (!hasResults || nullptr == res) {
-        hasResults = nav->has("search:results");
-        if (hasResults) {
-          res = nav->at("search:results");
-        } else {
-          if (!hasResults || nullptr != res) {
-            //res = res->asArray();
-            
-            
-            // TODO safely fail - no search results in search response (may have values, etc. instead)
-            LOG(DEBUG) << "WARNING: No search:result or search:results element in result JSON from REST API";
-
-
-          }
-        } // end second has results
-      }
-    } // end if has results
-    //{
-    //  TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::asArray()");
-
-    //  const web::json::array resCount = value.at(U("results")).as_array(); // TODO remove once counted in PERF logger
-    //}
-    //LOG(DEBUG) << "SearchResultSet::handleFetchResults We have a results JSON array";
-
-    //web::json::array::const_iterator iter(res.begin());
-    //const web::json::array::const_iterator jsonArrayIterEnd(res.end()); // see if a single call saves us time... nope
-
-    // TODO check if res is nullptr (i.e. return-results is false in search options)
-    LOG(DEBUG) << "Is result set empty?: " << (nullptr == res);
-
-    if (nullptr != res) {
- 
-    int arrayLength = res->size();
-    LOG(DEBUG) << "Search result array length: " << arrayLength;
-
-    //mlclient::IDocumentContent* ct;
-    
-    std::shared_ptr<IDocumentNode> ctValPtr;
-
-    SearchResult::Detail detail;
-    std::string mimeType;
-    Format format;
-    //web::json::object row = web::json::value::object().as_object();
-    IDocumentNode* row;
-
-    {
-      //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processResultSetLoopOnly()");
-
-    //for (; iter != jsonArrayIterEnd;++iter) {
-    for (int i = 0;i < arrayLength;i++) {
-      {
-      //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processRow()");
-      //auto& rowdata = *iter;
-      //row = iter->as_object();
-      if (res->isArray()) {
-        row = res->at(i);
-      } else {
-        row = res; // single result in response!
-      }
-
-      {
-        //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processRowObject()");
-
-
-      //LOG(DEBUG) << "Row: " << iter->as_string();
-      //const web::json::object& row = iter.as_object();
-      detail = SearchResult::Detail::NONE;
-      mimeType = "";
-      format = Format::JSON;
-      //web::json::value ctVal;
-      //IDocumentNode* ctVal = nullptr;
-      //ct = "";
-      LOG(DEBUG) << "Processing search results";
-
-      // if snippet-format = raw
-      if (isRaw) {
-          //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processContent()");
-        if (row->has("search:content")) {
-          try {
-            ctValPtr.reset(row->at("search:content")->asObject()); // at is rvalue, moved to lvalue by json's move contructor
-            LOG(DEBUG) << "SearchResultSet::handleFetchResults   Got content";
-
-          } catch (std::exception& e) {
-            LOG(DEBUG) << "SearchResultSet::handleFetchResults   Row does not have content... trying snippet..." << e.what();
-            //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processContentEXCEPTION()");
-            // element doesn't exist - no result content, or has a snippet
-          } // end content catch
-        } else {
-          // no content element, just use entire element
-          LOG(DEBUG) << "SearchResultSet::handleFetchResults   No content node but raw, so entire content is the document";
-          ctValPtr.reset(row);
-        }
-
-      } else if (isCustom) {
-        LOG(DEBUG) << "Custom snippet format result";
-        // Assume the custom snippet information is within the <snippet> element in the search response
-        try {
-          IDocumentNode* snippet = row->at("search:snippet");
-          // If search result format type is XML, but content is JSON, convert the search snippet to the right doc type
-          std::string docFormat = row->at("format")->asString();
-          if ("json" == docFormat) {
-            // get content of snippet as string 
-            std::string json = snippet->asString();
-            // parse as JSON document, and set pointer accordingly
-
-            web::json::value val = mlclient::utilities::CppRestJsonHelper::fromString(json);
-            IDocumentContent* jsonDoc = mlclient::utilities::CppRestJsonHelper::toDocument(val);
-            ctValPtr.reset(((ITextDocumentContent*)jsonDoc)->navigate(false)->firstChild()); // TODO verify this is correct
-          } else {
-            //IDocumentNode* snippetObject = snippet->asObject();
-            //ctValPtr.reset(snippetObject->at(snippetObject->keys()[0]));
-            ctValPtr.reset(snippet->asObject());
-          }
-          detail = SearchResult::Detail::SNIPPETS;
-        } catch (std::exception& ex) {
-          // no snippet element, must be some sort of content...
-          detail = SearchResult::Detail::CONTENT;
-          LOG(DEBUG) << "SearchResultSet::handleFetchResults   Result has no snippet element" << ex.what();
-          //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processMatchesEXCEPTION()");
-        }
-      } else {
-        LOG(DEBUG) << "Fetching search result content from matches element";
-
-        try {
-          //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processMatches()");
-          ctValPtr.reset(row->at("search:matches")->asObject());
-
-/*
-          mimeType = utility::conversions::to_utf8string(row.at(U("mimetype")).as_string());
-          std::string formatStr = utility::conversions::to_utf8string(row.at(U("format")).as_string());
-          //LOG(DEBUG) << "SearchResultSet::handleFetchResults   Got snippet content" << ct;
-          if ("json" == formatStr) {
-            format = Format::JSON;
-          } else if ("xml" == formatStr) {
-            format = Format::XML;
-          } else if ("binary" == formatStr) {
-            format = Format::BINARY;
-          } else if ("text" == formatStr) {
-            format = Format::TEXT;
-          } else {
-            format = Format::NONE;
-          }
-*/
-          /*
-          ct = new mlclient::utilities::CppRestJsonDocumentContent();
-          ct->setMimeType(IDocumentContent::MIME_JSON);
-          ct->setContent(ctVal);
-          */
-          //ct = divineDocumentContent(formatStr,mimeType,ctVal);
-          //ct = utility::conversions::to_utf8string(ctVal.as_string());
-
-
-          detail = SearchResult::Detail::SNIPPETS;
-        } catch (std::exception& ex) {
-          // no snippet element, must be some sort of content...
-          detail = SearchResult::Detail::CONTENT;
-          LOG(DEBUG) << "SearchResultSet::handleFetchResults   Result has no matches element" << ex.what();
-          //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::processMatchesEXCEPTION()");
-        }
-      }
-
-
-              mimeType = row->at("mimetype")->asString();
-              //LOG(DEBUG) << "SearchResultSet::handleFetchResults   Got mimetype";
-              std::string formatStr = row->at("format")->asString();
-              if ("json" == formatStr) {
-                format = Format::JSON;
-              } else if ("xml" == formatStr) {
-                format = Format::XML;
-              } else if ("binary" == formatStr) {
-                format = Format::BINARY;
-              } else if ("text" == formatStr) {
-                format = Format::TEXT;
-              } else {
-                format = Format::NONE;
-              }
-              //LOG(DEBUG) << "SearchResultSet::handleFetchResults   Got format";
-              //LOG(DEBUG) << "SearchResultSet::handleFetchResults   Row content: " << ct;
-
-              //ct = divineDocumentContent(formatStr,mimeType,ctVal);
-      LOG(DEBUG) << "Search results ctVal is null?: " << (nullptr == ctValPtr.get());
-
-      // TODO handle empty result or no search metrics in the below - at the moment they could throw!!!
-      {
-        //TIMED_SCOPE(SearchResultSet_Impl_handleFetchResult, "mlclient::SearchResultSet::Impl::handleFetchResult::appendToVector()");
-      //SearchResult sr(row.at(U("index")).as_integer(), utility::conversions::to_utf8string(row.at(U("uri")).as_string()),
-        //utility::conversions::to_utf8string(row.at(U("path")).as_string()),row.at(U("score")).as_integer(),
-        //row.at(U("confidence")).as_double(),row.at(U("fitness")).as_double(),detail,ct,mimeType,format );
-
-        //lck.lock();
-      mResults.push_back(
-        new SearchResult(
-          row->at("index")->asInteger(),
-          row->at("uri")->asString(),
-          row->at("path")->asString(),
-          row->at("score")->asInteger(),
-          row->at("confidence")->asDouble(),
-          row->at("fitness")->asDouble(),
-          detail,ctValPtr,mimeType,format
-        )
-      );
-
-      lastFetched = mResults.size() - 1;
-
-      //lck.unlock();
-    } // end timed scope
-      }
-      }
-    } // end loop
-
-    } // end timed scope loop only
-
-    } else { 
-      LOG(DEBUG) << "Results from REST API does not contain a search:result element or results property";
-    } // end res is null guard if 
-
-    } // end process result set scope
-
-    return true;
-  };
+    // else no metrics element - possible due to search options
+  }
 /*
   ITextDocumentContent* divineDocumentContent(const std::string& format,const std::string& mimeType,IDocumentNode* ctVal) {
     ITextDocumentContent* ct;
@@ -380,41 +343,106 @@ public:
   }
   */
 
-  bool fetchInitial() {
-    //LOG(DEBUG) << "In fetchInitial";
-    //LOG(DEBUG) << "mInitialDescription: " << mInitialDescription->getPayload()->getContent();
-    // make this async
-    Impl& mImpl = (*this);
+  /*
+   * Handles a completed search request. Shared by the initial and subsequent page fetches.
+   *
+   * A page that fails (an exception, a response other than 200 OK, or a body that cannot be decoded) is recorded as
+   * the fetch exception, and stops any later page being handled or requested - appending them would misplace every
+   * later result. The iterator rethrows it on reaching the results that are missing.
+   */
+  bool handleFetchTask(ResponseTask task,const bool initial = false) {
+    if (fetchFailed) {
+      return false; // an earlier page failed
+    }
+    try {
+      std::shared_ptr<Response> resp = task.get();
+      if (!resp) {
+        failFetch(std::runtime_error("SearchResultSet search request returned no response"));
+        return false;
+      }
+      if (ResponseCode::OK != resp->getResponseCode()) {
+        std::ostringstream msg;
+        msg << "SearchResultSet search request failed with response code: " << resp->getResponseCode();
+        failFetch(std::runtime_error(msg.str()));
+        return false;
+      }
+      if (initial) {
+        // set once, before any later page is requested, so an export can pin its pages to this point in time
+        timestamp = resp->getResponseHeaders().getHeader("ML-Effective-Timestamp");
+      }
+      if (!handleFetchResults(resp.get())) {
+        failFetch(std::runtime_error("SearchResultSet could not decode the search response"));
+        return false;
+      }
+      return true;
+    } catch (std::exception& ref) {
+      LOG(DEBUG) << "Exception in fetch task: " << ref.what();
+      setFetchException(ref);
+      fetchFailed = true;
+    }
+    return false;
+  }
 
-    //std::unique_lock<std::mutex> lck (fetchMtx,std::defer_lock);
-    //lck.lock();
+  /*
+   * Records a failure that is not itself an exception, and stops further pages being handled
+   */
+  void failFetch(const std::runtime_error& error) {
+    LOG(DEBUG) << error.what();
+    {
+      std::lock_guard<std::mutex> lck(exceptionMutex);
+      mFetchException = error;
+      if (!fetchError) {
+        fetchError = std::make_exception_ptr(error);
+      }
+    }
+    fetchFailed = true;
+  }
 
-    fetchTask = new pplx::task<void>([&mImpl] () {
-      //LOG(DEBUG) << "Began initial fetch task...";
+  /*
+   * Rethrows the fetch exception if a page failed before the result at the 0 based index was fetched
+   */
+  void throwIfFailed(const long index) {
+    if (!fetchFailed || lastFetched.load() >= index) {
+      return;
+    }
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lck(exceptionMutex);
+      error = fetchError;
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    throw std::runtime_error("SearchResultSet could not fetch a page of results");
+  }
 
+  pplx::task<bool> fetchInitialAsync() {
+    //LOG(DEBUG) << "In fetchInitialAsync";
+    Impl* self = this;
 
-    try {
-      // perform the request to search in the connection
-      if (0 != mImpl.m_maxResults && mImpl.m_maxResults < mImpl.start + mImpl.pageLength - 1) { // E.g. Page 2, 11 results => 11 < 11 + 10 - 1 => 11 < 20 (i.e. max result requires limiting this page's length)
-        mImpl.mInitialDescription->setPageLength(mImpl.m_maxResults - mImpl.start + 1); // E.g. Page 2, 11 results => 11 - 11 + 1 = 1 results max on page 2
-      }
-      Response* resp = mImpl.mConn->search(*mImpl.mInitialDescription);
-      bool success = mImpl.handleFetchResults(resp);
+    // perform the request to search in the connection - no thread is blocked while it is in flight
+    if (0 != m_maxResults && m_maxResults < start + pageLength - 1) { // E.g. Page 2, 11 results => 11 < 11 + 10 - 1 => 11 < 20 (i.e. max result requires limiting this page's length)
+      mInitialDescription->setPageLength(m_maxResults - start + 1); // E.g. Page 2, 11 results => 11 - 11 + 1 = 1 results max on page 2
+    }
+    pplx::task<bool> initial = mConn->searchAsync(*mInitialDescription).then([self] (ResponseTask task) {
+      bool success = self->handleFetchTask(task,true);
       LOG(DEBUG) << "Initial fetch task a success? : " << success;
+      return success;
+    });
+    fetchTask = new pplx::task<void>(initial.then([] (bool) {}));
+    return initial;
+  }
 
-      delete(resp); // TODO ensure this does not invalidate any of our variables in search result set or searchresult instances
+  bool fetchInitial() {
+    //LOG(DEBUG) << "In fetchInitial";
+    //LOG(DEBUG) << "mInitialDescription: " << mInitialDescription->getPayload()->getContent();
 
-      //return success;
-    } catch (std::exception& ref) {
-      mImpl.mFetchException = ref;
-      //LOG(DEBUG) << "Exception in initial fetch task";
-      //return false;
-    }
-    //LOG(DEBUG) << "End initial fetch task";
+    //std::unique_lock<std::mutex> lck (fetchMtx,std::defer_lock);
+    //lck.lock();
 
-    });
+    fetchInitialAsync();
     // BLOCK for first result set to ensure all variables for the result set (E.g. total) are set up before next function calls
-    // No way to avoid this blocking really.
+    // Use fetchAsync() to avoid this.
     fetchTask->wait();
 
     //lck.unlock();
@@ -422,83 +450,348 @@ public:
     return true;
   };
 
-  // Returning false means no fetchTask is running or created, return true means we can safely call wait()
-  bool fetchNext() {
-    //TIMED_FUNC(SearchResultSet_Impl_fetchNext);
-    //LOG(DEBUG) << "In fetchNext";
+  /*
+   * Requests pages ahead of the iterator until readAhead requests are in flight. Each page's results are handled only
+   * once the page before has been, so they are always appended in order however the responses arrive.
+   *
+   * If streaming, also never requests a page that would overwrite a result the iterator has not yet reached.
+   *
+   * Called only from the iterating thread, once the initial page has been handled.
+   */
+  void fillPipeline() {
+    if (nullptr == fetchTask || !fetchTask->is_done() || fetchFailed) {
+      return;
+    }
+    if (0 == nextStart) {
+      // the initial page has told us where the next starts, and how long pages are
+      requestPageLength = (pageLength < 1) ? 10 : pageLength;
+      nextStart = start + requestPageLength;
+      lastHandled = *fetchTask;
+    }
+    // results are 1 based, so this is also the last result to fetch
+    const long limit = (0 != m_maxResults && m_maxResults < total) ? m_maxResults : total;
+
+    Impl* self = this;
+    while ((long)inflight.size() < readAhead && nextStart <= limit) {
+      const long length = std::min(requestPageLength,limit - nextStart + 1);
+      if (streaming && !ring.empty() &&
+          nextStart - mInitialDescription->getStart() + length > consumerIndex + (long)ring.size()) {
+        break; // resumes as the iterator moves on
+      }
+      SearchDescription newDescription = *(mInitialDescription); // force copy - keeps any timestamp the caller set
+      newDescription.setStart(nextStart);
+      newDescription.setPageLength(length);
+
+      // newDescription is read before searchAsync returns, and no thread is blocked while the request is in flight
+      pplx::task<void> previous = lastHandled;
+      lastHandled = mConn->searchAsync(newDescription).then([self,previous] (ResponseTask task) {
+        return previous.then([self,task] () {
+          self->handleFetchTask(task); // never throws, so never breaks the chain. Does nothing once a page has failed.
+        });
+      });
+      inflight.push_back(lastHandled);
+      nextStart += length;
+    }
+  }
 
-    // TODO check if we need to wait for the last thread
-    if (nullptr == fetchTask) {
-      //LOG(DEBUG) << "  Returning: fetchTask is null";
-      return false;
+  /*
+   * Called by the iterator as it moves to the 0 based index. Tops up the pages in flight, and once per page reduces
+   * the read ahead if the iterator is further behind the fetched results than the read ahead would cover.
+   *
+   * Returns whether any page requests are in flight.
+   */
+  bool fetchNext(const long index) {
+    consumerIndex = index;
+    while (!inflight.empty() && inflight.front().is_done()) {
+      inflight.pop_front();
     }
-    if (!fetchTask->is_done()) {
-      //LOG(DEBUG) << "  Returning: fetchTask is still in progress";
-      return true; // rely on caller in iterator checking and calling wait() on mImpl;
+    if (requestPageLength > 0) {
+      const long page = index / requestPageLength;
+      if (page != lastAdaptedPage) {
+        lastAdaptedPage = page;
+        if (readAhead > 1 && lastFetched - index >= readAhead * requestPageLength) {
+          --readAhead; // the consumer is the bottleneck - fewer requests will do
+        }
+      }
     }
-    //LOG(DEBUG) << "Previous fetch complete";
+    fillPipeline();
+    return !inflight.empty();
+  };
 
-    // lastfetched is 0 based - E.g. 0-499
-    // m_maxResults is 1 based - E.g. 1-500 - COULD BE 0 IF NOT SET!
-    if ((0 != m_maxResults && lastFetched >= m_maxResults - 1) || (lastFetched >= total - 1)) {
-      // No need to fetch any more
-      //LOG(DEBUG) << "lastFetched has reached maxResults - not fetching";
-      return false;
+  /*
+   * Blocks until the result at the 0 based index has been fetched, or there are no more pages to fetch. Doubles the
+   * read ahead each time the iterator has to wait. Throws the fetch exception if a page failed before the index.
+   */
+  void waitFor(const long index) {
+    consumerIndex = index;
+    fillPipeline();
+    bool stalled = false;
+    while (lastFetched.load() < index && !inflight.empty()) {
+      if (!stalled && !inflight.front().is_done()) {
+        stalled = true;
+        readAhead = std::min(maxReadAhead,readAhead * 2);
+        fillPipeline();
+      }
+      inflight.front().wait();
+      inflight.pop_front();
+      fillPipeline();
     }
+    throwIfFailed(index);
+  }
 
-    //LOG(DEBUG) << "Creating new fetch task...";
+  /*
+   * The state of an export, shared by its lanes. Each lane has one page request in flight at a time, and claims the
+   * next page as soon as its last has been consumed (or buffered, if ordered), so there are never more than the
+   * number of lanes in flight.
+   */
+  struct Export {
+    Export(ISearchResultConsumer* consumer,const long lanes,const bool ordered) : consumer(consumer), ordered(ordered),
+        window(2 * lanes), base(0), pageLength(0), limit(0), pages(0), nextPage(0), nextDeliver(0), activeLanes(lanes),
+        parked(0), delivering(false), ok(true), mutex(), consumeMutex(), ready(), done() {
+      ;
+    }
 
-    //std::unique_lock<std::mutex> lck (fetchMtx,std::defer_lock);
-    //lck.lock();
+    ISearchResultConsumer* consumer;
+    bool ordered;
+    long window; // pages that may be fetched ahead of those consumed, if ordered
+    long base; // 1 based start of page 0
+    long pageLength;
+    long limit; // 1 based last result to export
+    long pages;
+    long nextPage;
+    long nextDeliver;
+    long activeLanes;
+    long parked; // lanes waiting for the ordered buffer to drain
+    bool delivering;
+    std::atomic<bool> ok;
+    std::mutex mutex;
+    std::mutex consumeMutex; // so consumers need not be thread safe
+    std::map<long,std::vector<SearchResult*>> ready; // fetched pages awaiting earlier pages, if ordered
+    pplx::task_completion_event<bool> done;
+  };
 
-    // TODO make this async
-    Impl& mImpl(*this);
-
-    fetchTask = new pplx::task<void>([&mImpl] () {
-      //LOG(DEBUG) << "Started another fetchTask";
-
-    // private method - called internally only
-    // use start and pageLength to determine next start value
-    // if total <= start + pageLenth - 1, then we are already at the end! So don't fetch.
-    //LOG(DEBUG) << "In fetchNext()";
-    if (mImpl.total > mImpl.start + mImpl.pageLength - 1) {
-      //LOG(DEBUG) << "Fetching next page...";
-      // fetch more results
-      // TODO support point in time query, so totals are always consistent
-      SearchDescription newDescription = *(mImpl.mInitialDescription); // force copy
-      //LOG(DEBUG) << "  Got new description";
-      // override settings in search options for start value
-      newDescription.setStart(mImpl.start + mImpl.pageLength);
-      if (0 != mImpl.m_maxResults && mImpl.m_maxResults < mImpl.start + mImpl.pageLength - 1) { // E.g. Page 2, 11 results => 11 < 11 + 10 - 1 => 11 < 20 (i.e. max result requires limiting this page's length)
-        newDescription.setPageLength(mImpl.m_maxResults - mImpl.start + 1); // E.g. Page 2, 11 results => 11 - 11 + 1 = 1 results max on page 2
+  pplx::task<bool> exportAllAsync(ISearchResultConsumer* consumer,const long parallelPages,const bool ordered) {
+    Impl* self = this;
+    pplx::task<bool> initial = (nullptr == fetchTask) ? fetchInitialAsync() : fetchTask->then([self] () {
+      return -1 != self->lastFetched.load() || 0 == self->total;
+    });
+    return initial.then([self,consumer,parallelPages,ordered] (bool ok) -> pplx::task<bool> {
+      if (!ok) {
+        return pplx::task_from_result(false);
       }
-      //LOG(DEBUG) << "  set start on new description";
-      //LOG(DEBUG) << "Validating search payload: " << newDescription.getPayload()->getContent();
-      //LOG(DEBUG) << " mConn is nullptr?: " << (nullptr == mImpl.mConn);
-      //LOG(DEBUG) << " mConn address: " << mImpl.mConn;
+      return self->startExport(consumer,parallelPages,ordered);
+    });
+  }
 
-      Response* resp = mImpl.mConn->search(newDescription);
-      //LOG(DEBUG) << "  Completed search... calling handleFetchResults()";
-      mImpl.handleFetchResults(resp);
+  /*
+   * Consumes the results fetched so far (the initial page), then starts the lanes fetching the remaining pages.
+   */
+  pplx::task<bool> startExport(ISearchResultConsumer* consumer,const long parallelPages,const bool ordered) {
+    const long fetched = lastFetched.load() + 1;
+    const long limit = (0 != m_maxResults && m_maxResults < total) ? m_maxResults : total;
+    std::vector<SearchResult*> initial;
+    for (long i = 0;i < std::min(fetched,limit);i++) {
+      initial.push_back(getResult(i)); // all held, even if streaming, as the ring holds more than a page
+    }
+    if (!consume(consumer,initial,false)) {
+      return pplx::task_from_result(false);
+    }
 
-      // TODO delete resp???
-    } else {
-      //LOG(DEBUG) << "No more pages to fetch";
-      ;
+    const long pageSize = (requestPageLength > 0) ? requestPageLength : ((pageLength < 1) ? 10 : pageLength);
+    const long base = mInitialDescription->getStart() + fetched;
+    const long pages = (limit >= base) ? (limit - base + pageSize) / pageSize : 0;
+    if (0 == pages) {
+      return pplx::task_from_result(true);
+    }
+    const long lanes = std::max(1L,std::min(parallelPages,pages));
+    LOG(DEBUG) << "SearchResultSet exporting " << pages << " more pages with " << lanes << " requests in flight";
+
+    auto ex = std::make_shared<Export>(consumer,lanes,ordered);
+    ex->base = base;
+    ex->pageLength = pageSize;
+    ex->limit = limit;
+    ex->pages = pages;
+    pplx::task<bool> result = pplx::create_task(ex->done);
+    for (long lane = 0;lane < lanes;lane++) {
+      exportLane(ex);
     }
-    //return true;
-    //LOG(DEBUG) << "Ended another fetchTask";
+    return result;
+  }
 
+  /*
+   * Claims and requests the next page. Runs again on the page's completion, until there are no more pages.
+   */
+  void exportLane(std::shared_ptr<Export> ex) {
+    long page;
+    {
+      std::lock_guard<std::mutex> lck(ex->mutex);
+      if (!ex->ok || ex->nextPage >= ex->pages) {
+        finishLane(*ex);
+        return;
+      }
+      if (ex->ordered && ex->nextPage >= ex->nextDeliver + ex->window) {
+        ex->parked++; // resumed once the buffered pages are consumed
+        return;
+      }
+      page = ex->nextPage++;
+    }
 
-    }); // end task block
-    //lck.unlock();
+    SearchDescription desc = *(mInitialDescription); // force copy
+    const long pageStart = ex->base + page * ex->pageLength;
+    desc.setStart(pageStart);
+    desc.setPageLength(std::min(ex->pageLength,ex->limit - pageStart + 1));
+    if (desc.getTimestamp().empty() && !timestamp.empty()) {
+      desc.setTimestamp(timestamp); // only read here, once the initial page has set it
+    }
 
-    return true;
-  };
+    Impl* self = this;
+    try {
+      mConn->searchAsync(desc).then([self,ex,page] (ResponseTask task) {
+        std::vector<SearchResult*> results;
+        bool ok = false;
+        try {
+          std::shared_ptr<Response> resp = task.get();
+          ok = resp && ResponseCode::OK == resp->getResponseCode() && self->parseResults(resp.get(),results,false);
+        } catch (std::exception& ref) {
+          self->setFetchException(ref);
+        }
+        if (ok) {
+          self->deliver(ex,page,std::move(results));
+        } else {
+          LOG(DEBUG) << "SearchResultSet export failed to fetch page " << page;
+          for (auto& res : results) {
+            delete res;
+          }
+          self->fail(ex);
+        }
+        self->exportLane(ex);
+      });
+    } catch (std::exception& ref) {
+      setFetchException(ref);
+      fail(ex);
+      exportLane(ex); // finishes this lane
+    }
+  }
+
+  /*
+   * Passes a fetched page to the consumer. If ordered, pages arriving early are buffered until the pages before them
+   * have been consumed.
+   */
+  void deliver(std::shared_ptr<Export> ex,const long page,std::vector<SearchResult*>&& results) {
+    if (!ex->ordered) {
+      if (!consume(ex->consumer,results,true,&ex->consumeMutex)) {
+        fail(ex);
+      }
+      return;
+    }
+    std::unique_lock<std::mutex> lck(ex->mutex);
+    ex->ready[page] = std::move(results);
+    if (ex->delivering) {
+      return; // the lane that is delivering will deliver this in turn
+    }
+    ex->delivering = true;
+    while (!ex->ready.empty() && ex->ready.begin()->first == ex->nextDeliver) {
+      std::vector<SearchResult*> next = std::move(ex->ready.begin()->second);
+      ex->ready.erase(ex->ready.begin());
+      lck.unlock();
+      const bool ok = consume(ex->consumer,next,true); // only one lane delivers at a time
+      lck.lock();
+      if (!ok) {
+        ex->ok = false;
+      }
+      ex->nextDeliver++;
+    }
+    ex->delivering = false;
+    const long resume = ex->parked;
+    ex->parked = 0;
+    lck.unlock();
+    for (long lane = 0;lane < resume;lane++) {
+      exportLane(ex); // parks again if still too far ahead
+    }
+  }
+
+  /*
+   * Stops further pages being claimed, and resumes any parked lanes so they can finish
+   */
+  void fail(std::shared_ptr<Export> ex) {
+    long resume;
+    {
+      std::lock_guard<std::mutex> lck(ex->mutex);
+      ex->ok = false;
+      resume = ex->parked;
+      ex->parked = 0;
+    }
+    for (long lane = 0;lane < resume;lane++) {
+      exportLane(ex);
+    }
+  }
+
+  /*
+   * Call with the export's lock held. Completes the export once the last lane has finished.
+   */
+  void finishLane(Export& ex) {
+    if (0 != --ex.activeLanes) {
+      return;
+    }
+    for (auto& page : ex.ready) {
+      for (auto& res : page.second) {
+        delete res; // never consumed, as an earlier page failed
+      }
+    }
+    ex.ready.clear();
+    ex.done.set(ex.ok.load());
+  }
+
+  /*
+   * Passes each result to the consumer, deleting them afterwards if owned. Returns false if the consumer throws.
+   */
+  bool consume(ISearchResultConsumer* consumer,std::vector<SearchResult*>& results,const bool owned,
+      std::mutex* lock = nullptr) {
+    bool ok = true;
+    {
+      std::unique_lock<std::mutex> lck;
+      if (nullptr != lock) {
+        lck = std::unique_lock<std::mutex>(*lock);
+      }
+      try {
+        for (auto& res : results) {
+          consumer->consume(*res);
+        }
+      } catch (std::exception& ref) {
+        LOG(DEBUG) << "SearchResultSet export consumer threw: " << ref.what();
+        setFetchException(ref);
+        ok = false;
+      }
+    }
+    if (owned) {
+      for (auto& res : results) {
+        delete res;
+      }
+    }
+    return ok;
+  }
+
+  /*
+   * Call from the catch block handling ref, so the exception itself is kept to rethrow. The first is kept.
+   */
+  void setFetchException(const std::exception& ref) {
+    std::lock_guard<std::mutex> lck(exceptionMutex);
+    mFetchException = ref;
+    if (!fetchError) {
+      fetchError = std::current_exception();
+    }
+  }
 
   SearchResult* getResult(long position) {
     //std::unique_lock<std::mutex> lck (resultsMtx,std::defer_lock);
     //lck.lock();
+    if (streaming) {
+      if (position > lastFetched.load() || position < 0 || ring.empty() ||
+          position <= lastFetched.load() - (long)ring.size()) {
+        throw std::out_of_range("SearchResultSet result is not held in the streaming window");
+      }
+      return ring[position % ring.size()];
+    }
     SearchResult* res = mResults.at(position);
     //lck.unlock();
     return res;
@@ -541,8 +834,24 @@ public:
   long m_maxResults; // max number of results to return across all requests (total)
 
   // 0 based - i.e. for 500 results, at start it would be -1, at end it would 499
-  long lastFetched;
+  // Atomic as it is set by the fetching thread once a page's results are appended, and read by the iterating thread
+  std::atomic<long> lastFetched;
   pplx::task<void>* fetchTask;
+
+  long maxReadAhead; // the most pages in flight at once
+  long readAhead; // the pages in flight at once currently, adapting between 1 and maxReadAhead
+  long nextStart; // 1 based start of the next page to request, or 0 if the initial page is not yet handled
+  long requestPageLength;
+  long lastAdaptedPage;
+  std::deque<pplx::task<void>> inflight; // in page order. Each completes once its page's results are appended.
+  pplx::task<void> lastHandled;
+  std::string timestamp; // the point in time of the initial page, as reported by the server. Pins export pages only.
+  std::mutex exceptionMutex; // guards mFetchException and fetchError. Export pages complete concurrently.
+  std::exception_ptr fetchError; // the first failure, to rethrow
+  std::atomic<bool> fetchFailed; // set once any page has failed
+  bool streaming; // if set, results are held in ring rather than mResults
+  std::vector<SearchResult*> ring; // result i is at i % ring.size(), sized once the initial page is handled
+  long consumerIndex; // 0 based index of the result the iterator is moving to
   //std::mutex fetchMtx;
   //std::mutex resultsMtx;
 };
@@ -565,8 +874,21 @@ bool SearchResultSet::fetch() {
   return mImpl->fetchInitial();
 }
 
+pplx::task<bool> SearchResultSet::fetchAsync() {
+  return mImpl->fetchInitialAsync();
+}
+
+bool SearchResultSet::exportAll(ISearchResultConsumer* consumer,const long parallelPages,const bool ordered) {
+  return mImpl->exportAllAsync(consumer,parallelPages,ordered).get();
+}
+
+pplx::task<bool> SearchResultSet::exportAllAsync(ISearchResultConsumer* consumer,const long parallelPages,const bool ordered) {
+  return mImpl->exportAllAsync(consumer,parallelPages,ordered);
+}
+
 std::exception SearchResultSet::getFetchException() {
   //TIMED_FUNC(SearchResultSet_getFetchException);
+  std::lock_guard<std::mutex> lck(mImpl->exceptionMutex);
   return mImpl->mFetchException;
 }
 
@@ -579,6 +901,7 @@ void SearchResultSet::setMaxResults(long maxResults) {
 SearchResultSetIterator* SearchResultSet::begin() const {
   //TIMED_FUNC(SearchResultSet_begin);
   //return mImpl->mResults.begin();
+  mImpl->fetchNext(0); // start reading ahead straight away
   SearchResultSetIterator* beginIter = mImpl->mIter->begin();
   mImpl->mCachedEnd = mImpl->mIter->end(); // cache end iterator to prevent poorly written code from instantiating many iterator instances
   return beginIter;
@@ -590,6 +913,25 @@ SearchResultSetIterator* SearchResultSet::end() const {
 }
 
 
+void SearchResultSet::setReadAhead(const long maxPages) {
+  mImpl->maxReadAhead = (maxPages < 1) ? 1 : maxPages;
+  mImpl->readAhead = std::min(mImpl->readAhead,mImpl->maxReadAhead);
+}
+
+const long SearchResultSet::getReadAhead() const {
+  return mImpl->maxReadAhead;
+}
+
+void SearchResultSet::setStreaming(const bool streaming) {
+  if (nullptr == mImpl->fetchTask) {
+    mImpl->streaming = streaming;
+  }
+}
+
+const bool SearchResultSet::isStreaming() const {
+  return mImpl->streaming;
+}
+
 const long SearchResultSet::getStart() {
   //TIMED_FUNC(SearchResultSet_getStart);
   return mImpl->start;
@@ -703,15 +1045,11 @@ void SearchResultSetIterator::operator++() {
     // check if we've just started the next result set
     if (position > lastFetched) { // this is not lastFetched + 1 as we haven't incremented position yet!!! That gets done at the END of the function
       // need next result set NOW
-      //LOG(DEBUG) << "At end of result set - calling fetchNext...";
-      if (mResultSet->mImpl->fetchNext()) {
-        mResultSet->mImpl->wait();
-      }
-    }
-    if (position > lastFetched + 1 - mResultSet->mImpl->pageLength) {
-      // within 1 page of the end - go fetch more results
-      //LOG(DEBUG) << "On last page of result set - calling fetchNext (lastFetched currently: " << lastFetched << ", position currently: " << position << ", maxResults currently: " << mResultSet->mImpl->m_maxResults << ")...";
-      mResultSet->mImpl->fetchNext();
+      //LOG(DEBUG) << "At end of result set - waiting for the next page...";
+      mResultSet->mImpl->waitFor(position);
+    } else {
+      // keep the read ahead pages in flight
+      mResultSet->mImpl->fetchNext(position);
     }
 
     /*
@@ -13,6 +13,9 @@
 #include <cpprest/http_client.h>
 
 #include <map>
+#include <exception>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace mlclient {
@@ -91,41 +94,32 @@ bool ValuesResultSet::fetch() {
   long i = 0;
   pplx::task<void>* fetchTask;
   for (auto iter = mImpl->values.begin(); iter != mImpl->values.end();++iter) {
-    fetchTask = new pplx::task<void>([&refImpl,iter] () {
-      LOG(DEBUG) << "Began values fetch task...";
-      LOG(DEBUG) << "Got iter reference";
+    LOG(DEBUG) << "valuesName: " << iter->getValuesName() << ", optionsName: " << iter->getOptionsName();
+    ResponseTask request;
+    try {
+      request = refImpl.mConn->valuesAsync(iter->getValuesName(),iter->getOptionsName());
+    } catch (...) {
+      request = pplx::task_from_exception<std::shared_ptr<Response>>(std::current_exception()); // reported below
+    }
+    // no thread waits for the response - the result is filled in by a continuation
+    fetchTask = new pplx::task<void>(request.then(
+        [&refImpl,iter] (ResponseTask task) {
+      LOG(DEBUG) << "Began values fetch continuation...";
 
       try {
-        LOG(DEBUG) << "In try";
-        LOG(DEBUG) << "valuesName: " << iter->getValuesName() << ", optionsName: " << iter->getOptionsName();
-        Response* resp = refImpl.mConn->values(iter->getValuesName(),iter->getOptionsName());
+        std::shared_ptr<Response> resp = task.get(); // already complete
+        if (!resp) {
+          throw std::runtime_error("No response received for values lookup " + iter->getValuesName());
+        }
         LOG(DEBUG) << "Got response";
 
         mlclient::utilities::ResponseHelper::getAggregateResults(*resp,*iter);
-/*
-        if (iter->hasAggregates()) { // implement function
-          LOG(DEBUG) << "Has aggregates";
-          //std::vector<ValuesResultAggregate> vars = result.getAggregates(); // normally only one result...
-          for (auto varIter = iter->aggregateBegin(); varIter != iter->aggregateEnd();++varIter) { // TODO MAKE ITER VALUE NON CONST
-            LOG(DEBUG) << "In aggregate loop";
-            ValuesResultAggregate var = *varIter;
-            LOG(DEBUG) << "Got aggregate reference";
-            var.value = mlclient::utilities::ResponseHelper::getAggregateResult(*resp,var.name); // double
-            LOG(DEBUG) << " set aggregate value";
-          }
-        }
-        */
-
-        LOG(DEBUG) << "Deleting response";
-        delete(resp);
-        LOG(DEBUG) << "Response deleted";
       } catch (std::exception& ref) {
         LOG(DEBUG) << "Exception in initial fetch task: " << ref.what();
         refImpl.exception = ref;
       }
-      LOG(DEBUG) << "End values fetch task";
-
-    });
+      LOG(DEBUG) << "End values fetch continuation";
+    }));
     LOG(DEBUG) << "Inserting task";
     mImpl->tasks.insert(std::make_pair(i++,fetchTask)); // end task initialisation
 
@@ -20,6 +20,9 @@
 // our API includes
 #include "mlclient/internals/AuthenticatingProxy.hpp"
 #include "mlclient/internals/Credentials.hpp"
+#include "mlclient/internals/FileStream.hpp"
+#include "mlclient/internals/HttpClientPool.hpp"
+#include "mlclient/internals/MultipartStream.hpp"
 
 #include "mlclient/NoCredentialsException.hpp"
 #include "mlclient/Response.hpp"
@@ -42,6 +45,8 @@
 #include <string>
 #include <iostream>
 #include <istream>
+#include <stdexcept>
+#include <chrono>
 
 
 namespace mlclient {
@@ -51,10 +56,14 @@ using namespace web::http;
 
 const utility::string_t AUTHORIZATION_HEADER_NAME = U("Authorization");
 const utility::string_t WWW_AUTHENTICATE_HEADER = U("WWW-Authenticate");
+const utility::string_t ACCEPT_HEADER_NAME = U("Accept");
 const std::string WWW_AUTHENTICATE_HEADER_INT = "WWW-Authenticate";
 
 const std::string DEFAULT_KEY = "__DEFAULT";
 
+const unsigned int DEFAULT_MAX_IN_FLIGHT = 8;
+const std::size_t DEFAULT_AUTH_PROBE_THRESHOLD = 64 * 1024;
+
 using namespace utility;                    // Common utilities like string conversions
 using namespace utility::conversions;       // String conversions
 using namespace web;                        // Common features like URIs.
@@ -63,10 +72,36 @@ using namespace web::http::client;          // HTTP client features
 //using namespace concurrency::streams;       // Asynchronous streams
 using namespace mlclient;
 
-AuthenticatingProxy::AuthenticatingProxy() : credentials(),attempts(0),restMutex()
+AuthenticatingProxy::AuthenticatingProxy() : credentials(),attempts(0),clientPool(nullptr),
+    allLimiter(DEFAULT_MAX_IN_FLIGHT),readLimiter(0),writeLimiter(0),authMutex(),authStats(),
+    authProbeThreshold(DEFAULT_AUTH_PROBE_THRESHOLD)
 {
 }
 
+void AuthenticatingProxy::setClientPool(HttpClientPool* pool) {
+  clientPool = pool;
+}
+
+void AuthenticatingProxy::setMaxInFlight(const unsigned int max) {
+  allLimiter.setLimit(max);
+}
+
+void AuthenticatingProxy::setMaxInFlightReads(const unsigned int max) {
+  readLimiter.setLimit(max);
+}
+
+void AuthenticatingProxy::setMaxInFlightWrites(const unsigned int max) {
+  writeLimiter.setLimit(max);
+}
+
+unsigned int AuthenticatingProxy::getInFlight() const {
+  return allLimiter.getInFlight();
+}
+
+void AuthenticatingProxy::setAuthProbeThreshold(const std::size_t bytes) {
+  authProbeThreshold = bytes;
+}
+
 void AuthenticatingProxy::copyHeaders(const web::http::http_headers& from, mlclient::HttpHeaders& to) {
   std::map<std::string,std::string> headers;
   LOG(DEBUG) << "Headers:-";
@@ -79,6 +114,7 @@ void AuthenticatingProxy::copyHeaders(const web::http::http_headers& from, mlcli
 
 void AuthenticatingProxy::addCredentials(const internals::Credentials &c)
 {
+  std::lock_guard<std::mutex> lck(authMutex);
   credentials = c;
 }
 
@@ -86,305 +122,267 @@ const Credentials& AuthenticatingProxy::getCredentials() const {
   return credentials;
 }
 
-Response* AuthenticatingProxy::doRequest(const std::string& method,const std::string& host,const std::string& path,const HttpHeaders& headers, const IDocumentContent* body) {
-
-  TIMED_FUNC(AuthenticatingProxy_doRequest);
-  LOG(DEBUG) << "doRequest: method: " << method << " host: " << host << " path: " << path;
+http_request AuthenticatingProxy::buildRequest(const std::string& method,const std::string& path,const HttpHeaders& headers,
+    const std::string& authorization,const utility::string_t* bodyString,std::istream* bodyStream,
+    const utility::size64_t streamLength,const utility::string_t& mimeString) {
+  TIMED_FUNC(AuthenticatingProxy_buildRequest);
+  http::http_request req(utility::conversions::to_string_t(method));
+  http_headers& restHeaders = req.headers(); // MUST BE A REFERENCE - DO NOT INVOKE COPY CONSTRUCTOR!!!
+  // copy additional headers - e.g. Accept: or Content-type: (For POST/PUT)
+  for (auto& iter : headers.getHeaders()) {
+    if (restHeaders.has(utility::conversions::to_string_t(iter.first))) { // TODO verify that map doesn't handle duplicates for us. If it does, remove this check.
+      restHeaders.remove(utility::conversions::to_string_t(iter.first));
+    }
+    restHeaders.add(utility::conversions::to_string_t(iter.first), utility::conversions::to_string_t(iter.second));
+  }
+  if (!restHeaders.has(ACCEPT_HEADER_NAME)) {
+    restHeaders.add(ACCEPT_HEADER_NAME,U(IDocumentContent::MIME_JSON)); // default to JSON response type for MarkLogic
+  }
+  req.set_request_uri(web::uri(utility::conversions::to_string_t(path)));
 
-  http_client raw_client(utility::conversions::to_string_t(host)); // TODO can we re-use these???
+  if (!authorization.empty()) {
+    restHeaders.add(AUTHORIZATION_HEADER_NAME, utility::conversions::to_string_t(authorization));
+  }
 
-  std::string responseAuthHeaderValue = "";
+  if (nullptr != bodyStream) {
+    // Stream from the content rather than reading it in to memory. Rewind first, as this may be a re-send after a 401.
+    bodyStream->clear();
+    bodyStream->seekg(0,std::ios::beg);
+    if (bodyStream->fail()) {
+      throw std::runtime_error("Request body stream cannot be rewound to re-send it");
+    }
+    req.set_body(concurrency::streams::stdio_istream<uint8_t>(*bodyStream),streamLength,mimeString);
+  } else if (nullptr != bodyString) {
+    req.set_body(*bodyString,mimeString);
+  }
+  return req;
+}
 
-  std::map<std::string,std::string> hs = headers.getHeaders();
+ResponseTask AuthenticatingProxy::toResponseAsync(http_response raw_response) {
+  // Read the raw bytes straight in to a string (no charset conversion), which the Response then takes ownership of.
+  // This is the only copy of the body made between the socket and the JSON/XML parsers.
+  return raw_response.extract_utf8string(true).then([raw_response] (std::string body) {
+    TIMED_FUNC(AuthenticatingProxy_toResponse);
+    std::shared_ptr<Response> response = std::make_shared<Response>();
+    response->setResponseCode((ResponseCode)raw_response.status_code());
+    HttpHeaders h;
+    AuthenticatingProxy::copyHeaders(raw_response.headers(),h);
+    response->setResponseHeaders(h); // also sets response type via Content-type header
+
+    response->setContent(std::move(body));
+    return response;
+  });
+}
 
-  // TODO can we already pre-authenticate?
+std::string AuthenticatingProxy::authorizationFor(const std::string& method,const std::string& path,const std::string* challenge) {
+  std::lock_guard<std::mutex> lck(authMutex); // credentials nonce state is shared by all requests on this connection
+  if (nullptr != challenge) {
+    authStats.challenges++;
+    credentials.parseWWWAuthenticateHeader(*challenge);
+    if (credentials.isStale()) {
+      authStats.staleChallenges++;
+    }
+  }
+  if (!credentials.canAuthenticate()) {
+    return "";
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::string header(credentials.authenticate(method, path));
+  authStats.headerBuilds++;
+  authStats.headerBuildNanos += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  return header;
+}
 
-  bool authorised = true;
+AuthenticationStats AuthenticatingProxy::getAuthenticationStats() const {
+  std::lock_guard<std::mutex> lck(authMutex);
+  return authStats;
+}
 
+/*
+ * Everything a single request needs across its continuations. Shared by them all, so the permit and
+ * client lease are released once the last continuation has run.
+ */
+struct RequestState {
+  std::string method;
+  RequestClass requestClass;
+  std::string host;
+  std::string path;
+  HttpHeaders headers;
   utility::string_t bodyString;
+  std::unique_ptr<std::istream> bodyStream; // if set, the body is streamed from here rather than bodyString
+  utility::size64_t streamLength;
   utility::string_t mimeString;
+  bool hasBody;
+  std::unique_ptr<ConcurrencyPermit> permit;
+  std::unique_ptr<HttpClientLease> lease;
 
+  const utility::string_t* body() const {
+    return (hasBody && !bodyStream) ? &bodyString : nullptr;
+  }
 
-  try {
-    http::http_request req(utility::conversions::to_string_t(method)); // TODO can we re-use these???
-    http_headers& restHeaders = req.headers(); // MUST BE A REFERENCE - DO NOT INVOKE COPY CONSTRUCTOR!!!
-    // copy additional headers - e.g. Accept: or Content-type: (For POST/PUT)
-    for (auto& iter : hs) {
-      if (restHeaders.has(utility::conversions::to_string_t(iter.first))) { // TODO verify that map doesn't handle duplicates for us. If it does, remove this check.
-        restHeaders.remove(utility::conversions::to_string_t(iter.first));
-      }
-      restHeaders.add(utility::conversions::to_string_t(iter.first), utility::conversions::to_string_t(iter.second));
-    }
-    // TODO common string constants to pre-created variables
-    if (!restHeaders.has(U("Accept"))) {
-      restHeaders.add(U("Accept"),U(IDocumentContent::MIME_JSON)); // default to JSON response type for MarkLogic
-    }
-    req.set_request_uri(web::uri(utility::conversions::to_string_t(path)));
+  std::istream* stream() const {
+    return bodyStream.get();
+  }
 
-    if (credentials.canAuthenticate()) {
-      LOG(DEBUG) << "Attempting to authenticate on first attempt";
-      restHeaders.add(AUTHORIZATION_HEADER_NAME, utility::conversions::to_string_t(credentials.authenticate(("" + method), path)));
-    } else {
-      LOG(DEBUG) << "Not authenticating on first attempt";
+  utility::size64_t bodyBytes() const {
+    if (!hasBody) {
+      return 0;
     }
-
-    if (nullptr != body) {
-      bodyString = utility::conversions::to_string_t(body->getContent());
-      mimeString = utility::conversions::to_string_t(body->getMimeType());
-      // GOD AWFUL HACK
-      if (utility::conversions::to_string_t("multipart/mime") == mimeString) {
-        mimeString = utility::conversions::to_string_t("multipart/mime; boundary=BOUNDARY");
-      }
-      LOG(DEBUG) << "Body is not null on FIRST try";
-      LOG(DEBUG) << "  mimeString: " << utility::conversions::to_utf8string(mimeString);
-      LOG(DEBUG) << "  bodyString: " << utility::conversions::to_utf8string(bodyString);
-      // TODO Any way to stream the below rather than convert in memory?
-      req.set_body(bodyString,mimeString);
-      //req.set_body(*(body->getStream()),utility::conversions::to_string_t(body->getMimeType()));
+    return bodyStream ? streamLength : bodyString.size() * sizeof(utility::string_t::value_type);
+  }
+};
+
+ResponseTask AuthenticatingProxy::doRequestAsync(const std::string& method,const RequestClass requestClass,const std::string& host,
+    const std::string& path,const HttpHeaders& headers, const IDocumentContent* body) {
+
+  TIMED_FUNC(AuthenticatingProxy_doRequestAsync);
+  LOG(DEBUG) << "doRequestAsync: method: " << method << " host: " << host << " path: " << path;
+
+  std::shared_ptr<RequestState> state = std::make_shared<RequestState>();
+  state->method = method;
+  state->requestClass = requestClass;
+  state->host = host;
+  state->path = path;
+  state->headers = headers;
+  state->hasBody = (nullptr != body);
+  state->streamLength = 0;
+  if (nullptr != body) {
+    // Content of a known length (E.g. a file) is streamed, so large uploads use constant memory.
+    // Other content is read now. Either way the caller's body need not outlive this call.
+    const long long streamLength = body->getStreamLength();
+    std::istream* is = (streamLength >= 0) ? body->getStream() : nullptr;
+    if (nullptr != is && is->good()) {
+      state->bodyStream.reset(is);
+      state->streamLength = (utility::size64_t)FileStream::lengthOf(*is,streamLength);
+      LOG(DEBUG) << "  Streaming body of length: " << streamLength;
+    } else {
+      delete is;
+      state->bodyString = utility::conversions::to_string_t(body->getContent());
     }
-
-    /*
-    std::map<std::string,std::string>::const_iterator iter;
-    // print out headers for debug
-    LOG(DEBUG) << "Listing initial request headers:-";
-    for (auto& iter : req.headers()) {
-      LOG(DEBUG) << " header: " << iter.first << " = " << iter.second;
+    state->mimeString = utility::conversions::to_string_t(body->getMimeType());
+    // GOD AWFUL HACK
+    if (utility::conversions::to_string_t("multipart/mime") == state->mimeString) {
+      state->mimeString = utility::conversions::to_string_t("multipart/mime; boundary=BOUNDARY");
     }
-    LOG(DEBUG) << "Finishing listing request headers.";
-    */
-
-    http_response raw_response; // TODO investigate if assignment uses move semantics for speed
+    LOG(DEBUG) << "  mimeString: " << utility::conversions::to_utf8string(state->mimeString);
+  }
+  return sendAsync(state);
+}
 
-    { // PERFORMANCE BRACE
-      TIMED_SCOPE(AuthenticatingProxy_doRequest, "cpprest_httpclient_request");
+ResponseTask AuthenticatingProxy::sendAsync(std::shared_ptr<RequestState> state) {
+  const RequestClass requestClass = state->requestClass;
 
-      // Hold a mutex so that MarkLogic does not hit a DEADLOCK concurrent lock REST issue
-      std::unique_lock<std::mutex> lck (restMutex,std::defer_lock);
-      lck.lock();
-      pplx::task<http_response> hr = raw_client.request(req);
-      //LOG(DEBUG) << "Request body: " << utility::conversions::to_utf8string(req.to_string());
+  // Bound the number of requests in flight, rather than serialising them all. Waiting for a slot does not block a thread.
+  ConcurrencyLimiter* classLimiter = (RequestClass::READ == requestClass) ? &readLimiter : &writeLimiter;
+  ConcurrencyLimiter* overallLimiter = &allLimiter;
 
-      raw_response = hr.get();
-      lck.unlock();
+  return classLimiter->acquireAsync().then([overallLimiter] () {
+    return overallLimiter->acquireAsync();
+  }).then([this,state,classLimiter,overallLimiter] () -> pplx::task<std::string> {
+    state->permit.reset(new ConcurrencyPermit(classLimiter,overallLimiter,std::adopt_lock)); // held across the auth retry too
+    state->lease.reset(new HttpClientLease(clientPool,state->host)); // returned to the pool (if healthy) once complete
 
-    } // PERFORMANCE BRACE
-    try
+    // Preemptive authentication - once we have seen a challenge we re-use its nonce with an incrementing nc
     {
-      Response* response = new Response;
-      response->setResponseCode((ResponseCode)raw_response.status_code());
-      HttpHeaders h;
-      AuthenticatingProxy::copyHeaders(raw_response.headers(),h);
-      response->setResponseHeaders(h); // also sets response type via Content-type header
-
-      std::vector<unsigned char> vec = raw_response.extract_vector().get();
-      std::string str;
-      str.reserve(vec.size());
-      str.assign(vec.begin(),vec.end());
-      response->setContent(str);
-      /*
-      if (response->getResponseType() == ResponseType::BINARY) {
-        LOG(DEBUG) << "AuthenticatingProxy - Got binary response";
-        std::vector<unsigned char> vec = raw_response.extract_vector().get();
-        // convert to binary content, or store for now...
-
-        std::string* str = new std::string;
-        str->reserve(vec.size());
-        str->assign(vec.begin(),vec.end());
-        response->setContent(str);
-
-
-        std::string str;
-        str.reserve(vec.size());
-        str.assign(vec.begin(),vec.end());
-        response->setContent(str);
-      } else {
-        LOG(DEBUG) << "AuthenticatingProxy - Got text response";
-        std::vector<unsigned char> vec = raw_response.extract_vector().get();
-        std::string str;
-        str.reserve(vec.size());
-        str.assign(vec.begin(),vec.end());
-        response->setContent(str);
-        //response->setContent(new std::string(utility::conversions::to_utf8string(raw_response.extract_string().get())));
-      }
-      */
-      responseAuthHeaderValue = utility::conversions::to_utf8string(raw_response.headers()[WWW_AUTHENTICATE_HEADER]);
-
-      /*
-      LOG(DEBUG) << "Listing response object headers:-";
-      for (auto& iter : response->getResponseHeaders().getHeaders()) {
-        LOG(DEBUG) << " header name: " << iter.first;
-        LOG(DEBUG) << "  value = " << iter.second;
-      }
-      LOG(DEBUG) << "Finishing listing response object headers.";
-      */
-
-      //std::unique_ptr<std::string> c(new std::string(raw_response.extract_string().get()));
-      // TODO replace with setContent(StringDocument()) ??? would it avoid a conversion at all???
-      //response->setContent(new std::string(utility::conversions::to_utf8string(raw_response.extract_string().get()))); // TODO handle binary response types
-
-      if (response->getResponseCode() != ResponseCode::UNAUTHORIZED) {
-        return response;
-      } else {
-        authorised = false;
-      }
-
+      std::lock_guard<std::mutex> lck(authMutex);
+      authStats.requests++;
     }
-    catch (const http_exception& e)
-    {
-      // Print error.
-      LOG(DEBUG) << "There was an error extracting content from response: " << e.what();
+    std::string authorization(authorizationFor(state->method, state->path, nullptr));
+    if (!authorization.empty()) {
+      LOG(DEBUG) << "Attempting to authenticate on first attempt";
+      std::lock_guard<std::mutex> lck(authMutex);
+      authStats.preemptive++;
+      return pplx::task_from_result(authorization);
     }
-
-  } catch(std::exception &e) {
-    LOG(DEBUG) << "Exception " << e.what();
-    //std::cerr << e.what() << std::endl;
-  }
-
-  if (!authorised) {
+    if (state->hasBody && 0 != authProbeThreshold && state->bodyBytes() >= authProbeThreshold) {
+      // We have no nonce yet, and don't want to upload a large body only for it to be rejected with a 401.
+      // HEAD has no side effects (even if the server does not require auth), so use it to fetch the challenge.
+      LOG(DEBUG) << "Large body with no nonce - probing for an authentication challenge first";
+      return state->lease->client().request(
+          buildRequest(utility::conversions::to_utf8string(http::methods::HEAD),state->path,blankHeaders,"",nullptr,nullptr,0,
+              state->mimeString)
+      ).then([this,state] (pplx::task<http_response> probe) -> std::string {
+        try {
+          http_response probe_response = probe.get();
+          {
+            std::lock_guard<std::mutex> lck(authMutex);
+            authStats.probes++;
+          }
+          if (ResponseCode::UNAUTHORIZED == (ResponseCode)probe_response.status_code()) {
+            std::string challenge(utility::conversions::to_utf8string(probe_response.headers()[WWW_AUTHENTICATE_HEADER]));
+            return authorizationFor(state->method, state->path, &challenge);
+          }
+        } catch(std::exception &e) {
+          LOG(DEBUG) << "Authentication probe failed, continuing without: " << e.what();
+        }
+        return std::string();
+      });
+    }
+    LOG(DEBUG) << "Not authenticating on first attempt";
+    return pplx::task_from_result(std::string());
+  }).then([state] (std::string authorization) {
+    return state->lease->client().request(
+        buildRequest(state->method,state->path,state->headers,authorization,state->body(),state->stream(),state->streamLength,
+            state->mimeString));
+  }).then([this,state] (http_response raw_response) -> ResponseTask {
+    if (ResponseCode::UNAUTHORIZED != (ResponseCode)raw_response.status_code()) {
+      return toResponseAsync(raw_response);
+    }
+    // Only a 401 (including a stale nonce) costs us the extra round trip
+    std::string responseAuthHeaderValue(utility::conversions::to_utf8string(raw_response.headers()[WWW_AUTHENTICATE_HEADER]));
     LOG(DEBUG) << "Unauthorised. Retrying...";
-    //LOG(DEBUG) << "UNAUTHORIZED";
-    /*
-    LOG(DEBUG) << "Listing headers fetched from response:-";
-    for (auto& iter : response_headers.getHeaders()) {
-      LOG(DEBUG) << " header: " << iter.first << " = " << iter.second;
+    LOG(DEBUG) << "Original auth response was: " << responseAuthHeaderValue;
+    std::string authorization(authorizationFor(state->method, state->path, &responseAuthHeaderValue));
+    LOG(DEBUG) << "Auth header: " << authorization;
+    if (state->hasBody) {
+      std::lock_guard<std::mutex> lck(authMutex);
+      authStats.retransmittedBodyBytes += state->bodyBytes();
     }
-    LOG(DEBUG) << "Finishing listing headers fetched from response.";
-    */
-
-    // TODO I don't think the following is ever called... verify it.
-    // TODO verify if the first request used is a POST, the following does not error (IT SPECIFIED GET AS THE METHOD!!!)
+    return state->lease->client().request(
+        buildRequest(state->method,state->path,state->headers,authorization,state->body(),state->stream(),state->streamLength,
+            state->mimeString)
+    ).then([] (http_response retry_response) {
+      LOG(DEBUG) << "Final response...";
+      return toResponseAsync(retry_response);
+    });
+  }).then([state] (ResponseTask result) {
+    // Release our client and in flight slot now, rather than whenever the continuation chain is destroyed
     try {
-      http::http_request req(utility::conversions::to_string_t(method));
-      req.set_request_uri(web::uri(utility::conversions::to_string_t(path)));
-
-      // print out all headers from response
-/*
-      LOG(DEBUG) << "Listing Unauth response headers:-";
-      for (auto& iter : response_headers.getHeaders()) {
-        LOG(DEBUG) << " header: " << iter.first << " = " << iter.second;
-      }
-      LOG(DEBUG) << "Finishing listing unauth response headers.";
-      LOG(DEBUG) << "Value of www authenticate: " << WWW_AUTHENTICATE_HEADER;
-      */
-
-
-      std::map<std::string,std::string>::const_iterator iter;
-      std::map<std::string,std::string> hs = headers.getHeaders();
-      http_headers& restHeaders = req.headers(); // MUST BE A REFERENCE - DO NOT INVOKE COPY CONSTRUCTOR!!!
-      for (auto& iter : hs) {
-        if (restHeaders.has(utility::conversions::to_string_t(iter.first))) { // TODO verify that map doesn't handle duplicates for us. If it does, remove this check.
-          restHeaders.remove(utility::conversions::to_string_t(iter.first));
-        }
-        restHeaders.add(utility::conversions::to_string_t(iter.first), utility::conversions::to_string_t(iter.second));
-      }
-      // TODO common string constants to pre-created variables
-      if (!restHeaders.has(U("Accept"))) {
-        restHeaders.add(U("Accept"),U(IDocumentContent::MIME_JSON)); // default to JSON response type for MarkLogic
-      }
-      LOG(DEBUG) << "Generating auth header";
-      LOG(DEBUG) << "Original auth response was: " << responseAuthHeaderValue;
-      std::string av(credentials.authenticate(("" + method), path, responseAuthHeaderValue));
-      LOG(DEBUG) << "Auth header: " << av;
-      LOG(DEBUG) << "Auth header name: " << utility::conversions::to_utf8string(AUTHORIZATION_HEADER_NAME);
-      restHeaders.add(
-          AUTHORIZATION_HEADER_NAME,
-        utility::conversions::to_string_t(av)
-      );
-      LOG(DEBUG) << "Start of request headers";
-      for (auto& iter : req.headers()) {
-        LOG(DEBUG) << "  Request Header: " << utility::conversions::to_utf8string(iter.first) << "='" << utility::conversions::to_utf8string(iter.second) << "'";
-      }
-      LOG(DEBUG) << "End of request headers";
-
-      if (nullptr != body) {
-        LOG(DEBUG) << "Request body is not null on retry";
-        LOG(DEBUG) << "  mimeString: " << utility::conversions::to_utf8string(mimeString);
-        LOG(DEBUG) << "  bodyString: " << utility::conversions::to_utf8string(bodyString);
-        req.set_body(bodyString,mimeString);
-        //req.set_body(utility::conversions::to_string_t(body->getContent()), utility::conversions::to_string_t(body->getMimeType()));
-        //concurrency::streams::stdio_istream
-        //std::istream* isp = body->getStream();
-        //concurrency::streams::stdio_istream is(*isp);
-        //req.set_body(is, utility::conversions::to_string_t(body->getMimeType()));
-
-        //std::ifstream InFile( FileName, std::ifstream::binary );
-        //std::vector<unsigned char> data( ( std::istreambuf_iterator<unsigned char>( *isp ) ), std::istreambuf_iterator<unsigned char>() );
-        //req.headers().add(U("Content-type"),utility::conversions::to_string_t(body->getMimeType()));
-        //req.set_body(data);
-      } else {
-        LOG(DEBUG) << "Request body IS null on retry";
-      }
-      /*
-      LOG(DEBUG) << "Listing request headers post auth calculation:-";
-      for (auto& iter : req.headers()) {
-        LOG(DEBUG) << " header: " << iter.first << " = " << iter.second;
-      }
-      LOG(DEBUG) << "Finishing listing request headers.";
-      */
-
-      http_response raw_response;// = raw_client.request(req).get();
-      { // PERFORMANCE BRACE
-        TIMED_SCOPE(AuthenticatingProxy_doRequest, "cpprest_httpclient_request");
-        std::unique_lock<std::mutex> lck (restMutex,std::defer_lock);
-        lck.lock();
-        pplx::task<http_response> hr = raw_client.request(req);
-        //LOG(DEBUG) << "Retry Request body: " << utility::conversions::to_utf8string(req.to_string());
-
-        raw_response = hr.get();
-        lck.unlock();
-
-      } // PERFORMANCE BRACE
-
-      try
-      {
-        LOG(DEBUG) << "Final response...";
-
-        Response* response = new Response;
-        response->setResponseCode((ResponseCode)raw_response.status_code());
-        HttpHeaders h;
-        AuthenticatingProxy::copyHeaders(raw_response.headers(),h);
-        response->setResponseHeaders(h); // also sets response type via Content-type header
-
-        std::vector<unsigned char> vec = raw_response.extract_vector().get();
-        std::string str;
-        str.reserve(vec.size());
-        str.assign(vec.begin(),vec.end());
-        response->setContent(str);
-        /*
-        if (response->getResponseType() == ResponseType::BINARY) {
-          LOG(DEBUG) << "AuthenticatingProxy - Got binary response";
-          std::vector<unsigned char> vec = raw_response.extract_vector().get();
-          // convert to binary content, or store for now...
-          std::string* str = new std::string;
-          str->reserve(vec.size());
-          str->assign(vec.begin(),vec.end());
-          response->setContent(str);
-        } else {
-          LOG(DEBUG) << "AuthenticatingProxy - Got text response";
-          response->setContent(new std::string(utility::conversions::to_utf8string(raw_response.extract_string().get())));
-        }
-        */
-
-        LOG(DEBUG) << response->getContent();
-
-        return response;
-      }
-      catch (const web::http::http_exception& e)
-      {
-        // Print error.
-        LOG(DEBUG) << "Error authenticating on second attempt: " << e.what();
-        //std::wostringstream ss;
-        //ss << "There was an error!!!!" << e.what() << std::endl;
-        //std::wcout << ss.str();
+      std::shared_ptr<Response> response = result.get();
+      state->lease.reset();
+      state->permit.reset();
+      return response;
+    } catch (std::exception& e) {
+      LOG(DEBUG) << "Exception sending request: " << e.what();
+      if (state->lease) {
+        state->lease->markFailed(); // don't re-use a client whose connection may be broken
       }
+      state->lease.reset();
+      state->permit.reset();
+      throw;
+    }
+  });
+}
 
-    } catch(std::exception &e) {
-      LOG(DEBUG) << "Overall exception: " << e.what();
-      //std::cerr << e.what() << std::endl;
+Response* AuthenticatingProxy::waitFor(ResponseTask task) {
+  TIMED_FUNC(AuthenticatingProxy_waitFor);
+  try {
+    std::shared_ptr<Response> response = task.get();
+    if (!response) {
+      return nullptr;
     }
+    return new Response(std::move(*response)); // moves the body, no copy
+  } catch (std::exception& e) {
+    LOG(DEBUG) << "Request failed: " << e.what();
   }
+  return nullptr;
+}
 
-  return nullptr; // return the same inout parameter to indicate more obviously that we change it
+Response* AuthenticatingProxy::doRequest(const std::string& method,const RequestClass requestClass,const std::string& host,
+    const std::string& path,const HttpHeaders& headers, const IDocumentContent* body) {
+  TIMED_FUNC(AuthenticatingProxy_doRequest);
+  return waitFor(doRequestAsync(method,requestClass,host,path,headers,body));
 }
 
 Response* AuthenticatingProxy::getSync(const std::string& host,
@@ -392,7 +390,7 @@ Response* AuthenticatingProxy::getSync(const std::string& host,
     const mlclient::HttpHeaders& headers)
 {
   TIMED_FUNC(AuthenticatingProxy_getSync);
-  Response* response = this->doRequest(utility::conversions::to_utf8string(http::methods::GET),host,path,headers,nullptr);
+  Response* response = this->doRequest(utility::conversions::to_utf8string(http::methods::GET),RequestClass::READ,host,path,headers,nullptr);
 
   return response;
 }
@@ -401,110 +399,109 @@ Response* AuthenticatingProxy::getSync(const std::string& host,
 Response* AuthenticatingProxy::postSync(const std::string& host,
     const std::string& path,
     const IDocumentContent& body,
-    const mlclient::HttpHeaders& headers)
+    const mlclient::HttpHeaders& headers,
+    const RequestClass requestClass)
 {
   TIMED_FUNC(AuthenticatingProxy_postSync);
   LOG(DEBUG) << "    Entering postSync";
-  LOG(DEBUG) << "    Post content: " << body.getContent();
-  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::POST),host,path,headers,&body);
-  LOG(DEBUG) << "    Response content: " << response->getContent();
+  // Not the content itself, which may be a large file that would otherwise be read in to memory just to log it
+  LOG(DEBUG) << "    Post content: " << body.getMimeType() << ", stream length: " << body.getStreamLength();
+  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::POST),requestClass,host,path,headers,&body);
+  if (nullptr != response) {
+    LOG(DEBUG) << "    Response content: " << response->getContent();
+  }
   LOG(DEBUG) << "    Leaving postSync";
 
   return response;
 }
 
-void AuthenticatingProxy::buildBulkPayload(const DocumentSet& set,const long startIdx,const long endIdx, std::ostringstream& sout) {
-  //for (list<Document>::iterator it=set.begin(); it!=set.end(); ++it) {
+std::string AuthenticatingProxy::buildMetadata(const Document& it) {
+  // send properties, collections and permissions too
+  std::ostringstream pos;
+  // TODO specify MIME type based on MIME type of properties document (could be JSON or XML)
+  pos << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+  pos << "<rapi:metadata xmlns:rapi=\"http://marklogic.com/rest-api\">";
+  pos << "  <rapi:quality>1</rapi:quality>";
+  pos << "  <prop:properties xmlns:prop=\"http://marklogic.com/xdmp/property\">";
+  // specify properties here
+  //pos << "    <my-prop>my first property</my-prop>";
+  pos << "  </prop:properties>";
+  pos << "  <rapi:collections>";
+  const std::vector<std::string> cols = it.getCollections();
+  for (auto colsIter = cols.begin(); colsIter != cols.end();++colsIter) {
+    pos << "    <rapi:collection>" << *colsIter << "</rapi:collection>";
+  }
+  pos << "  </rapi:collections>";
+  pos << "  <rapi:permissions>";
+  const std::vector<Permission> perms = it.getPermissions();
+  for (auto permIter = perms.begin(); permIter != perms.end();++permIter) {
+    pos << "    <rapi:permission>";
+    pos << "      <rapi:role-name>" << permIter->getRole() << "</rapi:role-name>";
+    pos << "      <rapi:capability>" << permIter->getCapability() << "</rapi:capability>";
+    pos << "    </rapi:permission>";
+  }
+  pos << "  </rapi:permissions>";
+  pos << "</rapi:metadata>";
+  return pos.str();
+}
+
+void AuthenticatingProxy::buildBulkPayload(const DocumentSet& set,const long startIdx,const long endIdx, MultipartBuffer& out) {
+  TIMED_FUNC(AuthenticatingProxy_buildBulkPayload);
+  // Only part headers and metadata are built here. Content is streamed where possible, else moved in without a further copy.
+  std::string currentDefault;
   for (long i = startIdx;i <= endIdx;i++) {
     const Document& it = set.at(i);
-    sout << "--BOUNDARY\r\n";
-
-    // send properties, collections and permissions too
-
-    GenericTextDocumentContent* tdc = new GenericTextDocumentContent;
-    std::ostringstream pos;
-    // TODO specify MIME type based on MIME type of properties document (could be JSON or XML)
-    pos << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
-    pos << "<rapi:metadata xmlns:rapi=\"http://marklogic.com/rest-api\">";
-    pos << "  <rapi:quality>1</rapi:quality>";
-    pos << "  <prop:properties xmlns:prop=\"http://marklogic.com/xdmp/property\">";
-    // specify properties here
-    //pos << "    <my-prop>my first property</my-prop>";
-    pos << "  </prop:properties>";
-    pos << "  <rapi:collections>";
-    const std::vector<std::string> cols = it.getCollections();
-    for (auto colsIter = cols.begin(); colsIter != cols.end();++colsIter) {
-      pos << "    <rapi:collection>" << *colsIter << "</rapi:collection>";
-    }
-    pos << "  </rapi:collections>";
-    pos << "  <rapi:permissions>";
-    const std::vector<Permission> perms = it.getPermissions();
-    for (auto permIter = perms.begin(); permIter != perms.end();++permIter) {
-      pos << "    <rapi:permission>";
-      pos << "      <rapi:role-name>" << permIter->getRole() << "</rapi:role-name>";
-      pos << "      <rapi:capability>" << permIter->getCapability() << "</rapi:capability>";
-      pos << "    </rapi:permission>";
-    }
-    pos << "  </rapi:permissions>";
-    pos << "</rapi:metadata>";
-    tdc->setContent(pos.str());
-    tdc->setMimeType(mlclient::IDocumentContent::MIME_XML);
 
-    // metadata FIRST
-    sout << "Content-Type: " << tdc->getMimeType() << "\r\n";
-    sout << "Content-Disposition: attachment; filename=\"" << it.getUri() << "\"; category=metadata\r\n";
-    sout << "Content-Length: " << tdc->getLength() << "\r\n";
-    sout << "\r\n";
-    sout << tdc->getContent();
-    sout << "\r\n";
+    const std::string metadata(buildMetadata(it));
+
+    std::ostringstream part;
+    if (metadata != currentDefault) {
+      // A default (inline) metadata part applies to every following document until the next one, so a run of
+      // documents with the same collections and permissions (the usual case) only sends its metadata once
+      part << "--BOUNDARY\r\n";
+      part << "Content-Type: " << mlclient::IDocumentContent::MIME_XML << "\r\n";
+      part << "Content-Disposition: inline; category=metadata\r\n";
+      part << "Content-Length: " << metadata.size() << "\r\n";
+      part << "\r\n";
+      part << metadata;
+      part << "\r\n";
+      currentDefault = metadata;
+    }
 
-    sout << "--BOUNDARY\r\n";
+    part << "--BOUNDARY\r\n";
 
     const IDocumentContent* idc = it.getContent();
-    std::string content = idc->getContent(); // TODO support binary objects
-
-    sout << "Content-Type: " << idc->getMimeType() << "\r\n";
-    sout << "Content-Disposition: attachment;filename=\"" << it.getUri() << "\"\r\n";
-    sout << "Content-Length: " << content.size() << "\r\n";
+    const long long streamLength = idc->getStreamLength();
+    std::unique_ptr<std::istream> stream((streamLength >= 0) ? idc->getStream() : nullptr);
+    std::string content;
+    if (!stream || !stream->good()) {
+      stream.reset();
+      content = idc->getContent();
+    }
+    const std::uint64_t contentLength = stream ? FileStream::lengthOf(*stream,streamLength) : content.size();
 
-    sout << "\r\n";
+    part << "Content-Type: " << idc->getMimeType() << "\r\n";
+    part << "Content-Disposition: attachment;filename=\"" << it.getUri() << "\"\r\n";
+    part << "Content-Length: " << contentLength << "\r\n";
+    part << "\r\n";
+    out.append(part.str());
 
-    sout << content << "\r\n";
+    if (stream) {
+      out.append(std::move(stream),contentLength);
+    } else {
+      out.append(std::move(content));
+    }
+    out.append(std::string("\r\n"));
   }
 
-  sout << "--BOUNDARY--\r\n" << std::endl;
-
-  //cout << "DUMP BULK PAYLOAD - START" << endl;
-  //cout << bulkPayload << endl;
-  //cout << "DUMP BULK PAYLOAD - END" << endl;
-
+  out.append(std::string("--BOUNDARY--\r\n"));
 }
 
 Response* AuthenticatingProxy::multiPostSync(const std::string& host,const std::string& path,
     const DocumentSet& allContent, const long startPosInclusive,
     const long endPosInclusive, const mlclient::HttpHeaders& commonHeaders) {
   TIMED_FUNC(AuthenticatingProxy_multiPostSync);
-  LOG(DEBUG) << "    Entering multiPostSync";
-
-  GenericTextDocumentContent body;
-  body.setMimeType("multipart/mixed");
-  std::ostringstream content;
-  buildBulkPayload(allContent,startPosInclusive,endPosInclusive,content);
-  std::string ct = content.str();
-  body.setContent(ct);
-
-  HttpHeaders headers = commonHeaders; // copy assignment operator
-  headers.setHeader("Content-type","multipart/mixed; boundary=BOUNDARY");
-  headers.setHeader("Accept",IDocumentContent::MIME_JSON);
-  std::ostringstream os;
-  os << ct.length();
-  headers.setHeader("Content-Length",os.str());
-
-  //LOG(DEBUG) << "    Multi Post content: " << body.getContent();
-  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::POST),host,path,headers,&body);
-  LOG(DEBUG) << "    Leaving multiPostSync";
-
-  return response;
+  return waitFor(multiPostAsync(host,path,allContent,startPosInclusive,endPosInclusive,commonHeaders));
 }
 
 Response* AuthenticatingProxy::putSync(const std::string& host,
@@ -513,7 +510,7 @@ Response* AuthenticatingProxy::putSync(const std::string& host,
     const mlclient::HttpHeaders& headers)
 {
   TIMED_FUNC(AuthenticatingProxy_putSync);
-  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::PUT),host,path,headers,&body);
+  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::PUT),RequestClass::WRITE,host,path,headers,&body);
 
   return response;
 }
@@ -523,11 +520,73 @@ Response* AuthenticatingProxy::deleteSync(const std::string& host,
     const mlclient::HttpHeaders& headers)
 {
   TIMED_FUNC(AuthenticatingProxy_deleteSync);
-  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::DEL),host,path,headers,nullptr);
+  Response* response = doRequest(utility::conversions::to_utf8string(http::methods::DEL),RequestClass::WRITE,host,path,headers,nullptr);
 
   return response;
 }
 
+ResponseTask AuthenticatingProxy::getAsync(const std::string& host,
+    const std::string& path,
+    const mlclient::HttpHeaders& headers)
+{
+  return doRequestAsync(utility::conversions::to_utf8string(http::methods::GET),RequestClass::READ,host,path,headers,nullptr);
+}
+
+ResponseTask AuthenticatingProxy::postAsync(const std::string& host,
+    const std::string& path,
+    const IDocumentContent& body,
+    const mlclient::HttpHeaders& headers,
+    const RequestClass requestClass)
+{
+  return doRequestAsync(utility::conversions::to_utf8string(http::methods::POST),requestClass,host,path,headers,&body);
+}
+
+ResponseTask AuthenticatingProxy::multiPostAsync(const std::string& host,const std::string& path,
+    const DocumentSet& allContent, const long startPosInclusive,
+    const long endPosInclusive, const mlclient::HttpHeaders& commonHeaders) {
+  TIMED_FUNC(AuthenticatingProxy_multiPostAsync);
+  LOG(DEBUG) << "    Entering multiPostAsync";
+
+  std::shared_ptr<RequestState> state = std::make_shared<RequestState>();
+  state->method = utility::conversions::to_utf8string(http::methods::POST);
+  state->requestClass = RequestClass::WRITE;
+  state->host = host;
+  state->path = path;
+  state->hasBody = true;
+  state->mimeString = utility::conversions::to_string_t("multipart/mixed; boundary=BOUNDARY");
+
+  // The body is produced as the HTTP layer reads it, rather than being assembled in memory first
+  MultipartStream* multipart = new MultipartStream;
+  state->bodyStream.reset(multipart);
+  buildBulkPayload(allContent,startPosInclusive,endPosInclusive,multipart->buffer());
+  state->streamLength = multipart->buffer().getLength();
+
+  state->headers = commonHeaders; // copy assignment operator
+  state->headers.setHeader("Content-type","multipart/mixed; boundary=BOUNDARY");
+  state->headers.setHeader("Accept",IDocumentContent::MIME_JSON);
+  std::ostringstream os;
+  os << state->streamLength;
+  state->headers.setHeader("Content-Length",os.str());
+
+  return sendAsync(state);
+}
+
+ResponseTask AuthenticatingProxy::putAsync(const std::string& host,
+    const std::string& path,
+    const IDocumentContent& body,
+    const mlclient::HttpHeaders& headers)
+{
+  return doRequestAsync(utility::conversions::to_utf8string(http::methods::PUT),RequestClass::WRITE,host,path,headers,&body);
+}
+
+ResponseTask AuthenticatingProxy::deleteAsync(const std::string& host,
+    const std::string& path,
+    const mlclient::HttpHeaders& headers)
+{
+  return doRequestAsync(utility::conversions::to_utf8string(http::methods::DEL),RequestClass::WRITE,host,path,headers,nullptr);
+}
+
+
 } // end internals namespace
 
 } // end mlclient namespace
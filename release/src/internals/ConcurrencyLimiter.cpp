@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * ConcurrencyLimiter.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/ConcurrencyLimiter.hpp"
+
+#include "mlclient/logging.hpp"
+
+#include <vector>
+
+namespace mlclient {
+
+namespace internals {
+
+ConcurrencyLimiter::ConcurrencyLimiter(const unsigned int limit) : mMutex(), mAvailable(), mLimit(limit), mInFlight(0),
+    mAsyncWaiters() {
+  ;
+}
+
+ConcurrencyLimiter::~ConcurrencyLimiter() {
+  ;
+}
+
+void ConcurrencyLimiter::setLimit(const unsigned int limit) {
+  std::vector<pplx::task_completion_event<void>> granted;
+  {
+    std::lock_guard<std::mutex> lck(mMutex);
+    mLimit = limit;
+    while (!mAsyncWaiters.empty() && (0 == mLimit || mInFlight < mLimit)) {
+      mInFlight++;
+      granted.push_back(mAsyncWaiters.front());
+      mAsyncWaiters.pop_front();
+    }
+  }
+  for (auto& tce : granted) {
+    tce.set(); // outside the lock - may run continuations inline
+  }
+  mAvailable.notify_all();
+}
+
+unsigned int ConcurrencyLimiter::getLimit() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  return mLimit;
+}
+
+void ConcurrencyLimiter::acquire() {
+  TIMED_FUNC(ConcurrencyLimiter_acquire);
+  std::unique_lock<std::mutex> lck(mMutex);
+  mAvailable.wait(lck,[this] {return 0 == mLimit || mInFlight < mLimit;});
+  mInFlight++;
+}
+
+pplx::task<void> ConcurrencyLimiter::acquireAsync() {
+  pplx::task_completion_event<void> tce;
+  {
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (0 == mLimit || mInFlight < mLimit) {
+      mInFlight++;
+      return pplx::task_from_result();
+    }
+    mAsyncWaiters.push_back(tce);
+  }
+  return pplx::create_task(tce);
+}
+
+void ConcurrencyLimiter::release() {
+  bool handedOver = false;
+  pplx::task_completion_event<void> next;
+  {
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (!mAsyncWaiters.empty() && (0 == mLimit || mInFlight <= mLimit)) {
+      // hand our permit straight to the longest waiting async caller - mInFlight is unchanged
+      next = mAsyncWaiters.front();
+      mAsyncWaiters.pop_front();
+      handedOver = true;
+    } else if (mInFlight > 0) {
+      mInFlight--;
+    }
+  }
+  if (handedOver) {
+    next.set();
+  } else {
+    mAvailable.notify_one();
+  }
+}
+
+unsigned int ConcurrencyLimiter::getInFlight() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  return mInFlight;
+}
+
+
+
+ConcurrencyPermit::ConcurrencyPermit(ConcurrencyLimiter* first,ConcurrencyLimiter* second) : mFirst(first), mSecond(second) {
+  if (nullptr != mFirst) {
+    mFirst->acquire();
+  }
+  if (nullptr != mSecond) {
+    mSecond->acquire();
+  }
+}
+
+ConcurrencyPermit::ConcurrencyPermit(ConcurrencyLimiter* first,ConcurrencyLimiter* second,std::adopt_lock_t) :
+    mFirst(first), mSecond(second) {
+  ;
+}
+
+ConcurrencyPermit::~ConcurrencyPermit() {
+  if (nullptr != mSecond) {
+    mSecond->release();
+  }
+  if (nullptr != mFirst) {
+    mFirst->release();
+  }
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
@@ -16,9 +16,7 @@
  */
 
 #include "mlclient/internals/Credentials.hpp"
-#include <sstream>
-#include <iomanip>
-#include <regex> // replaces boost regex in C++11
+#include <cctype>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -33,36 +31,50 @@ namespace mlclient {
 namespace internals {
 using namespace web::http;
 
-const std::regex REALM_RE("[R|r]ealm=\"(\\w+)\"");
-const std::regex QOP_RE("qop=\"(\\w+)\"");
-const std::regex NONCE_RE("nonce=\"([a-z0-9]+)\"");
-const std::regex OPAQUE_RE("opaque=\"([a-z0-9]+)\"");
 const utility::string_t AUTHORIZATION_HEADER_NAME = U("Authorization");
 const utility::string_t WWW_AUTHENTICATE_HEADER = U("WWW-Authenticate");
 
-Credentials::Credentials() : nonce_count(0) {
+namespace {
+
+bool equalsIgnoreCase(const std::string& raw,const std::size_t pos,const std::size_t len,const char* lit) {
+  std::size_t i = 0;
+  for (;i < len && '\0' != lit[i];i++) {
+    if (std::tolower((unsigned char)raw[pos + i]) != std::tolower((unsigned char)lit[i])) {
+      return false;
+    }
+  }
+  return i == len && '\0' == lit[i];
+}
+
+bool isSpace(const char c) {
+  return ' ' == c || '\t' == c;
+}
+
+} // end anonymous namespace
+
+Credentials::Credentials() : nonce_count(0), stale(false) {
   cnonce = generateRandomCnonce();
 }
 
 Credentials::Credentials(const std::string& user, const std::string& pass) :
-        user(std::wstring(user.begin(), user.end())), pass(pass.begin(), pass.end()),
-        nonce_count(0)
+        user(user), pass(pass), nonce_count(0), stale(false)
 {
   cnonce = generateRandomCnonce();
 }
 
 Credentials::Credentials(const std::wstring& user, const std::wstring& pass) :
-        user(user), pass(pass), nonce_count(0)
+        user(user.begin(), user.end()), pass(pass.begin(), pass.end()), nonce_count(0), stale(false)
 {
   cnonce = generateRandomCnonce();
 }
 
 Credentials::Credentials(const std::string& username, const std::string& password,
     const std::string& cnonce, const uint32_t& nc) :
-            user(username.begin(), username.end()),
-            pass(password.begin(), password.end()),
+            user(username),
+            pass(password),
             cnonce(cnonce),
-            nonce_count(nc)
+            nonce_count(nc),
+            stale(false)
 {
   ;
 }
@@ -84,35 +96,126 @@ Credentials::~Credentials() {
 
 bool Credentials::canAuthenticate() const {
   TIMED_FUNC(Credentials_canAuthenticate);
-  return user != L"" && pass != L"" && nonce != "" && realm != "";
+  return !user.empty() && !pass.empty() && !nonce.empty() && !realm.empty();
 }
 
 void Credentials::parseWWWAuthenticateHeader(const std::string& raw) {
   TIMED_FUNC(Credentials_parseWWWAuthenticateHeader);
-  std::smatch matches;
-  if (std::regex_search(raw, matches, REALM_RE)) {
-    realm = matches[1];
-  } else {
-    realm.clear();
-  }
-
-  if(std::regex_search(raw, matches, QOP_RE)) {
-    qop = matches[1];
-  } else {
-    qop.clear();
+  std::string newRealm, newQop, newNonce, newOpaque;
+  bool newStale = false;
+
+  // Skip to the Digest challenge - the header may also list a Basic challenge
+  std::size_t pos = 0;
+  const std::size_t len = raw.size();
+  bool found = false;
+  while (pos < len && !found) {
+    while (pos < len && (isSpace(raw[pos]) || ',' == raw[pos])) {
+      pos++;
+    }
+    std::size_t tokenStart = pos;
+    while (pos < len && !isSpace(raw[pos]) && ',' != raw[pos] && '=' != raw[pos]) {
+      pos++;
+    }
+    if (equalsIgnoreCase(raw, tokenStart, pos - tokenStart, "digest") && (pos == len || isSpace(raw[pos]))) {
+      found = true;
+    } else if (pos < len && '=' == raw[pos]) {
+      // skip a parameter value of some other scheme
+      pos++;
+      if (pos < len && '"' == raw[pos]) {
+        pos++;
+        while (pos < len && '"' != raw[pos]) {
+          pos += ('\\' == raw[pos]) ? 2 : 1;
+        }
+        pos++;
+      } else {
+        while (pos < len && ',' != raw[pos]) {
+          pos++;
+        }
+      }
+    }
   }
 
-  if (std::regex_search(raw, matches, NONCE_RE)) {
-    nonce = matches[1];
-  } else {
-    nonce.clear();
+  // Now parse the comma separated name=value or name="value" parameters
+  while (found && pos < len) {
+    while (pos < len && (isSpace(raw[pos]) || ',' == raw[pos])) {
+      pos++;
+    }
+    std::size_t nameStart = pos;
+    while (pos < len && !isSpace(raw[pos]) && '=' != raw[pos] && ',' != raw[pos]) {
+      pos++;
+    }
+    std::size_t nameLen = pos - nameStart;
+    while (pos < len && isSpace(raw[pos])) {
+      pos++;
+    }
+    if (pos >= len || '=' != raw[pos]) {
+      break; // the start of another scheme's challenge
+    }
+    pos++;
+    while (pos < len && isSpace(raw[pos])) {
+      pos++;
+    }
+    std::string value;
+    if (pos < len && '"' == raw[pos]) {
+      pos++;
+      while (pos < len && '"' != raw[pos]) {
+        if ('\\' == raw[pos] && pos + 1 < len) {
+          pos++;
+        }
+        value += raw[pos++];
+      }
+      pos++;
+    } else {
+      std::size_t valueStart = pos;
+      while (pos < len && ',' != raw[pos] && !isSpace(raw[pos])) {
+        pos++;
+      }
+      value.assign(raw, valueStart, pos - valueStart);
+    }
+
+    if (equalsIgnoreCase(raw, nameStart, nameLen, "realm")) {
+      newRealm.swap(value);
+    } else if (equalsIgnoreCase(raw, nameStart, nameLen, "nonce")) {
+      newNonce.swap(value);
+    } else if (equalsIgnoreCase(raw, nameStart, nameLen, "opaque")) {
+      newOpaque.swap(value);
+    } else if (equalsIgnoreCase(raw, nameStart, nameLen, "qop")) {
+      // may be a list, E.g. "auth,auth-int". We only support auth.
+      std::size_t qopStart = 0;
+      while (qopStart <= value.size()) {
+        std::size_t qopEnd = value.find(',', qopStart);
+        if (std::string::npos == qopEnd) {
+          qopEnd = value.size();
+        }
+        while (qopStart < qopEnd && isSpace(value[qopStart])) {
+          qopStart++;
+        }
+        while (qopEnd > qopStart && isSpace(value[qopEnd - 1])) {
+          qopEnd--;
+        }
+        if (equalsIgnoreCase(value, qopStart, qopEnd - qopStart, "auth")) {
+          newQop = "auth";
+          break;
+        }
+        qopStart = value.find(',', qopStart);
+        if (std::string::npos == qopStart) {
+          break;
+        }
+        qopStart++;
+      }
+    } else if (equalsIgnoreCase(raw, nameStart, nameLen, "stale")) {
+      newStale = equalsIgnoreCase(value, 0, value.size(), "true");
+    }
   }
 
-  if (std::regex_search(raw, matches, OPAQUE_RE)) {
-    opaque = matches[1];
-  } else {
-    opaque.clear();
+  if (newNonce != nonce) {
+    nonce_count = 0; // nc counts requests per nonce
   }
+  realm.swap(newRealm);
+  qop.swap(newQop);
+  nonce.swap(newNonce);
+  opaque.swap(newOpaque);
+  stale = newStale;
 }
 
 std::string Credentials::authenticate(const std::string& method, const std::string& uri, const std::string& auth_header) {
@@ -123,36 +226,42 @@ std::string Credentials::authenticate(const std::string& method, const std::stri
 
 std::string Credentials::authenticate(const std::string& method, const std::string& uri) {
   TIMED_FUNC(Credentials_authenticate);
-  std::ostringstream oss;
   internals::AuthorizationBuilder builder;
   nonce_count++;
 
-  std::ostringstream temp;
-  std::string username(user.begin(), user.end());
-  std::string password(pass.begin(), pass.end());
-
-  std::string a1 = builder.usernameRealmAndPassword(username, realm, password);
+  if (ha1.empty() || ha1Realm != realm) {
+    ha1 = builder.usernameRealmAndPassword(user, realm, pass);
+    ha1Realm = realm;
+  }
   std::string a2 = builder.methodAndURL(method, uri);
 
-  oss << std::setfill('0') << std::setw(8) << nonce_count;
-  std::string nc = oss.str();
-
-  std::string response = builder.response(a1, nonce, nc, cnonce,
-      qop, a2);
-
-  oss.str("");
-  oss << "Digest";
-  oss << " username=\"" << username << "\",";
-  oss << " realm=\"" << realm << "\",";
-  oss << " nonce=\"" << nonce << "\",";
-  oss << " uri=\"" << uri << "\",";
-  oss << " cnonce=\"" << cnonce << "\",";
-  oss << " nc=" << nc << ",";
-  oss << " qop=" << qop << ",";
-  oss << " response=\"" << response << "\",";
-  oss << " opaque=\"" << opaque << "\"";
+  // nc is 8 hex digits, as per RFC 2617
+  static const char HEX[] = "0123456789abcdef";
+  char nc[9];
+  for (int i = 7;i >= 0;i--) {
+    nc[7 - i] = HEX[(nonce_count >> (i * 4)) & 0xf];
+  }
+  nc[8] = '\0';
+
+  std::string response = qop.empty() ? builder.response(ha1, nonce, a2) : builder.response(ha1, nonce, nc, cnonce, qop, a2);
+
+  std::string header;
+  header.reserve(128 + user.size() + realm.size() + nonce.size() + uri.size() + cnonce.size() + opaque.size());
+  header.append("Digest username=\"").append(user);
+  header.append("\", realm=\"").append(realm);
+  header.append("\", nonce=\"").append(nonce);
+  header.append("\", uri=\"").append(uri).append("\",");
+  if (!qop.empty()) {
+    header.append(" cnonce=\"").append(cnonce).append("\",");
+    header.append(" nc=").append(nc).append(",");
+    header.append(" qop=").append(qop).append(",");
+  }
+  header.append(" response=\"").append(response).append("\"");
+  if (!opaque.empty()) {
+    header.append(", opaque=\"").append(opaque).append("\"");
+  }
 
-  return oss.str();
+  return header;
 }
 
 std::string Credentials::getNonce(void) const {
@@ -171,6 +280,10 @@ std::string Credentials::getRealm(void) const {
   return realm;
 }
 
+bool Credentials::isStale(void) const {
+  return stale;
+}
+
 } // end namespace internals
 
 } // end namespace mlclient
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * FileStream.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/FileStream.hpp"
+
+#include "mlclient/logging.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <Windows.h>
+#endif
+
+#include <algorithm>
+
+namespace mlclient {
+
+namespace internals {
+
+const std::size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+#ifndef _WIN32
+FileBuffer::FileBuffer(const std::string& filename) : std::streambuf(), mFile(-1), mSize(0), mPosition(0), mBuffer() {
+  mFile = open(filename.c_str(),O_RDONLY | O_CLOEXEC);
+  if (-1 == mFile) {
+    LOG(DEBUG) << "FileBuffer could not open file: " << filename;
+    return;
+  }
+  struct stat st;
+  if (0 != fstat(mFile,&st) || !S_ISREG(st.st_mode)) {
+    LOG(DEBUG) << "FileBuffer not a regular file: " << filename;
+    close(mFile);
+    mFile = -1;
+    return;
+  }
+  mSize = st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(mFile,0,0,POSIX_FADV_SEQUENTIAL); // read ahead aggressively
+#endif
+}
+
+FileBuffer::~FileBuffer() {
+  if (-1 != mFile) {
+    close(mFile);
+  }
+}
+
+bool FileBuffer::isOpen() const {
+  return -1 != mFile;
+}
+
+long long FileBuffer::readAt(char* buffer,const std::size_t count,const std::uint64_t offset) const {
+  if (-1 == mFile) {
+    return -1;
+  }
+  if (offset >= mSize) {
+    return 0;
+  }
+  const std::size_t wanted = (std::size_t)std::min<std::uint64_t>(count,mSize - offset);
+  ssize_t read;
+  do {
+    read = pread(mFile,buffer,wanted,(off_t)offset);
+  } while (-1 == read && EINTR == errno);
+  return read;
+}
+#else
+FileBuffer::FileBuffer(const std::string& filename) : std::streambuf(), mFile(INVALID_HANDLE_VALUE), mSize(0),
+    mPosition(0), mBuffer() {
+  int len = MultiByteToWideChar(CP_ACP,0,filename.c_str(),-1,nullptr,0);
+  std::wstring wname(len,L'\0');
+  MultiByteToWideChar(CP_ACP,0,filename.c_str(),-1,&wname[0],len);
+  HANDLE file = CreateFileW(wname.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,nullptr);
+  if (INVALID_HANDLE_VALUE == file) {
+    LOG(DEBUG) << "FileBuffer could not open file: " << filename;
+    return;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file,&size)) {
+    CloseHandle(file);
+    return;
+  }
+  mFile = file;
+  mSize = size.QuadPart;
+}
+
+FileBuffer::~FileBuffer() {
+  if (INVALID_HANDLE_VALUE != mFile) {
+    CloseHandle(mFile);
+  }
+}
+
+bool FileBuffer::isOpen() const {
+  return INVALID_HANDLE_VALUE != mFile;
+}
+
+long long FileBuffer::readAt(char* buffer,const std::size_t count,const std::uint64_t offset) const {
+  if (INVALID_HANDLE_VALUE == mFile) {
+    return -1;
+  }
+  if (offset >= mSize) {
+    return 0;
+  }
+  const DWORD wanted = (DWORD)std::min<std::uint64_t>(std::min<std::uint64_t>(count,mSize - offset),MAXDWORD);
+  OVERLAPPED at = {};
+  at.Offset = (DWORD)offset;
+  at.OffsetHigh = (DWORD)(offset >> 32);
+  DWORD read = 0;
+  if (!ReadFile(mFile,buffer,wanted,&read,&at)) {
+    return (ERROR_HANDLE_EOF == GetLastError()) ? 0 : -1;
+  }
+  return read;
+}
+#endif
+
+std::uint64_t FileBuffer::size() const {
+  return mSize;
+}
+
+FileBuffer::int_type FileBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  if (mBuffer.empty()) {
+    mBuffer.resize(FILE_BUFFER_SIZE);
+  }
+  const long long read = readAt(mBuffer.data(),mBuffer.size(),mPosition);
+  if (read <= 0) {
+    setg(nullptr,nullptr,nullptr);
+    return traits_type::eof();
+  }
+  mPosition += read;
+  setg(mBuffer.data(),mBuffer.data(),mBuffer.data() + read);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize FileBuffer::showmanyc() {
+  const std::uint64_t current = mPosition - (egptr() - gptr());
+  return (current < mSize) ? (std::streamsize)(mSize - current) : -1;
+}
+
+FileBuffer::pos_type FileBuffer::seekoff(off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which) {
+  if (0 == (which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  off_type base = 0;
+  if (std::ios_base::cur == dir) {
+    base = (off_type)(mPosition - (egptr() - gptr()));
+  } else if (std::ios_base::end == dir) {
+    base = (off_type)mSize;
+  }
+  const off_type target = base + off;
+  if (target < 0 || target > (off_type)mSize) {
+    return pos_type(off_type(-1));
+  }
+  mPosition = (std::uint64_t)target;
+  setg(nullptr,nullptr,nullptr); // read afresh from the new position
+  return pos_type(target);
+}
+
+FileBuffer::pos_type FileBuffer::seekpos(pos_type pos,std::ios_base::openmode which) {
+  return seekoff(off_type(pos),std::ios_base::beg,which);
+}
+
+
+
+FileStream::FileStream(const std::string& filename) : std::istream(nullptr), mBuffer(filename) {
+  rdbuf(&mBuffer); // also clears the badbit set by constructing with a null buffer
+  if (!mBuffer.isOpen()) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+FileStream::~FileStream() {
+  ;
+}
+
+FileBuffer& FileStream::buffer() {
+  return mBuffer;
+}
+
+std::uint64_t FileStream::lengthOf(const std::istream& stream,const long long streamLength) {
+  const FileStream* file = dynamic_cast<const FileStream*>(&stream);
+  if (nullptr != file) {
+    return file->mBuffer.size();
+  }
+  return (std::uint64_t)streamLength;
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * HttpClientPool.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/HttpClientPool.hpp"
+
+#include "mlclient/logging.hpp"
+
+#include <cpprest/http_client.h>
+
+namespace mlclient {
+
+namespace internals {
+
+using namespace web::http::client;
+
+HttpClientPool::HttpClientPool() : mMutex(), mIdle(), mMaxIdlePerHost(8), mIdleTimeout(30), mGeneration(0),
+    mLeased(), mStats() {
+  ;
+}
+
+HttpClientPool::~HttpClientPool() {
+  ;
+}
+
+void HttpClientPool::setMaxIdlePerHost(const std::size_t maxIdle) {
+  std::lock_guard<std::mutex> lck(mMutex);
+  mMaxIdlePerHost = maxIdle;
+  for (auto& hostIter : mIdle) {
+    while (hostIter.second.size() > mMaxIdlePerHost) {
+      hostIter.second.pop_front(); // oldest first
+      mStats.evictions++;
+    }
+  }
+}
+
+std::size_t HttpClientPool::getMaxIdlePerHost() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  return mMaxIdlePerHost;
+}
+
+void HttpClientPool::setIdleTimeout(const std::chrono::seconds& timeout) {
+  std::lock_guard<std::mutex> lck(mMutex);
+  mIdleTimeout = timeout;
+}
+
+std::chrono::seconds HttpClientPool::getIdleTimeout() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  return mIdleTimeout;
+}
+
+void HttpClientPool::evictIdleLocked(const std::chrono::steady_clock::time_point& now) {
+  for (auto hostIter = mIdle.begin(); hostIter != mIdle.end();) {
+    std::deque<IdleClient>& clients = hostIter->second;
+    // clients are appended on release, so the front is always the least recently used
+    while (!clients.empty() && (now - clients.front().lastUsed) > mIdleTimeout) {
+      clients.pop_front();
+      mStats.evictions++;
+    }
+    if (clients.empty()) {
+      hostIter = mIdle.erase(hostIter);
+    } else {
+      ++hostIter;
+    }
+  }
+}
+
+HttpClientPool::ClientPtr HttpClientPool::acquire(const std::string& host) {
+  TIMED_FUNC(HttpClientPool_acquire);
+  ClientPtr client;
+  {
+    std::lock_guard<std::mutex> lck(mMutex);
+    evictIdleLocked(std::chrono::steady_clock::now());
+
+    auto hostIter = mIdle.find(host);
+    if (mIdle.end() != hostIter && !hostIter->second.empty()) {
+      // most recently used first - it is the most likely to still have a live socket
+      client = hostIter->second.back().client;
+      hostIter->second.pop_back();
+      mStats.hits++;
+    } else {
+      mStats.misses++;
+    }
+    if (client) {
+      mLeased[client.get()] = mGeneration;
+      return client;
+    }
+  }
+
+  // create outside the lock - construction may resolve the host
+  LOG(DEBUG) << "HttpClientPool::acquire creating new client for host: " << host;
+  client = std::make_shared<http_client>(utility::conversions::to_string_t(host));
+
+  std::lock_guard<std::mutex> lck(mMutex);
+  mStats.connects++;
+  mLeased[client.get()] = mGeneration;
+  return client;
+}
+
+void HttpClientPool::release(const std::string& host,ClientPtr client,const bool healthy) {
+  TIMED_FUNC(HttpClientPool_release);
+  if (!client) {
+    return;
+  }
+  std::lock_guard<std::mutex> lck(mMutex);
+  bool current = false;
+  auto leasedIter = mLeased.find(client.get());
+  if (mLeased.end() != leasedIter) {
+    current = (leasedIter->second == mGeneration);
+    mLeased.erase(leasedIter);
+  }
+  if (!healthy || !current) {
+    mStats.discards++;
+    return;
+  }
+  std::deque<IdleClient>& clients = mIdle[host];
+  if (clients.size() >= mMaxIdlePerHost) {
+    mStats.discards++;
+    return;
+  }
+  IdleClient ic;
+  ic.client = client;
+  ic.lastUsed = std::chrono::steady_clock::now();
+  clients.push_back(ic);
+}
+
+void HttpClientPool::evictIdle() {
+  std::lock_guard<std::mutex> lck(mMutex);
+  evictIdleLocked(std::chrono::steady_clock::now());
+}
+
+void HttpClientPool::clear() {
+  std::lock_guard<std::mutex> lck(mMutex);
+  for (auto& hostIter : mIdle) {
+    mStats.evictions += hostIter.second.size();
+  }
+  mIdle.clear();
+  mGeneration++; // outstanding leases will be discarded on release
+}
+
+ConnectionPoolStats HttpClientPool::getStats() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  ConnectionPoolStats stats = mStats;
+  stats.idle = 0;
+  for (auto& hostIter : mIdle) {
+    stats.idle += hostIter.second.size();
+  }
+  stats.inUse = mLeased.size();
+  return stats;
+}
+
+
+
+HttpClientLease::HttpClientLease(HttpClientPool* pool,const std::string& host) : mPool(pool), mHost(host),
+    mClient(), mHealthy(true) {
+  if (nullptr != mPool) {
+    mClient = mPool->acquire(mHost);
+  } else {
+    mClient = std::make_shared<http_client>(utility::conversions::to_string_t(mHost));
+  }
+}
+
+HttpClientLease::~HttpClientLease() {
+  if (nullptr != mPool) {
+    mPool->release(mHost,mClient,mHealthy);
+  }
+}
+
+http_client& HttpClientLease::client() {
+  return *mClient;
+}
+
+void HttpClientLease::markFailed() {
+  mHealthy = false;
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
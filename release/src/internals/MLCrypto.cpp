@@ -52,12 +52,13 @@ std::string MLCrypto::md5(const std::string& raw) const {
 
 std::string MLCrypto::toHex(const uint8_t* bytes, const size_t& length) const {
   TIMED_FUNC(MLCrypto_toHex);
-  std::ostringstream hex_ss;
-  hex_ss << std::hex;
-  for (size_t i = 0; i < length; i++) { 
-    hex_ss << std::setfill('0') << std::setw(2) << (int)bytes[i]; 
+  static const char HEX[] = "0123456789abcdef";
+  std::string hex(length * 2, '0');
+  for (size_t i = 0; i < length; i++) {
+    hex[i * 2] = HEX[bytes[i] >> 4];
+    hex[i * 2 + 1] = HEX[bytes[i] & 0x0f];
   }
-  return hex_ss.str();
+  return hex;
 }
 
 } // end namespace internals
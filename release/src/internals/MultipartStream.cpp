@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * MultipartStream.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/MultipartStream.hpp"
+#include "mlclient/internals/FileStream.hpp"
+
+#include "mlclient/logging.hpp"
+
+#include <algorithm>
+
+namespace mlclient {
+
+namespace internals {
+
+const std::size_t MULTIPART_READ_BUFFER_SIZE = 64 * 1024;
+
+MultipartBuffer::MultipartBuffer() : std::streambuf(), mSegments(), mCurrent(0), mLength(0), mPosition(0), mReadBuffer() {
+  ;
+}
+
+MultipartBuffer::~MultipartBuffer() {
+  ;
+}
+
+void MultipartBuffer::append(const std::string& text) {
+  if (text.empty()) {
+    return;
+  }
+  if (!mSegments.empty() && !mSegments.back().stream) {
+    Segment& last = mSegments.back();
+    last.text.append(text);
+    last.length = last.text.size();
+  } else {
+    Segment seg;
+    seg.text = text;
+    seg.file = nullptr;
+    seg.length = text.size();
+    seg.delivered = 0;
+    mSegments.push_back(std::move(seg));
+  }
+  mLength += text.size();
+}
+
+void MultipartBuffer::append(std::string&& text) {
+  if (text.empty()) {
+    return;
+  }
+  mLength += text.size();
+  Segment seg;
+  seg.text = std::move(text);
+  seg.file = nullptr;
+  seg.length = seg.text.size();
+  seg.delivered = 0;
+  mSegments.push_back(std::move(seg));
+}
+
+void MultipartBuffer::append(std::unique_ptr<std::istream> stream,const std::uint64_t length) {
+  if (0 == length) {
+    return;
+  }
+  Segment seg;
+  FileStream* file = dynamic_cast<FileStream*>(stream.get());
+  seg.file = (nullptr != file) ? &file->buffer() : nullptr; // read by position, so no seek is needed to rewind
+  if (mReadBuffer.empty()) {
+    mReadBuffer.resize(MULTIPART_READ_BUFFER_SIZE); // only needed if we have a stream to read
+  }
+  seg.stream = std::move(stream);
+  seg.length = length;
+  seg.delivered = 0;
+  mSegments.push_back(std::move(seg));
+  mLength += length;
+}
+
+std::uint64_t MultipartBuffer::getLength() const {
+  return mLength;
+}
+
+MultipartBuffer::int_type MultipartBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  mPosition += (egptr() - eback());
+  setg(nullptr,nullptr,nullptr);
+
+  while (mCurrent < mSegments.size()) {
+    Segment& seg = mSegments[mCurrent];
+    const std::uint64_t remaining = seg.length - seg.delivered;
+    if (0 == remaining) {
+      mCurrent++;
+      continue;
+    }
+    char* begin;
+    std::size_t count;
+    if (!seg.stream) {
+      // hand out the rest of the text directly - no copy
+      begin = &seg.text[0] + seg.delivered;
+      count = (std::size_t)remaining;
+    } else {
+      begin = mReadBuffer.data();
+      count = (std::size_t)std::min<std::uint64_t>(mReadBuffer.size(),remaining);
+      if (nullptr != seg.file) {
+        const long long read = seg.file->readAt(begin,count,seg.delivered);
+        count = (read > 0) ? (std::size_t)read : 0;
+      } else {
+        seg.stream->read(begin,count);
+        count = (std::size_t)seg.stream->gcount();
+      }
+      if (0 == count) {
+        // stream shorter than declared (E.g. file truncated since). End here - the server will reject the short body.
+        LOG(DEBUG) << "MultipartBuffer::underflow stream segment ended " << remaining << " bytes early";
+        return traits_type::eof();
+      }
+    }
+    seg.delivered += count;
+    setg(begin,begin,begin + count);
+    return traits_type::to_int_type(*gptr());
+  }
+  return traits_type::eof();
+}
+
+bool MultipartBuffer::rewind() {
+  for (auto& seg : mSegments) {
+    if (seg.stream && nullptr == seg.file && 0 != seg.delivered) {
+      seg.stream->clear();
+      seg.stream->seekg(0,std::ios::beg);
+      if (seg.stream->fail()) {
+        return false;
+      }
+    }
+    seg.delivered = 0;
+  }
+  mCurrent = 0;
+  mPosition = 0;
+  setg(nullptr,nullptr,nullptr);
+  return true;
+}
+
+MultipartBuffer::pos_type MultipartBuffer::seekoff(off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which) {
+  if (0 == (which & std::ios_base::in) || 0 != off) {
+    return pos_type(off_type(-1)); // only tell and rewind are supported
+  }
+  if (std::ios_base::cur == dir) {
+    return pos_type(off_type(mPosition + (gptr() - eback())));
+  }
+  if (std::ios_base::beg == dir && rewind()) {
+    return pos_type(off_type(0));
+  }
+  return pos_type(off_type(-1));
+}
+
+MultipartBuffer::pos_type MultipartBuffer::seekpos(pos_type pos,std::ios_base::openmode which) {
+  return seekoff(off_type(pos),std::ios_base::beg,which);
+}
+
+
+
+MultipartStream::MultipartStream() : std::istream(nullptr), mBuffer() {
+  rdbuf(&mBuffer); // also clears the badbit set by constructing with a null buffer
+}
+
+MultipartStream::~MultipartStream() {
+  ;
+}
+
+MultipartBuffer& MultipartStream::buffer() {
+  return mBuffer;
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * NodeArena.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/NodeArena.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace mlclient {
+
+namespace internals {
+
+namespace {
+
+const std::size_t FIRST_BLOCK_SIZE = 256;
+const std::size_t MAX_BLOCK_SIZE = 64 * 1024;
+
+inline char* alignUp(char* p,const std::size_t align) {
+  const std::uintptr_t v = reinterpret_cast<std::uintptr_t>(p);
+  return reinterpret_cast<char*>((v + align - 1) & ~(std::uintptr_t)(align - 1));
+}
+
+} // end anonymous namespace
+
+NodeArena::NodeArena() : mNext(nullptr), mEnd(nullptr), mBlockSize(FIRST_BLOCK_SIZE), mReserved(0), mBlocks(nullptr),
+    mLast(nullptr) {
+  ;
+}
+
+NodeArena::~NodeArena() {
+  for (Destructor* dtor = mLast;nullptr != dtor;dtor = dtor->previous) {
+    dtor->destroy(dtor->object);
+  }
+  while (nullptr != mBlocks) {
+    Block* previous = mBlocks->previous;
+    ::operator delete(mBlocks);
+    mBlocks = previous;
+  }
+}
+
+const char* NodeArena::copy(const std::string& str) {
+  char* mem = static_cast<char*>(allocate(str.size() + 1,1));
+  std::memcpy(mem,str.c_str(),str.size() + 1);
+  return mem;
+}
+
+std::size_t NodeArena::getReservedBytes() const {
+  return mReserved;
+}
+
+void* NodeArena::allocate(const std::size_t size,const std::size_t align) {
+  char* p = alignUp(mNext,align);
+  if (nullptr == mNext || p + size > mEnd) {
+    std::size_t blockSize = mBlockSize;
+    while (blockSize < sizeof(Block) + size + align) {
+      blockSize *= 2; // only for an object bigger than a block - there are no such nodes
+    }
+    Block* block = static_cast<Block*>(::operator new(blockSize));
+    block->previous = mBlocks;
+    mBlocks = block;
+    mReserved += blockSize;
+    mNext = reinterpret_cast<char*>(block) + sizeof(Block);
+    mEnd = reinterpret_cast<char*>(block) + blockSize;
+    if (mBlockSize < MAX_BLOCK_SIZE) {
+      mBlockSize *= 2;
+    }
+    p = alignUp(mNext,align);
+  }
+  mNext = p + size;
+  return p;
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
@@ -0,0 +1,968 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SearchResponseDecoder.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/SearchResponseDecoder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace mlclient {
+
+namespace internals {
+
+namespace {
+
+inline bool isSpace(const char c) {
+  return ' ' == c || '\n' == c || '\r' == c || '\t' == c;
+}
+
+template <std::size_t N>
+inline bool equals(const DecodedSpan& span,const char (&literal)[N]) {
+  return span.length == N - 1 && 0 == std::memcmp(span.data,literal,N - 1);
+}
+
+inline int hexDigit(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void appendUtf8(std::string& out,const unsigned long cp) {
+  if (cp < 0x80) {
+    out += (char)cp;
+  } else if (cp < 0x800) {
+    out += (char)(0xC0 | (cp >> 6));
+    out += (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += (char)(0xE0 | (cp >> 12));
+    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    out += (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x110000) {
+    out += (char)(0xF0 | (cp >> 18));
+    out += (char)(0x80 | ((cp >> 12) & 0x3F));
+    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    out += (char)(0x80 | (cp & 0x3F));
+  } else {
+    out += "\xEF\xBF\xBD"; // replacement character
+  }
+}
+
+void toNumber(const std::string& text,long& out) {
+  out = std::strtol(text.c_str(),nullptr,10);
+}
+
+void toNumber(const std::string& text,double& out) {
+  out = std::strtod(text.c_str(),nullptr);
+}
+
+void resetRow(SearchResponseDecoder::Row& row) {
+  row.index = 0;
+  row.uri.clear();
+  row.path.clear();
+  row.score = 0;
+  row.confidence = 0.0;
+  row.fitness = 0.0;
+  row.mimeType.clear();
+  row.format.clear();
+  row.result = DecodedSpan{nullptr,0};
+  row.content = DecodedSpan{nullptr,0};
+  row.snippet = DecodedSpan{nullptr,0};
+  row.matches = DecodedSpan{nullptr,0};
+}
+
+/*
+ * Appends the text from begin to end, replacing XML entity and character references
+ */
+void appendXmlText(const char* begin,const char* end,std::string& out) {
+  while (begin < end) {
+    const char* amp = (const char*)std::memchr(begin,'&',end - begin);
+    if (nullptr == amp) {
+      out.append(begin,end - begin);
+      return;
+    }
+    out.append(begin,amp - begin);
+    const std::size_t limit = (std::size_t)(end - amp) < 12 ? (std::size_t)(end - amp) : 12;
+    const char* semi = (const char*)std::memchr(amp,';',limit);
+    if (nullptr == semi) {
+      out += '&'; // not a reference - left as is
+      begin = amp + 1;
+      continue;
+    }
+    const DecodedSpan name{amp + 1,(std::size_t)(semi - amp - 1)};
+    if (equals(name,"lt")) {
+      out += '<';
+    } else if (equals(name,"gt")) {
+      out += '>';
+    } else if (equals(name,"amp")) {
+      out += '&';
+    } else if (equals(name,"quot")) {
+      out += '"';
+    } else if (equals(name,"apos")) {
+      out += '\'';
+    } else if (name.length > 1 && '#' == name.data[0]) {
+      const bool hex = ('x' == name.data[1] || 'X' == name.data[1]);
+      unsigned long cp = 0;
+      bool valid = name.length > (hex ? 2u : 1u);
+      for (const char* p = name.data + (hex ? 2 : 1);valid && p < semi;++p) {
+        const int digit = hex ? hexDigit(*p) : ((*p >= '0' && *p <= '9') ? *p - '0' : -1);
+        valid = digit >= 0 && cp < 0x110000;
+        cp = cp * (hex ? 16 : 10) + digit;
+      }
+      if (valid) {
+        appendUtf8(out,cp);
+      } else {
+        out.append(amp,semi + 1 - amp);
+      }
+    } else {
+      out.append(amp,semi + 1 - amp); // unknown entity - left as is
+    }
+    begin = semi + 1;
+  }
+}
+
+/*
+ * Reads JSON values in place. Functions return false on error, after which failed() is true.
+ */
+class JsonCursor {
+public:
+  JsonCursor(const char* data,const std::size_t length) : mBegin(data), mPos(data), mEnd(data + length),
+      mError(nullptr) {
+    ;
+  }
+
+  bool failed() const {
+    return nullptr != mError;
+  }
+
+  const char* error() const {
+    return mError;
+  }
+
+  std::size_t offset() const {
+    return mPos - mBegin;
+  }
+
+  const char* position() const {
+    return mPos;
+  }
+
+  bool fail(const char* error) {
+    if (nullptr == mError) {
+      mError = error;
+    }
+    return false;
+  }
+
+  /* Returns the next character after any whitespace, without consuming it, or 0 at the end */
+  char peek() {
+    while (mPos < mEnd && isSpace(*mPos)) {
+      ++mPos;
+    }
+    return (mPos < mEnd) ? *mPos : '\0';
+  }
+
+  bool consume(const char c) {
+    if (c != peek()) {
+      return false;
+    }
+    ++mPos;
+    return true;
+  }
+
+  bool expect(const char c,const char* error) {
+    return consume(c) || fail(error);
+  }
+
+  /*
+   * Call once the object's '{' is consumed. Returns true with the next member's key, positioned at its value, or
+   * false at the end of the object (or on error)
+   */
+  bool member(bool& first,std::string& key) {
+    if (consume('}')) {
+      return false;
+    }
+    if (!first && !expect(',',"expected , or } in object")) {
+      return false;
+    }
+    first = false;
+    if ('"' != peek()) {
+      return fail("expected a key in object");
+    }
+    return string(key) && expect(':',"expected : after key");
+  }
+
+  /*
+   * Call once the array's '[' is consumed. Returns true positioned at the next element, or false at the end of the
+   * array (or on error)
+   */
+  bool element(bool& first) {
+    if (consume(']')) {
+      return false;
+    }
+    if (!first && !expect(',',"expected , or ] in array")) {
+      return false;
+    }
+    first = false;
+    return ']' != peek() || fail("expected a value in array");
+  }
+
+  /* Reads a string value, unescaped */
+  bool string(std::string& out) {
+    if (!consume('"')) {
+      return fail("expected a string");
+    }
+    const char* begin = mPos;
+    while (mPos < mEnd && '"' != *mPos && '\\' != *mPos) {
+      ++mPos;
+    }
+    out.assign(begin,mPos - begin); // the common case - no escapes
+    while (mPos < mEnd) {
+      const char c = *mPos++;
+      if ('"' == c) {
+        return true;
+      }
+      if ('\\' != c) {
+        out += c;
+        continue;
+      }
+      if (mPos >= mEnd) {
+        break;
+      }
+      const char e = *mPos++;
+      switch (e) {
+        case '"': case '\\': case '/': out += e; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          unsigned long cp;
+          if (!hex4(cp)) {
+            return fail("invalid \\u escape in string");
+          }
+          if (cp >= 0xD800 && cp < 0xDC00 && mEnd - mPos >= 6 && '\\' == mPos[0] && 'u' == mPos[1]) {
+            mPos += 2;
+            unsigned long low;
+            if (!hex4(low)) {
+              return fail("invalid \\u escape in string");
+            }
+            if (low >= 0xDC00 && low < 0xE000) {
+              cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            } else {
+              appendUtf8(out,0xFFFD); // unpaired surrogate
+              cp = low;
+            }
+          }
+          appendUtf8(out,cp);
+          break;
+        }
+        default:
+          return fail("invalid escape in string");
+      }
+    }
+    return fail("unterminated string");
+  }
+
+  /* Reads a string (unescaped), number, boolean or null as text */
+  bool scalar(std::string& out) {
+    const char c = peek();
+    if ('"' == c) {
+      return string(out);
+    }
+    if ('{' == c || '[' == c) {
+      return fail("expected a string, number, boolean or null");
+    }
+    const char* begin = mPos;
+    skipLiteral();
+    if (begin == mPos) {
+      return fail("expected a value");
+    }
+    out.assign(begin,mPos - begin);
+    return true;
+  }
+
+  /* Skips over any value, without decoding it */
+  bool skip() {
+    const char c = peek();
+    if ('"' == c) {
+      return skipString();
+    }
+    if ('{' != c && '[' != c) {
+      const char* begin = mPos;
+      skipLiteral();
+      return begin != mPos || fail("expected a value");
+    }
+    long depth = 0;
+    while (mPos < mEnd) {
+      const char d = *mPos;
+      if ('"' == d) {
+        if (!skipString()) {
+          return false;
+        }
+        continue;
+      }
+      if ('{' == d || '[' == d) {
+        ++depth;
+      } else if ('}' == d || ']' == d) {
+        if (0 == --depth) {
+          ++mPos;
+          return true;
+        }
+      }
+      ++mPos;
+    }
+    return fail("unterminated object or array");
+  }
+
+  /* Skips over any value, recording where it is */
+  bool span(DecodedSpan& out) {
+    peek();
+    const char* begin = mPos;
+    if (!skip()) {
+      return false;
+    }
+    out.data = begin;
+    out.length = mPos - begin;
+    return true;
+  }
+
+private:
+  bool skipString() {
+    ++mPos; // opening quote
+    while (mPos < mEnd) {
+      const char* stop = mPos;
+      while (stop < mEnd && '"' != *stop && '\\' != *stop) {
+        ++stop;
+      }
+      mPos = stop;
+      if (mPos >= mEnd) {
+        break;
+      }
+      if ('"' == *mPos) {
+        ++mPos;
+        return true;
+      }
+      mPos += 2; // escaped character
+    }
+    return fail("unterminated string");
+  }
+
+  void skipLiteral() {
+    while (mPos < mEnd && ',' != *mPos && '}' != *mPos && ']' != *mPos && ':' != *mPos && !isSpace(*mPos)) {
+      ++mPos;
+    }
+  }
+
+  bool hex4(unsigned long& cp) {
+    if (mEnd - mPos < 4) {
+      return false;
+    }
+    cp = 0;
+    for (int i = 0;i < 4;i++) {
+      const int digit = hexDigit(*mPos++);
+      if (digit < 0) {
+        return false;
+      }
+      cp = (cp << 4) | digit;
+    }
+    return true;
+  }
+
+  const char* mBegin;
+  const char* mPos;
+  const char* mEnd;
+  const char* mError;
+};
+
+/*
+ * Reads XML tags in place. Text, comments, CDATA sections, processing instructions and doctypes between tags are
+ * skipped by next(). Namespace prefixes are not resolved - names are compared as written, as MarkLogic always uses
+ * the search: prefix.
+ */
+class XmlCursor {
+public:
+  enum Token {
+    START, END, DONE, FAILED
+  };
+
+  XmlCursor(const char* data,const std::size_t length) : mBegin(data), mPos(data), mEnd(data + length),
+      mError(nullptr), mTag(nullptr), mName{nullptr,0}, mAttributes(nullptr), mAttributesEnd(nullptr),
+      mSelfClosing(false) {
+    ;
+  }
+
+  bool failed() const {
+    return nullptr != mError;
+  }
+
+  const char* error() const {
+    return mError;
+  }
+
+  std::size_t offset() const {
+    return mPos - mBegin;
+  }
+
+  const char* position() const {
+    return mPos;
+  }
+
+  /* The '<' of the last tag read */
+  const char* tag() const {
+    return mTag;
+  }
+
+  template <std::size_t N>
+  bool isName(const char (&name)[N]) const {
+    return equals(mName,name);
+  }
+
+  bool isSelfClosing() const {
+    return mSelfClosing;
+  }
+
+  /* The position to pass to the first call of attribute() for the last start tag read */
+  const char* attributes() const {
+    return mAttributes;
+  }
+
+  /* Reads the next attribute of the last start tag read. Returns false once there are no more. */
+  bool attribute(const char*& p,DecodedSpan& name,DecodedSpan& rawValue) const {
+    while (p < mAttributesEnd && isSpace(*p)) {
+      ++p;
+    }
+    name.data = p;
+    while (p < mAttributesEnd && '=' != *p && !isSpace(*p)) {
+      ++p;
+    }
+    name.length = p - name.data;
+    while (p < mAttributesEnd && isSpace(*p)) {
+      ++p;
+    }
+    if (0 == name.length || p >= mAttributesEnd || '=' != *p) {
+      return false;
+    }
+    ++p;
+    while (p < mAttributesEnd && isSpace(*p)) {
+      ++p;
+    }
+    if (p >= mAttributesEnd || ('"' != *p && '\'' != *p)) {
+      return false;
+    }
+    const char quote = *p++;
+    rawValue.data = p;
+    while (p < mAttributesEnd && quote != *p) {
+      ++p;
+    }
+    if (p >= mAttributesEnd) {
+      return false;
+    }
+    rawValue.length = p - rawValue.data;
+    ++p;
+    return true;
+  }
+
+  /* Moves to the next start or end tag */
+  Token next() {
+    while (mPos < mEnd) {
+      const char* lt = (const char*)std::memchr(mPos,'<',mEnd - mPos);
+      if (nullptr == lt) {
+        mPos = mEnd;
+        break;
+      }
+      mPos = lt;
+      if (mEnd - mPos < 2 || ('!' != mPos[1] && '?' != mPos[1])) {
+        return readTag(); // the common case
+      }
+      if (startsWith("<!--")) {
+        if (!skipPast(4,"-->")) {
+          return FAILED;
+        }
+      } else if (startsWith("<![CDATA[")) {
+        if (!skipPast(9,"]]>")) {
+          return FAILED;
+        }
+      } else if (startsWith("<?")) {
+        if (!skipPast(2,"?>")) {
+          return FAILED;
+        }
+      } else if (!skipDeclaration()) {
+        return FAILED;
+      }
+    }
+    return DONE;
+  }
+
+  /* Call after a start tag that is not self closing. Moves past its matching end tag. */
+  bool skipElement() {
+    long depth = 1;
+    for (;;) {
+      switch (next()) {
+        case START:
+          if (!mSelfClosing) {
+            ++depth;
+          }
+          break;
+        case END:
+          if (0 == --depth) {
+            return true;
+          }
+          break;
+        case DONE:
+          return fail("unterminated element");
+        default:
+          return false;
+      }
+    }
+  }
+
+  /* Call after a start tag. Reads the text up to the next tag, including any CDATA sections. */
+  bool text(std::string& out) {
+    out.clear();
+    while (mPos < mEnd) {
+      const char* lt = (const char*)std::memchr(mPos,'<',mEnd - mPos);
+      if (nullptr == lt) {
+        lt = mEnd;
+      }
+      appendXmlText(mPos,lt,out);
+      mPos = lt;
+      if (startsWith("<![CDATA[")) {
+        const char* begin = mPos + 9;
+        if (!skipPast(9,"]]>")) {
+          return false;
+        }
+        out.append(begin,mPos - 3 - begin);
+      } else if (startsWith("<!--")) {
+        if (!skipPast(4,"-->")) {
+          return false;
+        }
+      } else {
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool fail(const char* error) {
+    if (nullptr == mError) {
+      mError = error;
+    }
+    return false;
+  }
+
+private:
+  template <std::size_t N>
+  bool startsWith(const char (&literal)[N]) const {
+    return (std::size_t)(mEnd - mPos) >= N - 1 && 0 == std::memcmp(mPos,literal,N - 1);
+  }
+
+  /* Moves past the next occurrence of literal, at least from characters after the current position */
+  bool skipPast(const std::size_t from,const char* literal) {
+    const std::size_t length = std::strlen(literal);
+    for (const char* p = mPos + from;(std::size_t)(mEnd - p) >= length;++p) {
+      p = (const char*)std::memchr(p,literal[0],mEnd - p);
+      if (nullptr == p || (std::size_t)(mEnd - p) < length) {
+        break;
+      }
+      if (0 == std::memcmp(p,literal,length)) {
+        mPos = p + length;
+        return true;
+      }
+    }
+    return fail("unterminated comment, CDATA section or processing instruction");
+  }
+
+  /* Skips a <!DOCTYPE ...> or similar, including any internal subset in [] */
+  bool skipDeclaration() {
+    long depth = 0;
+    for (const char* p = mPos + 2;p < mEnd;++p) {
+      if ('[' == *p) {
+        ++depth;
+      } else if (']' == *p) {
+        --depth;
+      } else if ('>' == *p && depth <= 0) {
+        mPos = p + 1;
+        return true;
+      }
+    }
+    return fail("unterminated declaration");
+  }
+
+  Token readTag() {
+    mTag = mPos;
+    const bool isEnd = (mEnd - mPos > 1 && '/' == mPos[1]);
+    const char* p = mPos + (isEnd ? 2 : 1);
+    mName.data = p;
+    while (p < mEnd && !isSpace(*p) && '>' != *p && '/' != *p) {
+      ++p;
+    }
+    mName.length = p - mName.data;
+    if (0 == mName.length) {
+      fail("expected an element name");
+      return FAILED;
+    }
+    mAttributes = p;
+    while (p < mEnd && '>' != *p) {
+      if ('"' == *p || '\'' == *p) {
+        // jump to the closing quote, as values may contain '>'
+        const char* close = (const char*)std::memchr(p + 1,*p,mEnd - p - 1);
+        p = (nullptr == close) ? mEnd : close;
+        if (p >= mEnd) {
+          break;
+        }
+      }
+      ++p;
+    }
+    if (p >= mEnd) {
+      fail("unterminated tag");
+      return FAILED;
+    }
+    mSelfClosing = !isEnd && p > mAttributes && '/' == p[-1];
+    mAttributesEnd = mSelfClosing ? p - 1 : p;
+    mPos = p + 1;
+    return isEnd ? END : START;
+  }
+
+  const char* mBegin;
+  const char* mPos;
+  const char* mEnd;
+  const char* mError;
+  const char* mTag;
+  DecodedSpan mName;
+  const char* mAttributes;
+  const char* mAttributesEnd;
+  bool mSelfClosing;
+};
+
+} // end anonymous namespace
+
+
+
+SearchResponseDecoder::SearchResponseDecoder() : mSummary(), mRow(), mKey(), mValue(), mError() {
+  reset();
+}
+
+SearchResponseDecoder::~SearchResponseDecoder() {
+  ;
+}
+
+void SearchResponseDecoder::reset() {
+  mSummary.hasSnippetFormat = false;
+  mSummary.snippetFormat.clear();
+  mSummary.total = 0;
+  mSummary.start = 0;
+  mSummary.pageLength = 0;
+  mSummary.hasMetrics = false;
+  mSummary.queryResolutionTime.clear();
+  mSummary.snippetResolutionTime.clear();
+  mSummary.totalTime.clear();
+  resetRow(mRow);
+  mError.clear();
+}
+
+const SearchResponseDecoder::Summary& SearchResponseDecoder::getSummary() const {
+  return mSummary;
+}
+
+const std::string& SearchResponseDecoder::getError() const {
+  return mError;
+}
+
+bool SearchResponseDecoder::jsonString(const DecodedSpan& span,std::string& out) {
+  if (span.empty()) {
+    return false;
+  }
+  JsonCursor json(span.data,span.length);
+  return '"' == json.peek() && json.string(out);
+}
+
+bool SearchResponseDecoder::decodeJson(const char* data,const std::size_t length,const RowHandler& handler) {
+  reset();
+  JsonCursor json(data,length);
+
+  // Reads one result object into mRow, then passes it to the handler
+  auto row = [this,&json,&handler] () -> bool {
+    resetRow(mRow);
+    const char* begin = json.position();
+    json.consume('{');
+    bool first = true;
+    while (json.member(first,mKey)) {
+      if ("index" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mRow.index);
+        }
+      } else if ("uri" == mKey) {
+        json.scalar(mRow.uri);
+      } else if ("path" == mKey) {
+        json.scalar(mRow.path);
+      } else if ("score" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mRow.score);
+        }
+      } else if ("confidence" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mRow.confidence);
+        }
+      } else if ("fitness" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mRow.fitness);
+        }
+      } else if ("mimetype" == mKey) {
+        json.scalar(mRow.mimeType);
+      } else if ("format" == mKey) {
+        json.scalar(mRow.format);
+      } else if ("content" == mKey) {
+        json.span(mRow.content);
+      } else if ("snippet" == mKey) {
+        json.span(mRow.snippet);
+      } else if ("matches" == mKey) {
+        json.span(mRow.matches);
+      } else {
+        json.skip();
+      }
+      if (json.failed()) {
+        return false;
+      }
+    }
+    if (json.failed()) {
+      return false;
+    }
+    mRow.result = DecodedSpan{begin,(std::size_t)(json.position() - begin)};
+    handler(mRow);
+    return true;
+  };
+
+  if (json.expect('{',"expected a search response object")) {
+    bool first = true;
+    while (json.member(first,mKey)) {
+      if ("snippet-format" == mKey) {
+        mSummary.hasSnippetFormat = json.scalar(mSummary.snippetFormat);
+      } else if ("total" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mSummary.total);
+        }
+      } else if ("start" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mSummary.start);
+        }
+      } else if ("page-length" == mKey) {
+        if (json.scalar(mValue)) {
+          toNumber(mValue,mSummary.pageLength);
+        }
+      } else if ("results" == mKey || "result" == mKey) {
+        const char c = json.peek();
+        if ('{' == c) {
+          row();
+        } else if ('[' == c) {
+          json.consume('[');
+          bool firstRow = true;
+          while (json.element(firstRow)) {
+            if ('{' == json.peek()) {
+              if (!row()) {
+                break;
+              }
+            } else {
+              json.skip();
+            }
+            if (json.failed()) {
+              break;
+            }
+          }
+        } else {
+          json.skip(); // E.g. null
+        }
+      } else if ("metrics" == mKey && '{' == json.peek()) {
+        mSummary.hasMetrics = true;
+        json.consume('{');
+        bool firstMetric = true;
+        while (json.member(firstMetric,mKey)) {
+          if ("query-resolution-time" == mKey) {
+            json.scalar(mSummary.queryResolutionTime);
+          } else if ("snippet-resolution-time" == mKey) {
+            json.scalar(mSummary.snippetResolutionTime);
+          } else if ("total-time" == mKey) {
+            json.scalar(mSummary.totalTime);
+          } else {
+            json.skip();
+          }
+          if (json.failed()) {
+            break;
+          }
+        }
+      } else {
+        json.skip();
+      }
+      if (json.failed()) {
+        break;
+      }
+    }
+  }
+
+  if (json.failed()) {
+    mError = std::string(json.error()) + " at offset " + std::to_string(json.offset());
+    return false;
+  }
+  return true;
+}
+
+bool SearchResponseDecoder::decodeXml(const char* data,const std::size_t length,const RowHandler& handler) {
+  reset();
+  XmlCursor xml(data,length);
+  DecodedSpan name;
+  DecodedSpan value;
+
+  // Reads one search:result element into mRow, then passes it to the handler
+  auto row = [this,&xml,&handler,&name,&value] () -> bool {
+    resetRow(mRow);
+    const char* begin = xml.tag();
+    const char* attr = xml.attributes();
+    while (xml.attribute(attr,name,value)) {
+      std::string* target = nullptr;
+      if (equals(name,"uri")) {
+        target = &mRow.uri;
+      } else if (equals(name,"path")) {
+        target = &mRow.path;
+      } else if (equals(name,"mimetype")) {
+        target = &mRow.mimeType;
+      } else if (equals(name,"format")) {
+        target = &mRow.format;
+      } else if (equals(name,"index") || equals(name,"score") || equals(name,"confidence") || equals(name,"fitness")) {
+        target = &mValue;
+      } else {
+        continue;
+      }
+      target->clear();
+      appendXmlText(value.data,value.data + value.length,*target);
+      if (equals(name,"index")) {
+        toNumber(mValue,mRow.index);
+      } else if (equals(name,"score")) {
+        toNumber(mValue,mRow.score);
+      } else if (equals(name,"confidence")) {
+        toNumber(mValue,mRow.confidence);
+      } else if (equals(name,"fitness")) {
+        toNumber(mValue,mRow.fitness);
+      }
+    }
+    if (!xml.isSelfClosing()) {
+      for (;;) {
+        const XmlCursor::Token token = xml.next();
+        if (XmlCursor::END == token) {
+          break;
+        }
+        if (XmlCursor::START != token) {
+          return xml.fail("unterminated search:result element");
+        }
+        const char* child = xml.tag();
+        DecodedSpan* target = nullptr;
+        if (xml.isName("search:content")) {
+          target = &mRow.content;
+        } else if (xml.isName("search:snippet")) {
+          target = &mRow.snippet;
+        } else if (xml.isName("search:matches")) {
+          target = &mRow.matches;
+        }
+        if (!xml.isSelfClosing() && !xml.skipElement()) {
+          return false;
+        }
+        if (nullptr != target) {
+          *target = DecodedSpan{child,(std::size_t)(xml.position() - child)};
+        }
+      }
+    }
+    mRow.result = DecodedSpan{begin,(std::size_t)(xml.position() - begin)};
+    handler(mRow);
+    return true;
+  };
+
+  XmlCursor::Token token = xml.next();
+  if (XmlCursor::START != token) {
+    xml.fail("expected a search response element");
+  } else {
+    const char* attr = xml.attributes();
+    while (xml.attribute(attr,name,value)) {
+      if (equals(name,"snippet-format")) {
+        mSummary.snippetFormat.clear();
+        appendXmlText(value.data,value.data + value.length,mSummary.snippetFormat);
+        mSummary.hasSnippetFormat = true;
+      } else if (equals(name,"total") || equals(name,"start") || equals(name,"page-length")) {
+        mValue.clear();
+        appendXmlText(value.data,value.data + value.length,mValue);
+        toNumber(mValue,equals(name,"total") ? mSummary.total :
+            (equals(name,"start") ? mSummary.start : mSummary.pageLength));
+      }
+    }
+    bool open = !xml.isSelfClosing();
+    while (open) {
+      token = xml.next();
+      if (XmlCursor::END == token) {
+        break; // end of the response element
+      }
+      if (XmlCursor::START != token) {
+        xml.fail("unterminated search response element");
+        break;
+      }
+      if (xml.isName("search:result")) {
+        open = row();
+      } else if (xml.isName("search:metrics")) {
+        mSummary.hasMetrics = true;
+        const bool empty = xml.isSelfClosing();
+        while (open && !empty) {
+          token = xml.next();
+          if (XmlCursor::END == token) {
+            break;
+          }
+          if (XmlCursor::START != token) {
+            open = xml.fail("unterminated search:metrics element");
+            break;
+          }
+          std::string* target = nullptr;
+          if (xml.isName("search:query-resolution-time")) {
+            target = &mSummary.queryResolutionTime;
+          } else if (xml.isName("search:snippet-resolution-time")) {
+            target = &mSummary.snippetResolutionTime;
+          } else if (xml.isName("search:total-time")) {
+            target = &mSummary.totalTime;
+          }
+          if (!xml.isSelfClosing()) {
+            open = (nullptr == target || xml.text(*target)) && xml.skipElement();
+          }
+        }
+      } else if (!xml.isSelfClosing()) {
+        open = xml.skipElement();
+      }
+    }
+  }
+
+  if (xml.failed()) {
+    mError = std::string(xml.error()) + " at offset " + std::to_string(xml.offset());
+    return false;
+  }
+  return true;
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) MarkLogic Corporation. All rights reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SyncManifest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "mlclient/internals/SyncManifest.hpp"
+#include "mlclient/internals/FileStream.hpp"
+
+#include "mlclient/DocumentContent.hpp"
+#include "mlclient/Permission.hpp"
+#include "mlclient/logging.hpp"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace mlclient {
+
+namespace internals {
+
+namespace {
+
+const std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const std::uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline std::uint64_t rotl64(const std::uint64_t x,const int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+// little endian reads - as on all supported platforms
+inline std::uint64_t read64(const char* p) {
+  std::uint64_t v;
+  std::memcpy(&v,p,sizeof(v));
+  return v;
+}
+
+inline std::uint32_t read32(const char* p) {
+  std::uint32_t v;
+  std::memcpy(&v,p,sizeof(v));
+  return v;
+}
+
+inline std::uint64_t xxRound(std::uint64_t acc,const std::uint64_t input) {
+  acc += input * PRIME64_2;
+  acc = rotl64(acc,31);
+  return acc * PRIME64_1;
+}
+
+inline std::uint64_t xxMergeRound(std::uint64_t acc,const std::uint64_t val) {
+  acc ^= xxRound(0,val);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+std::string escape(const std::string& uri) {
+  if (std::string::npos == uri.find_first_of("\\\t\n")) {
+    return uri;
+  }
+  std::string out;
+  for (const char c : uri) {
+    switch (c) {
+      case '\\': out += "\\\\"; break;
+      case '\t': out += "\\t"; break;
+      case '\n': out += "\\n"; break;
+      default: out += c;
+    }
+  }
+  return out;
+}
+
+std::string unescape(const std::string& field) {
+  if (std::string::npos == field.find('\\')) {
+    return field;
+  }
+  std::string out;
+  for (size_t i = 0;i < field.size();++i) {
+    if ('\\' == field[i] && i + 1 < field.size()) {
+      ++i;
+      out += ('t' == field[i]) ? '\t' : (('n' == field[i]) ? '\n' : field[i]);
+    } else {
+      out += field[i];
+    }
+  }
+  return out;
+}
+
+/* Returns false if the file cannot be stat'ed */
+bool statFile(const std::string& filename,std::uint64_t& size,std::int64_t& modified) {
+#ifndef _WIN32
+  struct stat st;
+  if (0 != ::stat(filename.c_str(),&st)) {
+    return false;
+  }
+#else
+  struct _stat64 st;
+  if (0 != ::_stat64(filename.c_str(),&st)) {
+    return false;
+  }
+#endif
+  size = (std::uint64_t)st.st_size;
+  modified = (std::int64_t)st.st_mtime;
+  return true;
+}
+
+const std::size_t HASH_READ_SIZE = 256 * 1024;
+
+} // end anonymous namespace
+
+std::uint64_t xxhash64(const char* data,const std::size_t length,const std::uint64_t seed) {
+  XxHash64 hash(seed);
+  hash.update(data,length);
+  return hash.digest();
+}
+
+
+
+XxHash64::XxHash64(const std::uint64_t seed) : mSeed(seed), mV1(seed + PRIME64_1 + PRIME64_2), mV2(seed + PRIME64_2),
+    mV3(seed), mV4(seed - PRIME64_1), mTotal(0), mBuffer(), mBuffered(0) {
+  ;
+}
+
+void XxHash64::update(const char* data,const std::size_t length) {
+  if (0 == length) {
+    return;
+  }
+  mTotal += length;
+  if (mBuffered + length < 32) {
+    std::memcpy(mBuffer + mBuffered,data,length);
+    mBuffered += length;
+    return;
+  }
+  const char* p = data;
+  const char* const end = data + length;
+  if (0 != mBuffered) {
+    // complete the stripe begun by the last piece
+    const std::size_t fill = 32 - mBuffered;
+    std::memcpy(mBuffer + mBuffered,p,fill);
+    p += fill;
+    mV1 = xxRound(mV1,read64(mBuffer));
+    mV2 = xxRound(mV2,read64(mBuffer + 8));
+    mV3 = xxRound(mV3,read64(mBuffer + 16));
+    mV4 = xxRound(mV4,read64(mBuffer + 24));
+    mBuffered = 0;
+  }
+  while (p + 32 <= end) {
+    mV1 = xxRound(mV1,read64(p));
+    mV2 = xxRound(mV2,read64(p + 8));
+    mV3 = xxRound(mV3,read64(p + 16));
+    mV4 = xxRound(mV4,read64(p + 24));
+    p += 32;
+  }
+  mBuffered = end - p;
+  if (0 != mBuffered) {
+    std::memcpy(mBuffer,p,mBuffered);
+  }
+}
+
+std::uint64_t XxHash64::digest() const {
+  std::uint64_t h;
+  if (mTotal >= 32) {
+    h = rotl64(mV1,1) + rotl64(mV2,7) + rotl64(mV3,12) + rotl64(mV4,18);
+    h = xxMergeRound(h,mV1);
+    h = xxMergeRound(h,mV2);
+    h = xxMergeRound(h,mV3);
+    h = xxMergeRound(h,mV4);
+  } else {
+    h = mSeed + PRIME64_5;
+  }
+
+  h += mTotal;
+
+  const char* p = mBuffer;
+  const char* const end = mBuffer + mBuffered;
+  while (p + 8 <= end) {
+    h ^= xxRound(0,read64(p));
+    h = rotl64(h,27) * PRIME64_1 + PRIME64_4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= (std::uint64_t)read32(p) * PRIME64_1;
+    h = rotl64(h,23) * PRIME64_2 + PRIME64_3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= (std::uint64_t)(unsigned char)(*p) * PRIME64_5;
+    h = rotl64(h,11) * PRIME64_1;
+    ++p;
+  }
+
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+
+
+SyncManifest::SyncManifest() : mMutex(), mPath(), mRecords() {
+  ;
+}
+
+SyncManifest::~SyncManifest() {
+  ;
+}
+
+bool SyncManifest::load(const std::string& path) {
+  std::lock_guard<std::mutex> lck(mMutex);
+  mPath = path;
+  mRecords.clear();
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::ifstream probe(path,std::ios::binary);
+    if (probe.good()) {
+      return false; // exists, but cannot be read
+    }
+    LOG(DEBUG) << "SyncManifest::load no manifest at " << path << ". All documents will be uploaded.";
+    return true;
+  }
+  std::string line;
+  long malformed = 0;
+  while (std::getline(in,line)) {
+    size_t tabs[4];
+    size_t pos = 0;
+    int found = 0;
+    for (;found < 4;++found) {
+      pos = line.find('\t',pos);
+      if (std::string::npos == pos) {
+        break;
+      }
+      tabs[found] = pos++;
+    }
+    if (found < 4) {
+      ++malformed;
+      continue;
+    }
+    try {
+      Record rec;
+      rec.entry.size = std::stoull(line.substr(tabs[0] + 1,tabs[1] - tabs[0] - 1));
+      rec.entry.modified = std::stoll(line.substr(tabs[1] + 1,tabs[2] - tabs[1] - 1));
+      rec.entry.contentHash = std::stoull(line.substr(tabs[2] + 1,tabs[3] - tabs[2] - 1),nullptr,16);
+      rec.entry.metadataHash = std::stoull(line.substr(tabs[3] + 1),nullptr,16);
+      rec.seen = false;
+      mRecords[unescape(line.substr(0,tabs[0]))] = rec;
+    } catch (std::exception&) {
+      ++malformed;
+    }
+  }
+  if (malformed > 0) {
+    LOG(DEBUG) << "SyncManifest::load ignored " << malformed << " malformed lines in " << path;
+  }
+  LOG(DEBUG) << "SyncManifest::load loaded " << mRecords.size() << " documents from " << path;
+  return true;
+}
+
+bool SyncManifest::check(const Document& doc,Entry& current) {
+  const std::string& uri = doc.getUri();
+  current.metadataHash = metadataHash(doc);
+
+  bool known = false;
+  Entry previous = Entry();
+  {
+    std::lock_guard<std::mutex> lck(mMutex);
+    auto it = mRecords.find(uri);
+    if (mRecords.end() != it) {
+      it->second.seen = true;
+      previous = it->second.entry;
+      known = true;
+    }
+  }
+
+  const IDocumentContent* content = doc.getContent();
+  const FileDocumentContent* file = dynamic_cast<const FileDocumentContent*>(content);
+  if (nullptr != file && statFile(file->getFilename(),current.size,current.modified)) {
+    if (known && 0 != previous.modified && previous.size == current.size && previous.modified == current.modified &&
+        previous.metadataHash == current.metadataHash) {
+      current.contentHash = previous.contentHash; // not touched since - no need to read it
+      return true;
+    }
+    // Read by position rather than mapped, as a file truncated whilst mapped would raise SIGBUS
+    FileBuffer buffer(file->getFilename());
+    if (buffer.isOpen()) {
+      XxHash64 hash;
+      std::vector<char> chunk(HASH_READ_SIZE);
+      std::uint64_t offset = 0;
+      long long read;
+      while (offset < buffer.size() && (read = buffer.readAt(chunk.data(),chunk.size(),offset)) > 0) {
+        hash.update(chunk.data(),(std::size_t)read);
+        offset += (std::uint64_t)read;
+      }
+      current.size = offset; // less than stat'ed if truncated meanwhile, so it will not match next time
+      current.contentHash = hash.digest();
+    } else {
+      const std::string body = file->getContent();
+      current.size = body.size();
+      current.contentHash = xxhash64(body.data(),body.size());
+    }
+  } else {
+    current.modified = 0;
+    if (nullptr == content) {
+      current.size = 0;
+      current.contentHash = xxhash64(nullptr,0);
+    } else {
+      const std::string body = content->getContent();
+      current.size = body.size();
+      current.contentHash = xxhash64(body.data(),body.size());
+    }
+  }
+
+  return known && previous.size == current.size && previous.contentHash == current.contentHash &&
+      previous.metadataHash == current.metadataHash;
+}
+
+void SyncManifest::commit(const std::string& uri,const Entry& entry) {
+  std::lock_guard<std::mutex> lck(mMutex);
+  Record& rec = mRecords[uri];
+  rec.entry = entry;
+  rec.seen = true;
+}
+
+std::vector<std::string> SyncManifest::getUnseen() const {
+  std::vector<std::string> unseen;
+  std::lock_guard<std::mutex> lck(mMutex);
+  for (auto& rec : mRecords) {
+    if (!rec.second.seen) {
+      unseen.push_back(rec.first);
+    }
+  }
+  return unseen;
+}
+
+void SyncManifest::remove(const std::string& uri) {
+  std::lock_guard<std::mutex> lck(mMutex);
+  mRecords.erase(uri);
+}
+
+bool SyncManifest::save() const {
+  std::lock_guard<std::mutex> lck(mMutex);
+  if (mPath.empty()) {
+    return false;
+  }
+  const std::string tmp = mPath + ".tmp";
+  {
+    std::ofstream out(tmp,std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+      LOG(DEBUG) << "SyncManifest::save could not write " << tmp;
+      return false;
+    }
+    for (auto& rec : mRecords) {
+      const Entry& e = rec.second.entry;
+      out << escape(rec.first) << '\t' << std::dec << e.size << '\t' << e.modified << '\t' << std::hex << e.contentHash <<
+          '\t' << e.metadataHash << '\n';
+    }
+    out.flush();
+    if (!out.good()) {
+      LOG(DEBUG) << "SyncManifest::save failed writing " << tmp;
+      return false;
+    }
+  }
+#ifdef _WIN32
+  std::remove(mPath.c_str()); // rename does not replace an existing file on Windows
+#endif
+  if (0 != std::rename(tmp.c_str(),mPath.c_str())) {
+    LOG(DEBUG) << "SyncManifest::save could not rename " << tmp << " to " << mPath;
+    return false;
+  }
+  return true;
+}
+
+std::uint64_t SyncManifest::metadataHash(const Document& doc) {
+  std::ostringstream meta;
+  for (auto& col : doc.getCollections()) {
+    meta << col << '\n';
+  }
+  meta << '\0';
+  for (auto& perm : doc.getPermissions()) {
+    meta << perm << '\n';
+  }
+  meta << '\0';
+  const IDocumentContent* props = doc.getProperties();
+  if (nullptr != props) {
+    meta << props->getContent();
+  }
+  const std::string s = meta.str();
+  return xxhash64(s.data(),s.size());
+}
+
+} // end namespace internals
+
+} // end namespace mlclient
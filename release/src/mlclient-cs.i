@@ -119,6 +119,8 @@ SWIG_STD_VECTOR_ENHANCED(mlclient::ValuesResultValue)
 
 
 %feature("director") IBatchNotifiable;
+%feature("director") IDocumentSource;
+%feature("director") ISearchResultConsumer;
 //%feature("director") ILexiconRef; // throws ostream private constructor error
 //%feature("director") IQuery; // throws ostream private constructor error
 
@@ -163,6 +165,7 @@ SWIG_STD_VECTOR_ENHANCED(mlclient::ValuesResultValue)
 %{
 #include "mlclient/utilities/DocumentHelper.hpp"
 #include "mlclient/utilities/ResponseHelper.hpp"
+#include "mlclient/utilities/DocumentSource.hpp"
 #include "mlclient/utilities/DocumentBatchWriter.hpp"
 // #include "mlclient/utilities/PugiXmlDocumentContent.hpp"
 // #include "mlclient/utilities/PugiXmlHelper.hpp"
@@ -219,6 +222,7 @@ SWIG_STD_VECTOR_ENHANCED(mlclient::utilities::IQuery*)
 // %include "mlclient/utilities/CppRestJsonHelper.hpp"
 //%include "mlclient/utilities/ResponseHelper.hpp"
 %include "mlclient/utilities/DocumentHelper.hpp"
+%include "mlclient/utilities/DocumentSource.hpp"
 %include "mlclient/utilities/DocumentBatchWriter.hpp"
 %include "mlclient/utilities/DocumentBatchHelper.hpp"
 %include "mlclient/utilities/SearchBuilder.hpp"
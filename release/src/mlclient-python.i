@@ -67,6 +67,7 @@
 #include "mlclient/utilities/DocumentBatchHelper.hpp"
 #include "mlclient/utilities/DocumentHelper.hpp"
 #include "mlclient/utilities/ResponseHelper.hpp"
+#include "mlclient/utilities/DocumentSource.hpp"
 #include "mlclient/utilities/DocumentBatchWriter.hpp"
 #include "mlclient/utilities/PugiXmlDocumentContent.hpp"
 #include "mlclient/utilities/PugiXmlHelper.hpp"
@@ -96,6 +97,7 @@
 %include "mlclient/utilities/CppRestJsonHelper.hpp"
 %include "mlclient/utilities/ResponseHelper.hpp"
 %include "mlclient/utilities/DocumentHelper.hpp"
+%include "mlclient/utilities/DocumentSource.hpp"
 %include "mlclient/utilities/DocumentBatchWriter.hpp"
 %include "mlclient/utilities/DocumentBatchHelper.hpp"
 %include "mlclient/utilities/SearchBuilder.hpp"
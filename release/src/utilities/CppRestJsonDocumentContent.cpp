@@ -20,6 +20,7 @@
 
 #include <cpprest/json.h>
 #include <mlclient/utilities/CppRestJsonDocumentContent.hpp>
+#include <mlclient/internals/NodeArena.hpp>
 #include <mlclient/logging.hpp>
 #include <mlclient/InvalidFormatException.hpp>
 #include <iostream>
@@ -75,18 +76,25 @@ IDocumentContent* CppRestJsonContainerNode::getChildContent() const {
 
 class CppRestJsonArrayNode::Impl {
 public:
-  Impl(web::json::array& arr) : array(arr) {
+  Impl(internals::NodeArena* arena,web::json::array& arr) : array(arr), children(arena) {
     ;
   };
 
   web::json::array& array;
+  internals::NodeArenaRef children;
 };
 
-CppRestJsonArrayNode::CppRestJsonArrayNode(web::json::array& arr) : mImpl(new Impl(arr)) {
+CppRestJsonArrayNode::CppRestJsonArrayNode(web::json::array& arr) : mImpl(new Impl(nullptr,arr)) {
+  ;
+}
+CppRestJsonArrayNode::CppRestJsonArrayNode(internals::NodeArena& arena,web::json::array& arr) :
+    mImpl(arena.make<Impl>(&arena,arr)) {
   ;
 }
 CppRestJsonArrayNode::~CppRestJsonArrayNode() {
-  delete mImpl;
+  if (!mImpl->children.isBorrowed()) { // else the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 bool CppRestJsonArrayNode::isArray() const {
@@ -107,7 +115,7 @@ IDocumentNode* CppRestJsonArrayNode::at(const std::string& key) const {
   throw mlclient::InvalidFormatException("JSON Container Array does not support string key subscripts");
 }
 IDocumentNode* CppRestJsonArrayNode::at(const int32_t idx) const {
-  return new CppRestJsonDocumentNode(mImpl->array.at(idx));
+  return mImpl->children.make<CppRestJsonDocumentNode>(mImpl->array.at(idx));
 }
 bool CppRestJsonArrayNode::has(const std::string& key) const {
   throw mlclient::InvalidFormatException("JSON Container Array does not support string key subscripts");
@@ -131,23 +139,51 @@ std::string trimKey(std::string key) {
   }
 }
 
+namespace {
+
+/*
+ * Returns the JSON property name for a key, as trimKey does, but without copying the key unless it has to
+ */
+const utility::string_t& fieldName(const std::string& key,utility::string_t& scratch) {
+#ifdef _UTF16_STRINGS
+  scratch = utility::conversions::to_string_t(trimKey(key));
+  return scratch;
+#else
+  std::string::size_type pos = key.find(':');
+  if (std::string::npos == pos) {
+    return key;
+  }
+  scratch.assign(key,pos + 1,std::string::npos);
+  return scratch;
+#endif
+}
+
+} // end anonymous namespace
+
 
 
 
 class CppRestJsonObjectNode::Impl {
 public:
-  Impl(web::json::object& obj) : obj(obj) {
+  Impl(internals::NodeArena* arena,web::json::object& obj) : obj(obj), children(arena) {
     ;
   };
 
   web::json::object& obj;
+  internals::NodeArenaRef children;
 };
 
-CppRestJsonObjectNode::CppRestJsonObjectNode(web::json::object& obj) : mImpl(new Impl(obj)) {
+CppRestJsonObjectNode::CppRestJsonObjectNode(web::json::object& obj) : mImpl(new Impl(nullptr,obj)) {
+  ;
+}
+CppRestJsonObjectNode::CppRestJsonObjectNode(internals::NodeArena& arena,web::json::object& obj) :
+    mImpl(arena.make<Impl>(&arena,obj)) {
   ;
 }
 CppRestJsonObjectNode::~CppRestJsonObjectNode() {
-  delete mImpl;
+  if (!mImpl->children.isBorrowed()) { // else the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 bool CppRestJsonObjectNode::isArray() const {
@@ -165,15 +201,16 @@ IDocumentNode* CppRestJsonObjectNode::asObject() const {
 }
 
 IDocumentNode* CppRestJsonObjectNode::at(const std::string& key) const {
-  return new CppRestJsonDocumentNode(mImpl->obj.at(utility::conversions::to_string_t(trimKey(key))));
+  utility::string_t scratch;
+  return mImpl->children.make<CppRestJsonDocumentNode>(mImpl->obj.at(fieldName(key,scratch)));
 }
 IDocumentNode* CppRestJsonObjectNode::at(const int32_t idx) const {
   throw mlclient::InvalidFormatException("JSON Container Object does not support integer subscripts");
 }
 
 bool CppRestJsonObjectNode::has(const std::string& key) const {
-  std::string actualKey = trimKey(key);
-  auto foundIter = mImpl->obj.find(utility::conversions::to_string_t(actualKey));
+  utility::string_t scratch;
+  auto foundIter = mImpl->obj.find(fieldName(key,scratch));
   return (mImpl->obj.end() != foundIter);
   /*
   for (auto iter = mImpl->obj.begin();iter != mImpl->obj.end();++iter) {
@@ -232,15 +269,21 @@ IDocumentContent* CppRestJsonObjectNode::getChildContent() const {
 
 class CppRestJsonDocumentNode::Impl {
 public:
-  Impl(web::json::value& root) : root(root) {
+  Impl(internals::NodeArena* arena,web::json::value& root) : root(root), children(arena) {
     ;
   };
 
   web::json::value& root;
+  internals::NodeArenaRef children;
 };
 
 
-CppRestJsonDocumentNode::CppRestJsonDocumentNode(web::json::value& root) : mImpl(new Impl(root)) {
+CppRestJsonDocumentNode::CppRestJsonDocumentNode(internals::NodeArena& arena,web::json::value& root) :
+    mImpl(arena.make<Impl>(&arena,root)) {
+  ;
+}
+
+CppRestJsonDocumentNode::CppRestJsonDocumentNode(web::json::value& root) : mImpl(new Impl(nullptr,root)) {
   //LOG(DEBUG) << "CppRestJsonDocumentNode::ctor";
   //std::ostringstream os;
   //root.serialize(os); // TODO figure out what the hell this is meant to do!
@@ -253,7 +296,9 @@ CppRestJsonDocumentNode::CppRestJsonDocumentNode(CppRestJsonDocumentNode&& from)
 }
 
 CppRestJsonDocumentNode::~CppRestJsonDocumentNode() {
-  delete mImpl;
+  if (nullptr != mImpl && !mImpl->children.isBorrowed()) { // else moved from, or the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 
@@ -312,22 +357,23 @@ std::string CppRestJsonDocumentNode::asString() const {
   return utility::conversions::to_utf8string(mImpl->root.as_string());
 }
 IDocumentNode* CppRestJsonDocumentNode::asArray() const {
-  return new CppRestJsonArrayNode(mImpl->root.as_array());
+  return mImpl->children.make<CppRestJsonArrayNode>(mImpl->root.as_array());
 }
 IDocumentNode* CppRestJsonDocumentNode::asObject() const {
-  return new CppRestJsonObjectNode(mImpl->root.as_object());
+  return mImpl->children.make<CppRestJsonObjectNode>(mImpl->root.as_object());
 }
 
 IDocumentNode* CppRestJsonDocumentNode::at(const std::string& key) const {
-  return new CppRestJsonDocumentNode(mImpl->root.at(utility::conversions::to_string_t(trimKey(key))));
+  utility::string_t scratch;
+  return mImpl->children.make<CppRestJsonDocumentNode>(mImpl->root.at(fieldName(key,scratch)));
 }
 IDocumentNode* CppRestJsonDocumentNode::at(const int32_t idx) const {
-  return new CppRestJsonDocumentNode(mImpl->root.at(idx));
+  return mImpl->children.make<CppRestJsonDocumentNode>(mImpl->root.at(idx));
 }
 
 bool CppRestJsonDocumentNode::has(const std::string& key) const {
-  std::string actualKey = trimKey(key);
-  return mImpl->root.has_field(utility::conversions::to_string_t(actualKey));
+  utility::string_t scratch;
+  return mImpl->root.has_field(fieldName(key,scratch));
 }
 
 StringList CppRestJsonDocumentNode::keys() const {
@@ -371,11 +417,12 @@ IDocumentContent* CppRestJsonDocumentNode::getChildContent() const {
 
 class CppRestJsonDocumentNavigator::Impl {
 public:
-  Impl(web::json::value& root) : root(root) {
+  Impl(web::json::value& root) : root(root), nodes() {
     ;
   };
 
   web::json::value& root;
+  internals::NodeArena nodes; // every node reached from this navigator
 };
 
 CppRestJsonDocumentNavigator::CppRestJsonDocumentNavigator(web::json::value& root,bool firstElementAsRoot) : mImpl(new Impl(root)) {
@@ -404,18 +451,19 @@ IDocumentNode* CppRestJsonDocumentNavigator::firstChild() const {
   return new CppRestJsonDocumentNode(child); // uses move constructor
   // This produces just the first element within the claim
   */
-  return new CppRestJsonObjectNode(mImpl->root.as_object());
+  return mImpl->nodes.make<CppRestJsonObjectNode>(mImpl->nodes,mImpl->root.as_object());
   //return new CppRestJsonDocumentNode(mImpl->root); // this produces a document node above the claim (not the claim itself)
 }
 
 IDocumentNode* CppRestJsonDocumentNavigator::at(const std::string& key) const {
   //LOG(DEBUG) << "CppRestJsonDocumentNavigator::at key: " << key;
-  return new CppRestJsonDocumentNode(mImpl->root.at(utility::conversions::to_string_t(trimKey(key)))); // uses move constructor
+  utility::string_t scratch;
+  return mImpl->nodes.make<CppRestJsonDocumentNode>(mImpl->nodes,mImpl->root.at(fieldName(key,scratch)));
 }
 
 bool CppRestJsonDocumentNavigator::has(const std::string& key) const {
-  std::string actualKey = trimKey(key);
-  return mImpl->root.has_field(utility::conversions::to_string_t(actualKey));
+  utility::string_t scratch;
+  return mImpl->root.has_field(fieldName(key,scratch));
 }
 
 
@@ -484,9 +532,11 @@ int CppRestJsonDocumentContent::getLength() const {
 void CppRestJsonDocumentContent::setContent(std::string content) {
   //LOG(DEBUG) << "CppRestJsonDocumentContent::setContent(std::string&)";
   TIMED_FUNC(CppRestJsonDocumentContent_setContent);
-  std::ostringstream os;
-  os << content;
-  mImpl-> value = web::json::value::parse(utility::conversions::to_string_t(os.str()));
+#ifdef _UTF16_STRINGS
+  mImpl->value = web::json::value::parse(utility::conversions::to_string_t(content));
+#else
+  mImpl->value = web::json::value::parse(content); // no need to copy the string first
+#endif
 }
 
 std::string CppRestJsonDocumentContent::getContent() const {
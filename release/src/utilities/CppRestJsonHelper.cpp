@@ -66,7 +66,11 @@ web::json::value CppRestJsonHelper::fromResponse(const Response& resp) {
   LOG(DEBUG) << "CppRestJsonHelper::fromResponse(Response&)";
   TIMED_FUNC(CppRestJsonHelper_fromResponse);
   if (resp.getResponseType() == ResponseType::JSON) {
+#ifdef _UTF16_STRINGS
     return web::json::value::parse(utility::conversions::to_string_t(resp.getContent()));
+#else
+    return web::json::value::parse(resp.getContent()); // parse the Response's own buffer - string_t is std::string here
+#endif
   } else {
     LOG(DEBUG) << "CppRestJsonHelper::fromResponse(Response&): Invalid format, throwing exception";
     throw InvalidFormatException();
@@ -76,7 +80,11 @@ web::json::value CppRestJsonHelper::fromResponse(const Response& resp) {
 web::json::value CppRestJsonHelper::fromString(const std::string& jsonString) {
   LOG(DEBUG) << "CppRestJsonHelper::fromString(std::string&)";
   TIMED_FUNC(CppRestJsonHelper_fromString);
+#ifdef _UTF16_STRINGS
   return web::json::value::parse(utility::conversions::to_string_t(jsonString));
+#else
+  return web::json::value::parse(jsonString);
+#endif
 }
 
 std::vector<Permission> CppRestJsonHelper::permissionsFromResponse(const Response& resp) {
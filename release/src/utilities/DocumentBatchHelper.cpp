@@ -13,12 +13,27 @@
 #include <mlclient/Permission.hpp>
 #include <mlclient/logging.hpp>
 
+#include <cpprest/http_client.h> // for pplx
+
 #ifndef _WIN32
 #include <dirent.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #else
 #include <Windows.h>
 #endif
 
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include <cstring>
 #include <string>
@@ -144,5 +159,311 @@ void DocumentBatchHelper::addFilesToDocumentSet(const std::string& folder,const
   }
 }
 
+
+namespace {
+
+enum class EntryType {
+  FILE,FOLDER,OTHER,UNKNOWN
+};
+
+typedef std::function<void(const char* name,EntryType type)> EntryCallback;
+
+#ifdef __linux__
+// As returned by the getdents64 system call. Only used to read entries in place from the buffer.
+struct linux_dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+
+const std::size_t GETDENTS_BUFFER_SIZE = 256 * 1024; // many entries per round trip on network file systems
+#endif
+
+#ifndef _WIN32
+EntryType fromDType(const unsigned char dtype) {
+  switch (dtype) {
+    case DT_REG: return EntryType::FILE;
+    case DT_DIR: return EntryType::FOLDER;
+    case DT_UNKNOWN: return EntryType::UNKNOWN; // some file systems (E.g. some NFS and XFS) never fill in d_type
+    default: return EntryType::OTHER;
+  }
+}
+#endif
+
+/*
+ * Calls back with each entry in a folder (excluding . and ..). Returns false if the folder could not be read.
+ */
+bool listFolder(const std::string& folder,const EntryCallback& callback) {
+#ifdef __linux__
+  const int fd = open(folder.c_str(),O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (-1 == fd) {
+    return false;
+  }
+  std::vector<char> buffer(GETDENTS_BUFFER_SIZE);
+  long read;
+  while ((read = syscall(SYS_getdents64,fd,buffer.data(),buffer.size())) > 0) {
+    for (long pos = 0;pos < read;) {
+      const linux_dirent64* entry = reinterpret_cast<const linux_dirent64*>(buffer.data() + pos);
+      const char* name = buffer.data() + pos + offsetof(linux_dirent64,d_name);
+      if (0 != strcmp(name,".") && 0 != strcmp(name,"..")) {
+        callback(name,fromDType(entry->d_type));
+      }
+      pos += entry->d_reclen;
+    }
+  }
+  close(fd);
+  return 0 == read; // -1 if the listing failed part way through
+#elif !defined(_WIN32)
+  DIR* dir = opendir(folder.c_str());
+  if (nullptr == dir) {
+    return false;
+  }
+  struct dirent* entry;
+  errno = 0;
+  while (nullptr != (entry = readdir(dir))) {
+    if (0 != strcmp(entry->d_name,".") && 0 != strcmp(entry->d_name,"..")) {
+      callback(entry->d_name,fromDType(entry->d_type));
+    }
+    errno = 0;
+  }
+  const bool ok = (0 == errno); // readdir returns nullptr on error too
+  closedir(dir);
+  return ok;
+#else
+  WIN32_FIND_DATAW data;
+  HANDLE find = FindFirstFileW(s2ws(folder + "\\*").c_str(),&data);
+  if (INVALID_HANDLE_VALUE == find) {
+    return false;
+  }
+  do {
+    const std::string name = ws2s(data.cFileName);
+    if ("." != name && ".." != name) {
+      if (FILE_ATTRIBUTE_DIRECTORY == (FILE_ATTRIBUTE_DIRECTORY & data.dwFileAttributes)) {
+        callback(name.c_str(),EntryType::FOLDER);
+      } else if (0 == (FILE_ATTRIBUTE_DEVICE & data.dwFileAttributes)) {
+        callback(name.c_str(),EntryType::FILE);
+      } else {
+        callback(name.c_str(),EntryType::OTHER);
+      }
+    }
+  } while (FindNextFileW(find,&data));
+  const bool ok = (ERROR_NO_MORE_FILES == GetLastError());
+  FindClose(find);
+  return ok;
+#endif
+}
+
+EntryType statType(const std::string& path) {
+#ifndef _WIN32
+  struct stat st;
+  if (0 != stat(path.c_str(),&st)) {
+    return EntryType::OTHER;
+  }
+  if (S_ISREG(st.st_mode)) {
+    return EntryType::FILE;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    return EntryType::FOLDER;
+  }
+#endif
+  return EntryType::OTHER;
+}
+
+} // end anonymous namespace
+
+
+
+class DirectoryDocumentSource::Impl {
+public:
+  Impl(const std::string& folder,const std::string& baseFolder,const bool stripBase,const std::string& appendBase,
+      const CollectionSet& collections,const PermissionSet& permissions,IDocumentContent* properties,
+      const long capacity,const bool showHiddenDirs) : baseFolder(baseFolder), stripBase(stripBase),
+      appendBase(appendBase), collections(collections), permissions(permissions), properties(properties),
+      showHiddenDirs(showHiddenDirs), queue(capacity), mutex(), workAvailable(), folders(), pending(1),
+      stopped(false), filesFound(0), foldersRead(0), foldersFailed(0), failedFolders(), enumerationComplete(false),
+      walkers() {
+    folders.push_back(folder);
+  }
+
+  /*
+   * Run by each walker. Takes the next unread folder, reads it (queueing its subfolders for any walker), and
+   * finishes once no folders remain queued or being read.
+   */
+  void walk() {
+    while (true) {
+      std::string folder;
+      {
+        std::unique_lock<std::mutex> lck(mutex);
+        workAvailable.wait(lck,[this] {return stopped || !folders.empty() || 0 == pending;});
+        if (stopped || folders.empty()) {
+          return;
+        }
+        folder = std::move(folders.front());
+        folders.pop_front();
+      }
+
+      readFolder(folder);
+
+      bool done;
+      {
+        std::lock_guard<std::mutex> lck(mutex);
+        done = (0 == --pending);
+      }
+      if (done) {
+        LOG(DEBUG) << "DirectoryDocumentSource finished listing. Files: " << filesFound << ", folders: " << foldersRead <<
+            ", failed folders: " << foldersFailed;
+        enumerationComplete = true;
+        queue.close(); // next() returns false once the remaining documents are pulled
+        workAvailable.notify_all();
+      }
+    }
+  }
+
+  void readFolder(const std::string& folder) {
+    LOG(DEBUG) << "Reading: " << folder;
+    const bool ok = listFolder(folder,[this,&folder] (const char* name,EntryType type) {
+      if (stopped) {
+        return;
+      }
+      const std::string path(folder + "/" + name); // TODO platform independent file separator
+      if (EntryType::UNKNOWN == type) {
+        type = statType(path);
+      }
+      if (EntryType::FOLDER == type) {
+        if (showHiddenDirs || '.' != name[0]) {
+          {
+            std::lock_guard<std::mutex> lck(mutex);
+            folders.push_back(path);
+            pending++;
+          }
+          workAvailable.notify_one();
+        }
+      } else if (EntryType::FILE == type) {
+        addFile(folder,name,path);
+      }
+    });
+    if (!ok) {
+      const int error = errno;
+      LOG(DEBUG) << "DirectoryDocumentSource could not read folder (or all of it), errno: " << error << ", folder: " <<
+          folder;
+      std::lock_guard<std::mutex> lck(mutex);
+      failedFolders.push_back(folder);
+      foldersFailed++;
+    }
+    foldersRead++;
+  }
+
+  void addFile(const std::string& folder,const std::string& name,const std::string& path) {
+    // Same URI scheme as addFilesToDocumentSet
+    std::string fname(folder);
+    if (stripBase) {
+      if (fname == baseFolder) {
+        fname = "";
+      } else {
+        fname = fname.substr(baseFolder.length() + 1);
+      }
+    }
+    Document doc(appendBase + fname + "/" + name); // TODO platform independent file separator
+    doc.setCollections(collections);
+    doc.setPermissions(permissions);
+    doc.setProperties(properties);
+    doc.setContent(new FileDocumentContent(path));
+    filesFound++;
+    if (!queue.push(std::move(doc))) { // waits whilst the writer catches up
+      stop(); // cancelled
+    }
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lck(mutex);
+      stopped = true;
+    }
+    workAvailable.notify_all();
+  }
+
+  const std::string baseFolder;
+  const bool stripBase;
+  const std::string appendBase;
+  const CollectionSet collections;
+  const PermissionSet permissions;
+  IDocumentContent* properties;
+  const bool showHiddenDirs;
+
+  BoundedDocumentQueue queue;
+
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::deque<std::string> folders; // found but not yet read
+  long pending; // folders queued or being read
+  std::atomic<bool> stopped;
+
+  std::atomic<long> filesFound;
+  std::atomic<long> foldersRead;
+  std::atomic<long> foldersFailed;
+  std::vector<std::string> failedFolders; // guarded by mutex
+  std::atomic<bool> enumerationComplete;
+
+  std::vector<pplx::task<void>> walkers;
+};
+
+DirectoryDocumentSource::DirectoryDocumentSource(const std::string& folder,const std::string& baseFolder,
+    const bool stripBase,const std::string& appendBase,const CollectionSet& collections,
+    const PermissionSet& permissions,IDocumentContent* properties,const int walkerThreads,const long capacity,
+    bool showHiddenDirs) : mImpl(mlclient::make_unique<Impl>(folder,baseFolder,stripBase,appendBase,collections,
+    permissions,properties,capacity,showHiddenDirs)) {
+  LOG(DEBUG) << "DirectoryDocumentSource listing folder: " << folder << " with baseFolder: " << baseFolder;
+  Impl* impl = mImpl.get();
+  const int threads = (walkerThreads < 1) ? 1 : walkerThreads;
+  for (int i = 0;i < threads;i++) {
+    mImpl->walkers.push_back(pplx::task<void>([impl] () {
+      impl->walk();
+    }));
+  }
+}
+
+DirectoryDocumentSource::~DirectoryDocumentSource() {
+  cancel();
+  for (auto& walker : mImpl->walkers) {
+    walker.wait();
+  }
+}
+
+bool DirectoryDocumentSource::next(Document& out) {
+  return mImpl->queue.next(out);
+}
+
+void DirectoryDocumentSource::cancel() {
+  mImpl->stop();
+  mImpl->queue.cancel(); // wakes any walker waiting to push
+}
+
+const long DirectoryDocumentSource::getFilesFound() const {
+  return mImpl->filesFound;
+}
+
+const long DirectoryDocumentSource::getFoldersRead() const {
+  return mImpl->foldersRead;
+}
+
+const long DirectoryDocumentSource::getFoldersFailed() const {
+  return mImpl->foldersFailed;
+}
+
+std::vector<std::string> DirectoryDocumentSource::getFailedFolders() const {
+  std::lock_guard<std::mutex> lck(mImpl->mutex);
+  return mImpl->failedFolders;
+}
+
+const long DirectoryDocumentSource::getFailureCount() const {
+  return getFoldersFailed();
+}
+
+const bool DirectoryDocumentSource::isEnumerationComplete() const {
+  return mImpl->enumerationComplete;
+}
+
 } // end namespace utilities
 } // end namespace mlclient
@@ -10,18 +10,33 @@
 #include <mlclient/DocumentSet.hpp>
 #include <mlclient/Connection.hpp>
 #include <mlclient/Document.hpp>
+#include <mlclient/DocumentContent.hpp>
 #include <mlclient/Response.hpp>
 #include <mlclient/logging.hpp>
 #include <mlclient/InvalidFormatException.hpp>
 #include <mlclient/mlclient.hpp>
+#include <mlclient/internals/ConcurrencyLimiter.hpp>
+#include <mlclient/internals/SyncManifest.hpp>
 
 // We can use the following, because cpprest is an internal API dependency
 #include <cpprest/http_client.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
-#include <cmath>
 
 namespace mlclient {
 
@@ -31,17 +46,563 @@ IBatchNotifiable::~IBatchNotifiable() {
   ;
 }
 
-static DocumentSet emptyDocumentSet;
+/*
+ * Tunes batch size and concurrency from the latency and outcome of each completed batch, within the configured
+ * AdaptiveBatchParameters. Thread safe.
+ */
+class BatchTuner {
+public:
+  BatchTuner() : mMutex(), mParams(), mParallelTasks(1), mBatchBytes(0), mBatchSize(1), mDocBytes(0.0),
+      mBestLatencyPerByte(0.0), mHealthySinceIncrease(0) {
+    ;
+  }
+
+  void reset(const AdaptiveBatchParameters& params,const int initialTasks,const long initialBatchSize) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    mParams = params;
+    if (mParams.minParallelTasks < 1) {
+      mParams.minParallelTasks = 1;
+    }
+    mParams.maxParallelTasks = std::max(mParams.maxParallelTasks,mParams.minParallelTasks);
+    mParams.minBatchBytes = std::max(mParams.minBatchBytes,1L);
+    mParams.maxBatchBytes = std::max(mParams.maxBatchBytes,mParams.minBatchBytes);
+    mParams.maxBatchSize = std::max(mParams.maxBatchSize,1L);
+    mParallelTasks = std::min(std::max(initialTasks,mParams.minParallelTasks),mParams.maxParallelTasks);
+    mBatchBytes = mParams.minBatchBytes;
+    mBatchSize = std::min(std::max(initialBatchSize,1L),mParams.maxBatchSize); // until we know document sizes
+    mDocBytes = 0.0;
+    mBestLatencyPerByte = 0.0;
+    mHealthySinceIncrease = 0;
+  }
+
+  void record(const long docs,const long long bytes,const long duration,const bool overloaded) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (docs > 0 && bytes > 0) {
+      const double docBytes = (double)bytes / docs;
+      mDocBytes = (0.0 == mDocBytes) ? docBytes : (0.8 * mDocBytes + 0.2 * docBytes); // smoothed
+    }
+
+    if (overloaded) {
+      // multiplicative decrease
+      mParallelTasks = std::max(mParallelTasks / 2,mParams.minParallelTasks);
+      mBatchBytes = std::max(mBatchBytes / 2,mParams.minBatchBytes);
+      mHealthySinceIncrease = 0;
+    } else {
+      // batch size: aim for batches taking around the target duration
+      if (duration < mParams.targetBatchDuration) {
+        mBatchBytes = std::min(mBatchBytes + mBatchBytes / 2,mParams.maxBatchBytes);
+      } else if (duration > 2 * mParams.targetBatchDuration) {
+        mBatchBytes = std::max(mBatchBytes - mBatchBytes / 4,mParams.minBatchBytes);
+      }
+
+      // concurrency: back off gently if latency per byte has doubled against the best seen (requests queueing at
+      // the server), else add one more task after each full round of healthy batches
+      const double latencyPerByte = (double)std::max(duration,1L) / (double)std::max(bytes,1LL);
+      if (0.0 == mBestLatencyPerByte || latencyPerByte < mBestLatencyPerByte) {
+        mBestLatencyPerByte = latencyPerByte;
+      }
+      if (latencyPerByte > 2.0 * mBestLatencyPerByte) {
+        mParallelTasks = std::max(mParallelTasks - 1,mParams.minParallelTasks);
+        mHealthySinceIncrease = 0;
+      } else if (++mHealthySinceIncrease >= mParallelTasks) {
+        mParallelTasks = std::min(mParallelTasks + 1,mParams.maxParallelTasks);
+        mHealthySinceIncrease = 0;
+      }
+    }
+
+    if (mDocBytes > 0.0) {
+      mBatchSize = std::min(std::max((long)(mBatchBytes / mDocBytes),1L),mParams.maxBatchSize);
+    }
+    LOG(DEBUG) << "BatchTuner::record now using " << mParallelTasks << " tasks, " << mBatchSize << " documents (" <<
+        mBatchBytes << " bytes) per batch";
+  }
+
+  int getParallelTasks() const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mParallelTasks;
+  }
+
+  long getBatchSize() const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mBatchSize;
+  }
+
+  long getBatchBytes() const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mBatchBytes;
+  }
+
+  int getMaxParallelTasks() const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mParams.maxParallelTasks;
+  }
+
+private:
+  mutable std::mutex mMutex;
+  AdaptiveBatchParameters mParams;
+  int mParallelTasks;
+  long mBatchBytes;
+  long mBatchSize;
+  double mDocBytes;
+  double mBestLatencyPerByte;
+  int mHealthySinceIncrease;
+};
+
+/*
+ * An append only record of batch outcomes, so that an interrupted upload can be resumed without re-sending
+ * committed documents. Thread safe.
+ *
+ * Each line is OK or FAIL, the positions of the batch's first and last documents in the upload, then the batch's
+ * URIs - all tab separated, with backslashes, tabs and newlines within URIs escaped. Lines are flushed as written,
+ * so a crash loses at most the batches in flight.
+ *
+ * On resume only a 64 bit hash of each committed URI is held, so ten million committed documents take 80MB.
+ */
+class BatchJournal {
+public:
+  BatchJournal() : mMutex(), mOut(), mCommitted() {
+    ;
+  }
+
+  bool open(const std::string& path,const bool resume) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    mCommitted.clear();
+    if (mOut.is_open()) {
+      mOut.close();
+    }
+    if (resume) {
+      std::ifstream in(path);
+      std::string line;
+      while (std::getline(in,line)) {
+        if (0 != line.compare(0,3,"OK\t")) {
+          continue; // failed batches are to be retried
+        }
+        // skip the first and last positions, then each field is a URI
+        size_t start = line.find('\t',line.find('\t',3) + 1);
+        while (std::string::npos != start) {
+          const size_t end = line.find('\t',start + 1);
+          mCommitted.push_back(hash(line.substr(start + 1,(std::string::npos == end) ? std::string::npos : end - start - 1)));
+          start = end;
+        }
+      }
+      std::sort(mCommitted.begin(),mCommitted.end());
+      mCommitted.erase(std::unique(mCommitted.begin(),mCommitted.end()),mCommitted.end());
+      LOG(DEBUG) << "BatchJournal::open resuming with " << mCommitted.size() << " committed documents from " << path;
+    }
+    mOut.open(path,resume ? (std::ios::out | std::ios::app) : (std::ios::out | std::ios::trunc));
+    return mOut.is_open();
+  }
+
+  bool isOpen() const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    return mOut.is_open();
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (mOut.is_open()) {
+      mOut.close();
+    }
+  }
+
+  /* Only valid once open() has returned. Does not change during an upload, so needs no lock. */
+  bool isCommitted(const std::string& uri) const {
+    return !mCommitted.empty() && std::binary_search(mCommitted.begin(),mCommitted.end(),hash(escape(uri)));
+  }
+
+  void record(const bool ok,const long first,const long last,const DocumentUriSet& uris) {
+    std::ostringstream line;
+    line << (ok ? "OK" : "FAIL") << '\t' << first << '\t' << last;
+    for (auto& uri : uris) {
+      line << '\t' << escape(uri);
+    }
+    line << '\n';
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (mOut.is_open()) {
+      mOut << line.str();
+      mOut.flush();
+    }
+  }
+
+private:
+  static std::string escape(const std::string& uri) {
+    if (std::string::npos == uri.find_first_of("\\\t\n")) {
+      return uri;
+    }
+    std::string out;
+    for (const char c : uri) {
+      switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        default: out += c;
+      }
+    }
+    return out;
+  }
+
+  /* FNV-1a. Applied to the escaped URI, as held in the journal. */
+  static uint64_t hash(const std::string& escapedUri) {
+    uint64_t h = 14695981039346656037ULL;
+    for (const char c : escapedUri) {
+      h ^= (unsigned char)c;
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  mutable std::mutex mMutex;
+  std::ofstream mOut;
+  std::vector<uint64_t> mCommitted; // sorted hashes
+};
+
+/*
+ * Documents that could not be saved, appended one JSON object per line (NDJSON) so they can be inspected, fixed and
+ * re-sent. Lines are flushed as written. Thread safe.
+ */
+class DeadLetterFile {
+public:
+  DeadLetterFile() : mMutex(), mOut() {
+    ;
+  }
+
+  bool open(const std::string& path) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (mOut.is_open()) {
+      mOut.close();
+    }
+    mOut.open(path,std::ios::out | std::ios::app);
+    return mOut.is_open();
+  }
+
+  void record(const Document& doc,const long position,const int status,const std::string& error,const int attempts) {
+    std::ostringstream line;
+    line << "{\"uri\":" << quote(doc.getUri()) << ",\"position\":" << position << ",\"status\":" << status <<
+        ",\"error\":" << quote(error) << ",\"attempts\":" << attempts;
+    const IDocumentContent* content = doc.getContent();
+    if (nullptr != content) {
+      const std::string mime = content->getMimeType();
+      line << ",\"mimeType\":" << quote(mime);
+      const FileDocumentContent* file = dynamic_cast<const FileDocumentContent*>(content);
+      if (nullptr != file) {
+        line << ",\"file\":" << quote(file->getFilename());
+      } else if (IDocumentContent::MIME_JSON == mime || IDocumentContent::MIME_XML == mime ||
+          IDocumentContent::MIME_TXT == mime) {
+        line << ",\"content\":" << quote(content->getContent()); // binary content is not valid JSON text
+      }
+    }
+    line << ",\"collections\":[";
+    bool first = true;
+    for (auto& col : doc.getCollections()) {
+      line << (first ? "" : ",") << quote(col);
+      first = false;
+    }
+    line << "]}\n";
+    std::lock_guard<std::mutex> lck(mMutex);
+    if (mOut.is_open()) {
+      mOut << line.str();
+      mOut.flush();
+    }
+  }
+
+private:
+  static std::string quote(const std::string& value) {
+    std::string out("\"");
+    for (const char c : value) {
+      switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          if ((unsigned char)c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xf];
+            out += hex[c & 0xf];
+          } else {
+            out += c;
+          }
+      }
+    }
+    out += '"';
+    return out;
+  }
+
+  std::mutex mMutex;
+  std::ofstream mOut;
+};
+
+/*
+ * Sliding window throughput, and batch request latency as an EWMA and a fixed size histogram, for Progress.
+ * Thread safe.
+ *
+ * Throughput is held in one slot per second, so the window's rates are exact to within the current second. Latency
+ * histogram buckets are log scale, four per doubling, so percentiles are reported to within 19% in fixed memory
+ * however many batches are sent.
+ */
+class BatchMetrics {
+public:
+  static const int WINDOW = DocumentBatchWriter::METRICS_WINDOW_SECONDS;
+  static const int BUCKETS = 128; // up to 2^32 ms
+
+  BatchMetrics() : mMutex() {
+    reset(0);
+  }
+
+  void reset(const long nowMs) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    mStart = nowMs;
+    for (auto& slot : mSlots) {
+      slot.second = -1;
+      slot.docs = 0;
+      slot.bytes = 0;
+    }
+    for (auto& count : mHistogram) {
+      count = 0;
+    }
+    mRequests = 0;
+    mBytes = 0;
+    mAverage = 0.0;
+  }
+
+  void recordRequest(const long nowMs,const long long bytes,const long latency) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    slot(nowMs).bytes += bytes;
+    mBytes += bytes;
+    mAverage = (0 == mRequests) ? latency : mAverage + 0.2 * (latency - mAverage);
+    ++mRequests;
+    ++mHistogram[bucket(latency)];
+  }
+
+  void recordCompleted(const long nowMs,const long docs) {
+    std::lock_guard<std::mutex> lck(mMutex);
+    slot(nowMs).docs += docs;
+  }
+
+  void fill(Progress& p,const long nowMs) const {
+    std::lock_guard<std::mutex> lck(mMutex);
+    const long second = nowMs / 1000;
+    long docs = 0;
+    long long bytes = 0;
+    for (auto& slot : mSlots) {
+      if (slot.second > second - WINDOW && slot.second <= second) {
+        docs += slot.docs;
+        bytes += slot.bytes;
+      }
+    }
+    const long span = nowMs - std::max(mStart,(second - WINDOW + 1) * 1000);
+    const double seconds = (span < 1 ? 1 : span) / 1000.0;
+    p.windowRate = docs / seconds;
+    p.windowMegabytesPerSecond = bytes / seconds / (1024.0 * 1024.0);
+    p.bytesSent = mBytes;
+    p.latencyAverage = mAverage;
+    p.latencyP50 = percentile(0.50);
+    p.latencyP95 = percentile(0.95);
+    p.latencyP99 = percentile(0.99);
+  }
+
+private:
+  struct Slot {
+    long second;
+    long docs;
+    long long bytes;
+  };
+
+  /* Returns the slot for the given time, clearing it if it last held an earlier second. Call with the lock held. */
+  Slot& slot(const long nowMs) {
+    const long second = nowMs / 1000;
+    Slot& s = mSlots[second % WINDOW];
+    if (s.second != second) {
+      s.second = second;
+      s.docs = 0;
+      s.bytes = 0;
+    }
+    return s;
+  }
+
+  static int bucket(const long latency) {
+    if (latency <= 1) {
+      return 0;
+    }
+    return std::min(BUCKETS - 1,(int)std::ceil(4.0 * std::log2((double)latency)));
+  }
+
+  /* The upper bound of the bucket holding the given quantile. Call with the lock held. */
+  long percentile(const double quantile) const {
+    if (0 == mRequests) {
+      return 0;
+    }
+    const long long target = (long long)std::ceil(quantile * mRequests);
+    long long seen = 0;
+    for (int i = 0;i < BUCKETS;i++) {
+      seen += mHistogram[i];
+      if (seen >= target) {
+        return (long)std::pow(2.0,i / 4.0);
+      }
+    }
+    return (long)std::pow(2.0,(BUCKETS - 1) / 4.0);
+  }
+
+  mutable std::mutex mMutex;
+  long mStart;
+  Slot mSlots[WINDOW];
+  long long mHistogram[BUCKETS];
+  long long mRequests;
+  long long mBytes;
+  double mAverage;
+};
+
+/*
+ * Completes tasks after a delay, so a batch waiting to be retried holds no pool thread. One timer thread, started on
+ * first use, completes each delay as it falls due. Thread safe.
+ */
+class BackoffTimer {
+public:
+  BackoffTimer() : mMutex(), mChanged(), mDue(), mThread(), mCancelled(false), mStopping(false) {
+    ;
+  }
+
+  ~BackoffTimer() {
+    {
+      std::lock_guard<std::mutex> lck(mMutex);
+      mStopping = true;
+    }
+    mChanged.notify_all();
+    if (mThread.joinable()) {
+      mThread.join();
+    }
+    cancelAll();
+  }
+
+  pplx::task<void> after(const long millis) {
+    pplx::task_completion_event<void> tce;
+    {
+      std::lock_guard<std::mutex> lck(mMutex);
+      if (mCancelled) {
+        tce.set();
+        return pplx::create_task(tce);
+      }
+      if (!mThread.joinable()) {
+        mThread = std::thread([this] () {
+          run();
+        });
+      }
+      mDue.emplace(std::chrono::steady_clock::now() + std::chrono::milliseconds(millis),tce);
+    }
+    mChanged.notify_all();
+    return pplx::create_task(tce);
+  }
+
+  /* Completes every pending delay now, and any later ones as soon as they are asked for */
+  void cancelAll() {
+    std::multimap<std::chrono::steady_clock::time_point,pplx::task_completion_event<void>> due;
+    {
+      std::lock_guard<std::mutex> lck(mMutex);
+      mCancelled = true;
+      due.swap(mDue);
+    }
+    for (auto& delay : due) {
+      delay.second.set();
+    }
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lck(mMutex);
+    while (!mStopping) {
+      if (mDue.empty()) {
+        mChanged.wait(lck);
+      } else if (mDue.begin()->first > std::chrono::steady_clock::now()) {
+        // copied, as cancelAll() may remove it whilst we wait
+        const std::chrono::steady_clock::time_point next = mDue.begin()->first;
+        mChanged.wait_until(lck,next);
+      } else {
+        pplx::task_completion_event<void> tce = mDue.begin()->second;
+        mDue.erase(mDue.begin());
+        lck.unlock();
+        tce.set(); // outside the lock - may run continuations inline
+        lck.lock();
+      }
+    }
+  }
+
+  std::mutex mMutex;
+  std::condition_variable mChanged;
+  std::multimap<std::chrono::steady_clock::time_point,pplx::task_completion_event<void>> mDue;
+  std::thread mThread;
+  bool mCancelled;
+  bool mStopping;
+};
+
+/*
+ * The outcome of one attempt to save a batch
+ */
+enum class BatchOutcome : int {
+  SAVED,
+  RETRYABLE, // the server is overloaded or unreachable - try again later
+  REJECTED // the server refused the content, or it could not be sent - retrying will not help
+};
+
+/*
+ * The documents of a batch, and what is needed to record their outcome. Shared by every request for them (including
+ * retries and split halves), so lives until the last completes.
+ */
+struct PendingBatch {
+  PendingBatch() : owned(), docs(&owned), start(0), entries(), positions(), syncing(false), gapped(false) {
+    ;
+  }
+  PendingBatch(DocumentSet& shared) : owned(), docs(&shared), start(0), entries(), positions(), syncing(false),
+      gapped(false) {
+    ;
+  }
+
+  DocumentSet owned; // the documents, unless they are the writer's own set
+  DocumentSet* docs;
+  long start; // the position in the whole upload of owned[0], if pulled from a source
+  std::vector<mlclient::internals::SyncManifest::Entry> entries; // parallel to docs, if syncing
+  std::vector<long> positions; // parallel to docs. Used once gapped by documents being left out.
+  bool syncing;
+  bool gapped;
+};
+
+/*
+ * The attempts made to send one batch (or half batch)
+ */
+struct SendAttempts {
+  SendAttempts() : count(0), status(0), error() {
+    ;
+  }
+
+  int count;
+  int status; // of the last attempt - the HTTP response code, or 0 if no response was received
+  std::string error;
+};
 
 class DocumentBatchWriter::Impl {
 public:
-  Impl(IConnection* conn) : mConn(conn), set(emptyDocumentSet), parallelTasks(5),batchSize(10),
-      mode(TransactionMode::PER_BATCH),toNotify(),complete(false),cancelled(false),finished(true),
-      overall(),latest(), completeUris(), tasks(), startTime(1) {
+  Impl(IConnection* conn) : mConn(conn), set(), source(nullptr), sourceExhausted(false), pulledCount(0), sourceMutex(),
+      parallelTasks(5),batchSize(10),
+      mode(TransactionMode::PER_BATCH),adaptive(false),adaptiveParams(),tuner(),limiter(),toNotify(),complete(false),cancelled(false),finished(true),started(false),
+      nextIdx(0), completedCount(0), failedCount(0), skippedCount(0), deletedCount(0), activeWorkers(0), runningWorkers(0),
+      runBatchSize(10), journal(), resuming(false), manifest(), syncing(false), deleteMissing(false),
+      retry(), runRetry(), deadLetters(), retryCount(0), rngMutex(), rng(std::random_device()()), timer(), metrics(),
+      inFlight(0), overall(),latest(), tasks(), pullTail(), startTime(1), progressMutex(), notifyMutex() {
     ;
   }
 
-  // TODO destructor that destroys all task pointers (delete) in vector
+  ~Impl() {
+    // Workers reference this instance, so never let them outlive it
+    if (0 != activeWorkers.load()) {
+      stop(); // only touches the source whilst still in use, as it may be destroyed once we've finished
+    }
+    try {
+      waitAll();
+    } catch (std::exception& ref) {
+      LOG(DEBUG) << "Exception in document batch writer task: " << ref.what(); // never throw from a destructor
+    }
+  }
 
   long now() {
     auto time = std::chrono::system_clock::now();
@@ -54,185 +615,650 @@ public:
   }
 
   void calculateProgress() {
+    std::lock_guard<std::mutex> lck(progressMutex);
     long n = now();
-    LOG(DEBUG) << "calculateProgress. Now: " << n;
-    LOG(DEBUG) << "calculateProgress. start time: " << startTime;
-    latest.completed = completeUris.size();
-    LOG(DEBUG) << "Completed: " << latest.completed;
-    latest.percentageComplete = 100.0 * latest.completed / set.size();
-    latest.total = set.size();
-    LOG(DEBUG) << "after total: " << latest.total;
+    latest.completed = completedCount.load();
+    latest.failed = failedCount.load();
+    latest.skipped = skippedCount.load();
+    latest.deleted = deletedCount.load();
+    latest.retries = retryCount.load();
+    if (adaptive) {
+      latest.parallelTasks = tuner.getParallelTasks();
+      latest.batchSize = tuner.getBatchSize();
+      latest.batchBytes = tuner.getBatchBytes();
+    } else {
+      latest.parallelTasks = parallelTasks;
+      latest.batchSize = runBatchSize;
+      latest.batchBytes = 0;
+    }
+    latest.total = (nullptr == source) ? (long)set.size() : (sourceExhausted ? pulledCount.load() : -1);
+    if (-1 == latest.total) {
+      latest.percentageComplete = 0.0; // total not yet known
+    } else {
+      latest.percentageComplete = (0 == latest.total) ? 100.0 : (100.0 * latest.completed / latest.total);
+    }
     latest.duration = n - startTime;
     if (0 == latest.duration) {
       latest.duration = 1;
     }
-    LOG(DEBUG) << "After duration: " << latest.duration;
-    latest.durationEstimateRemaining = 1;
-    if (0 != latest.completed) {
-      latest.durationEstimateRemaining = ((latest.total - latest.completed) * latest.duration) / latest.completed;
-    }
-    LOG(DEBUG) << "Before rate";
     if (0 == latest.completed) {
-      LOG(DEBUG) << "Setting rate to 1.0";
       latest.rate = 1.0;
     } else {
-      LOG(DEBUG) << "Calculating rate";
       latest.rate = ((double)latest.completed * 1000.0) / ((double)latest.duration);
     }
-
-    LOG(DEBUG) << "After calc";
-
-    // TODO make the above just for the last X seconds, and update overall separately
+    metrics.fill(latest,n);
+    latest.inFlight = inFlight.load();
+
+    // Estimate from recent throughput once there is a full window of it, so the estimate reacts to slow downs
+    latest.durationEstimateRemaining = (-1 == latest.total) ? -1 : 1;
+    if (-1 != latest.total) {
+      const long remaining = latest.total - latest.completed;
+      if (latest.duration >= DocumentBatchWriter::METRICS_WINDOW_SECONDS * 1000L) {
+        latest.durationEstimateRemaining = (latest.windowRate > 0.0) ? (long)(remaining * 1000.0 / latest.windowRate) : -1;
+      } else if (0 != latest.completed) {
+        latest.durationEstimateRemaining = (remaining * latest.duration) / latest.completed;
+      }
+    }
 
     overall = latest; // copy
-    LOG(DEBUG) << "after overall assignment";
+  }
+
+  Progress getProgress() {
+    if (started && !complete) {
+      calculateProgress(); // so windowed figures are current even whilst no batch completes
+    }
+    std::lock_guard<std::mutex> lck(progressMutex);
+    return overall; // copy
   }
 
   void checkComplete() {
-    LOG(DEBUG) << "Start check complete";
-    bool newComplete = true;
-    for (auto& iter: tasks) {
-      LOG(DEBUG) << "Task id: " << iter.second << " is done?: " << iter.second->is_done();
-      newComplete = newComplete && iter.second->is_done();
-    }
-    complete = newComplete;
-    finished = (completeUris.size() == set.size());
-    LOG(DEBUG) << "Is complete?: " << finished;
+    complete = (0 == activeWorkers.load());
+    if (nullptr == source) {
+      finished = (completedCount.load() == (long)set.size());
+    } else {
+      finished = (sourceExhausted && completedCount.load() == pulledCount.load());
+    }
     calculateProgress();
-    LOG(DEBUG) << "End check complete";
   }
 
-  void begin() {
-    if (complete || !finished) {
-      return; // stop starting the work twice
+  void notify(const DocumentUriSet& uris,const bool success,const std::exception& problem) {
+    // one at a time, so listeners need not be thread safe
+    std::lock_guard<std::mutex> lck(notifyMutex);
+    for (auto& tell: toNotify) {
+      tell->batchOperationComplete(uris,success,problem);
     }
-    complete = false;
-    finished = false;
-    startTime = now();
-    calculateProgress(); // initialises correct values for 'complete' in 'overall' progress struct
+  }
 
-    // start parallelTasks
+  /*
+   * Sends a batch, first leaving out any documents unchanged since the last sync, and any committed by a previous
+   * run if resuming from a journal. position is the position of docs[startIdx] in the whole upload. The task
+   * completes once every document in the batch has been saved or dead lettered.
+   */
+  pplx::task<void> writeBatchAsync(std::shared_ptr<PendingBatch> batch,const long startIdx,const long endIdx,
+      const long position) {
+    if (!resuming && !syncing) {
+      return sendBatchAsync(batch,startIdx,endIdx,position);
+    }
+    std::shared_ptr<PendingBatch> pending = std::make_shared<PendingBatch>();
+    pending->syncing = syncing;
+    for (long idx = startIdx; idx <= endIdx;idx++) {
+      const Document& doc = batch->docs->at(idx);
+      mlclient::internals::SyncManifest::Entry entry;
+      // always check the manifest, so the URI is marked as seen and not deleted at the end
+      if (syncing && manifest.check(doc,entry)) {
+        continue;
+      }
+      if (resuming && journal.isCommitted(doc.getUri())) {
+        if (syncing) {
+          manifest.commit(doc.getUri(),entry);
+        }
+        continue;
+      }
+      pending->owned.push_back(doc); // shallow copy - shares the content
+      pending->positions.push_back(position + idx - startIdx);
+      if (syncing) {
+        pending->entries.push_back(entry);
+      }
+    }
+    const long skipped = (endIdx - startIdx + 1) - pending->owned.size();
+    if (0 != skipped) {
+      LOG(DEBUG) << "Batch writer skipping " << skipped << " documents unchanged or committed in a previous run";
+      skippedCount += skipped;
+      completedCount += skipped;
+      metrics.recordCompleted(now(),skipped);
+      if (pending->owned.empty()) {
+        checkComplete();
+        return pplx::task_from_result();
+      }
+    }
+    pending->gapped = (0 != skipped);
+    return sendBatchAsync(pending,0,pending->owned.size() - 1,position);
+  }
 
-    Impl& refImpl(*this);
+  /*
+   * Returns the position in the whole upload of docs[idx], in a batch whose docs[startIdx] is at position. If the
+   * batch is gapped its positions are used instead, as documents left out of the batch leave gaps.
+   */
+  static long positionOf(const long idx,const long startIdx,const long position,const PendingBatch& batch) {
+    return batch.gapped ? batch.positions.at(idx) : (position + idx - startIdx);
+  }
 
-    long maxIterations = (long)ceil(set.size() / parallelTasks) + 1; // horrible hack for 0 being returned
-    LOG(DEBUG) << "Max iterations: " << maxIterations;
+  /*
+   * Sends docs[startIdx..endIdx], retrying with backoff whilst failures are retryable. A batch the server rejects is
+   * split in half and each half sent, to isolate the bad documents. Documents that finally fail are dead lettered.
+   * If the batch is syncing, saved documents are committed to the sync manifest. See positionOf for position.
+   */
+  pplx::task<void> sendBatchAsync(std::shared_ptr<PendingBatch> batch,const long startIdx,const long endIdx,
+      const long position) {
+    std::shared_ptr<SendAttempts> attempts = std::make_shared<SendAttempts>();
+    return retryAsync(batch,startIdx,endIdx,attempts).then(
+        [this,batch,startIdx,endIdx,position,attempts] (BatchOutcome outcome) {
+      return recordOutcome(batch,startIdx,endIdx,position,*attempts,outcome);
+    });
+  }
 
-    LOG(DEBUG) << "Creating tasks to write " << set.size() << " Documents";
+  /*
+   * Sends docs[startIdx..endIdx], then re-sends it after a backoff for as long as the outcome is retryable and
+   * retries remain
+   */
+  pplx::task<BatchOutcome> retryAsync(std::shared_ptr<PendingBatch> batch,const long startIdx,const long endIdx,
+      std::shared_ptr<SendAttempts> attempts) {
+    return trySendAsync(batch,startIdx,endIdx,attempts).then(
+        [this,batch,startIdx,endIdx,attempts] (BatchOutcome outcome) -> pplx::task<BatchOutcome> {
+      ++attempts->count;
+      if (BatchOutcome::RETRYABLE != outcome || attempts->count > runRetry.maxRetries || cancelled) {
+        return pplx::task_from_result(outcome);
+      }
+      const long delay = backoff(attempts->count);
+      LOG(DEBUG) << "Batch writer retrying documents from index " << startIdx << " to " << endIdx << " in " << delay <<
+          "ms after: " << attempts->error;
+      return timer.after(delay).then([this,batch,startIdx,endIdx,attempts,outcome] () -> pplx::task<BatchOutcome> {
+        if (cancelled) {
+          return pplx::task_from_result(outcome);
+        }
+        retryCount++;
+        return retryAsync(batch,startIdx,endIdx,attempts);
+      });
+    });
+  }
 
-    //pplx::task<void>* fetchTask;
-    for (long i = 0;i < parallelTasks;i++) {
-      LOG(DEBUG) << "parallelTasks index: " << i;
-      pplx::task<void>* fetchTask = new pplx::task<void>([&refImpl,i,&maxIterations] () {
-        long myi = i;
+  /*
+   * Records the final outcome of sending docs[startIdx..endIdx], splitting a rejected batch and sending each half
+   */
+  pplx::task<void> recordOutcome(std::shared_ptr<PendingBatch> batch,const long startIdx,const long endIdx,
+      const long position,const SendAttempts& attempts,const BatchOutcome outcome) {
+    const DocumentSet& docs = *batch->docs;
+    const long count = endIdx - startIdx + 1;
+    DocumentUriSet myUris;
+    for (long idx = startIdx; idx <= endIdx;idx++) {
+      myUris.push_back(docs.at(idx).getUri());
+    }
 
-        LOG(DEBUG) << "Began document batch writer task... " << myi;
-        for (long j = 0;j < maxIterations;j++) {
-          // calculate segment start and finish
-          long startIdx = ((j * refImpl.parallelTasks) + myi) * refImpl.batchSize;
-          long endIdx = startIdx + refImpl.batchSize - 1;
+    if (BatchOutcome::SAVED == outcome) {
+      journal.record(true,positionOf(startIdx,startIdx,position,*batch),positionOf(endIdx,startIdx,position,*batch),
+          myUris);
+      if (batch->syncing) {
+        for (long idx = startIdx; idx <= endIdx;idx++) {
+          manifest.commit(docs.at(idx).getUri(),batch->entries.at(idx));
+        }
+      }
+      countBatch(count,true);
+      std::exception blank;
+      notify(myUris,true,blank);
+      return pplx::task_from_result();
+    }
 
-          if (startIdx >= refImpl.set.size()) {
-            LOG(DEBUG) << "Start index is out of range: " << startIdx;
-            j = maxIterations;
-          } else {
-            LOG(DEBUG) << "Start index is in range: " << startIdx;
-            if (endIdx >= refImpl.set.size()) {
-              LOG(DEBUG) << "End index is out of range: " << endIdx;
-              // must be on last part of set
-              endIdx = refImpl.set.size() - 1;
-              LOG(DEBUG) << "End index now: " << endIdx;
-            }
-            LOG(DEBUG) << "Batch writer thread " << myi << " writing documents from index " << startIdx << " to " << endIdx;
-
-            try {
-              LOG(DEBUG) << "In try";
-
-
-              // sanity check values for this set
-
-              Response* resp = refImpl.mConn->saveDocuments(refImpl.set,startIdx,endIdx);
-              LOG(DEBUG) << "Got response";
-
-              // update complete
-              DocumentUriSet myUris;
-              for (long idx = startIdx; idx <= endIdx;idx++) {
-                std::string uri = refImpl.set.at(idx).getUri();
-                refImpl.completeUris.push_back(uri);
-                myUris.push_back(uri);
-              }
-              refImpl.checkComplete();
-
-              // check ok and notify
-              if (ResponseHelper::isInError(*resp)) {
-                InvalidFormatException exc(ResponseHelper::getErrorDetailAsString(*resp)); // TODO better exception wrapper
-                for (auto& tell: refImpl.toNotify) {
-                  tell->batchOperationComplete(myUris,false,exc);
-                }
-              } else {
-                for (auto& tell: refImpl.toNotify) {
-                  std::exception blank;
-                  tell->batchOperationComplete(myUris,true,blank);
-                }
-              }
-
-              LOG(DEBUG) << "Deleting response";
-              delete(resp);
-              LOG(DEBUG) << "Response deleted";
-            } catch (std::exception& ref) {
-              LOG(DEBUG) << "Exception in batch document upload task: " << ref.what();
-
-              std::vector<std::string> myUris;
-              for (long idx = startIdx; idx <= endIdx;idx++) {
-                std::string uri = refImpl.set.at(idx).getUri();
-                myUris.push_back(uri);
-              }
-              for (auto& tell: refImpl.toNotify) {
-                tell->batchOperationComplete(myUris,false,ref);
-              }
-            }
-
-          } // end if out of bounds
-
-        } // end iteration for
-
-        LOG(DEBUG) << "End document upload batch task: " << myi;
+    // Bad credentials or permissions apply to every document, so splitting would not find a culprit
+    if (BatchOutcome::REJECTED == outcome && runRetry.bisectFailures && count > 1 && !cancelled &&
+        (int)ResponseCode::UNAUTHORIZED != attempts.status && (int)ResponseCode::FORBIDDEN != attempts.status) {
+      const long half = count / 2;
+      LOG(DEBUG) << "Batch writer splitting rejected batch from index " << startIdx << " to " << endIdx;
+      return sendBatchAsync(batch,startIdx,startIdx + half - 1,position).then(
+          [this,batch,startIdx,endIdx,position,half] () {
+        return sendBatchAsync(batch,startIdx + half,endIdx,position + half);
+      });
+    }
+
+    journal.record(false,positionOf(startIdx,startIdx,position,*batch),positionOf(endIdx,startIdx,position,*batch),
+        myUris);
+    for (long idx = startIdx; idx <= endIdx;idx++) {
+      deadLetters.record(docs.at(idx),positionOf(idx,startIdx,position,*batch),attempts.status,attempts.error,
+          attempts.count);
+    }
+    countBatch(count,false);
+    InvalidFormatException exc(attempts.error); // TODO better exception wrapper
+    notify(myUris,false,exc);
+    return pplx::task_from_result();
+  }
+
+  /*
+   * Makes a single attempt to save a batch, recording the HTTP response code (or 0 if no response was received) and
+   * any error in attempts. No thread waits for the response.
+   */
+  pplx::task<BatchOutcome> trySendAsync(std::shared_ptr<PendingBatch> batch,const long startIdx,const long endIdx,
+      std::shared_ptr<SendAttempts> attempts) {
+    LOG(DEBUG) << "Batch writer writing documents from index " << startIdx << " to " << endIdx;
+
+    long long bytes = 0;
+    for (long idx = startIdx; idx <= endIdx;idx++) {
+      bytes += documentBytes(batch->docs->at(idx));
+    }
+
+    const long batchStart = now();
+    inFlight++;
+    ResponseTask request;
+    try {
+      // unlike the synchronous saveDocuments, which returns nullptr, the task rethrows a failed request
+      request = mConn->saveDocumentsAsync(*batch->docs,startIdx,endIdx);
+    } catch (...) {
+      request = pplx::task_from_exception<std::shared_ptr<Response>>(std::current_exception()); // classified below
+    }
+    const long count = endIdx - startIdx + 1;
+    // batch is captured so its documents outlive the request
+    return request.then([this,batch,attempts,count,bytes,batchStart] (ResponseTask response) {
+      inFlight--;
+      const BatchOutcome outcome = classify(response,attempts->status,attempts->error);
+      const long batchEnd = now();
+      metrics.recordRequest(batchEnd,bytes,batchEnd - batchStart);
+      if (adaptive) {
+        tuner.record(count,bytes,batchEnd - batchStart,BatchOutcome::RETRYABLE == outcome);
+        limiter.setLimit(tuner.getParallelTasks());
+      }
+      return outcome;
+    });
+  }
+
+  /*
+   * Classifies a completed batch request. status is the HTTP response code, or 0 if no response was received.
+   */
+  static BatchOutcome classify(ResponseTask& response,int& status,std::string& error) {
+    status = 0;
+    try {
+      std::shared_ptr<Response> resp(response.get()); // already complete
+      const ResponseCode code = resp ? resp->getResponseCode() : ResponseCode::UNKNOWN_CODE;
+      status = (int)code;
+      if (!resp) {
+        // an IConnection that only implements the synchronous calls reports a failed request this way
+        error = "No response received";
+        return BatchOutcome::RETRYABLE;
+      }
+      if (isRetryable(status)) {
+        std::ostringstream msg;
+        msg << "Retryable response code: " << code;
+        error = msg.str();
+        return BatchOutcome::RETRYABLE;
+      }
+      if (ResponseHelper::isInError(*resp)) {
+        // a problem with the content, not the server
+        std::ostringstream msg;
+        msg << "Rejected with response code: " << code;
+        error = msg.str();
+        try {
+          error = ResponseHelper::getErrorDetailAsString(*resp);
+        } catch (std::exception& ref) {
+          LOG(DEBUG) << "Could not read error detail: " << ref.what();
+        }
+        return BatchOutcome::REJECTED;
+      }
+      return BatchOutcome::SAVED;
+    } catch (web::http::http_exception& ref) {
+      // no response - the connection failed or timed out (cpprest reports both this way), so worth trying again
+      LOG(DEBUG) << "HTTP exception in batch document upload task: " << ref.what();
+      error = ref.what();
+      return BatchOutcome::RETRYABLE;
+    } catch (std::exception& ref) {
+      // anything else (E.g. content that cannot be read) would fail the same way again, so bisect to find the document
+      LOG(DEBUG) << "Exception in batch document upload task: " << ref.what();
+      error = ref.what();
+      return BatchOutcome::REJECTED;
+    }
+  }
+
+  static bool isRetryable(const int status) {
+    return (int)ResponseCode::REQUEST_TIMEOUT == status || 429 == status /* too many requests */ ||
+        (int)ResponseCode::BAD_GATEWAY == status || (int)ResponseCode::SERVICE_UNAVAILABLE == status ||
+        (int)ResponseCode::GATEWAY_TIMEOUT == status;
+  }
+
+  /*
+   * Exponential backoff with jitter: half the doubled delay, plus a random amount up to the other half
+   */
+  long backoff(const int attempt) {
+    long delay = std::max(runRetry.initialBackoff,1L);
+    for (int i = 1;i < attempt && delay < runRetry.maxBackoff;i++) {
+      delay *= 2;
+    }
+    delay = std::min(delay,std::max(runRetry.maxBackoff,1L));
+    std::uniform_int_distribution<long> jitter(0,delay / 2);
+    std::lock_guard<std::mutex> lck(rngMutex);
+    return delay - (delay / 2) + jitter(rng);
+  }
+
+  void countBatch(const long count,const bool ok) {
+    // update complete (includes failed URIs)
+    completedCount += count;
+    metrics.recordCompleted(now(),count);
+    if (!ok) {
+      failedCount += count;
+    }
+    checkComplete();
+  }
+
+  static long long documentBytes(const Document& doc) {
+    const IDocumentContent* content = doc.getContent();
+    if (nullptr == content) {
+      return 0;
+    }
+    const long long length = content->getStreamLength();
+    return (length >= 0) ? length : (long long)content->getContent().size();
+  }
+
+  /*
+   * Runs one worker. Every worker claims the next unsent batch as soon as it holds a permit and its previous batch
+   * has finished, so work stays balanced even when document sizes are skewed. Nothing blocks a pool thread whilst
+   * waiting for a permit, a response or a backoff, so in adaptive mode a worker per possible task costs nothing whilst
+   * the limiter holds it back. done is set (or given the first exception) once the worker has finished.
+   */
+  void work(const long workerId,pplx::task_completion_event<void> done) {
+    limiter.acquireAsync().then([this] () {
+      return sendNextAsync();
+    }).then([this,workerId,done] (pplx::task<bool> sent) {
+      limiter.release();
+      bool more = false;
+      std::exception_ptr failure;
+      try {
+        more = sent.get();
+      } catch (std::exception& ref) {
+        LOG(DEBUG) << "Exception in document batch writer task " << workerId << ": " << ref.what();
+        failure = std::current_exception();
+      }
+      if (more && !cancelled) {
+        work(workerId,done);
+      } else {
+        endWork(workerId,done,failure);
+      }
+    });
+  }
+
+  void endWork(const long workerId,pplx::task_completion_event<void> done,std::exception_ptr failure) {
+    if (1 == runningWorkers.fetch_sub(1)) {
+      // last one out, before we report being complete
+      finishSyncAsync().then([this,workerId,done,failure] (pplx::task<void> finished) {
+        try {
+          finished.get();
+        } catch (std::exception& ref) {
+          LOG(DEBUG) << "Exception finishing sync: " << ref.what();
+        }
+        endWorker(workerId,done,failure);
+      });
+    } else {
+      endWorker(workerId,done,failure);
+    }
+  }
+
+  void endWorker(const long workerId,pplx::task_completion_event<void> done,std::exception_ptr failure) {
+    if (1 == activeWorkers.fetch_sub(1)) {
+      checkComplete(); // last one out
+    }
+    LOG(DEBUG) << "End document upload batch task: " << workerId;
+    // last, as waiters may then destroy this instance
+    if (failure) {
+      done.set_exception(failure);
+    } else {
+      done.set();
+    }
+  }
+
+  /*
+   * Claims and sends the next batch, from the set or the source. Completes with false if there was none left.
+   */
+  pplx::task<bool> sendNextAsync() {
+    const long size = adaptive ? tuner.getBatchSize() : runBatchSize;
+    if (nullptr == source) {
+      const long total = set.size();
+      const long startIdx = nextIdx.fetch_add(size);
+      if (cancelled || startIdx >= total) {
+        return pplx::task_from_result(false);
+      }
+      const long endIdx = std::min(startIdx + size,total) - 1;
+      return writeBatchAsync(std::make_shared<PendingBatch>(set),startIdx,endIdx,startIdx).then([] () {
+        return true;
       });
-      LOG(DEBUG) << "adding task";
-      refImpl.tasks.insert(std::make_pair(i,fetchTask)); // end task initialisation
+    }
+    // Only the documents in flight (and those buffered by the source) are ever held in memory
+    return pullAsync(size).then([this] (std::shared_ptr<PendingBatch> pulled) -> pplx::task<bool> {
+      if (pulled->owned.empty()) {
+        return pplx::task_from_result(false);
+      }
+      return writeBatchAsync(pulled,0,pulled->owned.size() - 1,pulled->start).then([pulled] (pplx::task<void> sent) {
+        for (auto& doc : pulled->owned) {
+          delete doc.getContent(); // we are its only holder now, and Document itself never deletes it
+        }
+        sent.get();
+        return true;
+      });
+    });
+  }
+
+  /*
+   * Pulls up to size documents from the source once any earlier pull has finished, so calls to next() are never
+   * concurrent and at most one pool thread waits on the source
+   */
+  pplx::task<std::shared_ptr<PendingBatch>> pullAsync(const long size) {
+    std::lock_guard<std::mutex> lck(sourceMutex);
+    pplx::task<std::shared_ptr<PendingBatch>> pull = pullTail.then([this,size] () {
+      std::shared_ptr<PendingBatch> pulled = std::make_shared<PendingBatch>();
+      pulled->owned.reserve(size);
+      while (!cancelled && !sourceExhausted && (long)pulled->owned.size() < size) {
+        Document doc;
+        if (!source->next(doc)) {
+          sourceExhausted = true;
+        } else {
+          pulled->owned.push_back(std::move(doc));
+        }
+      }
+      pulled->start = pulledCount.fetch_add(pulled->owned.size());
+      return pulled;
+    });
+    pullTail = pull.then([] (pplx::task<std::shared_ptr<PendingBatch>> previous) {
+      try {
+        previous.wait();
+      } catch (std::exception&) {
+        ; // reported by the worker that asked for the pull
+      }
+    });
+    return pull;
+  }
+
+  /*
+   * Deletes the documents in the manifest that were not in this upload, then saves the manifest. Deletion is skipped
+   * if the upload was stopped, or the source could not enumerate everything, as then not every document has been seen.
+   */
+  pplx::task<void> finishSyncAsync() {
+    if (!syncing) {
+      return pplx::task_from_result();
+    }
+    const long sourceFailures = (nullptr == source) ? 0 : source->getFailureCount();
+    if (deleteMissing && 0 != sourceFailures) {
+      LOG(DEBUG) << "Batch writer not deleting missing documents, as the source failed to enumerate " <<
+          sourceFailures << " items";
+    }
+    pplx::task<void> deleted = pplx::task_from_result();
+    if (deleteMissing && !cancelled && 0 == sourceFailures) {
+      std::shared_ptr<const std::vector<std::string>> gone =
+          std::make_shared<const std::vector<std::string>>(manifest.getUnseen());
+      LOG(DEBUG) << "Batch writer deleting " << gone->size() << " documents no longer in the upload";
+      deleted = deleteAsync(gone,0,std::max(1,adaptive ? tuner.getParallelTasks() : parallelTasks));
+    }
+    return deleted.then([this] () {
+      if (!manifest.save()) {
+        LOG(DEBUG) << "Batch writer could not save the sync manifest";
+      }
+    });
+  }
+
+  /*
+   * Deletes gone[first..first + window - 1] at once, then the next window once they have all completed
+   */
+  pplx::task<void> deleteAsync(std::shared_ptr<const std::vector<std::string>> gone,const size_t first,
+      const size_t window) {
+    if (first >= gone->size() || cancelled) {
+      return pplx::task_from_result();
+    }
+    std::vector<pplx::task<void>> deletes;
+    for (size_t idx = first;idx < std::min(first + window,gone->size());++idx) {
+      const std::string uri = (*gone)[idx];
+      ResponseTask request;
+      try {
+        request = mConn->deleteDocumentAsync(uri);
+      } catch (...) {
+        request = pplx::task_from_exception<std::shared_ptr<Response>>(std::current_exception());
+      }
+      deletes.push_back(request.then([this,uri] (ResponseTask task) {
+        try {
+          std::shared_ptr<Response> resp(task.get());
+          const ResponseCode code = resp ? resp->getResponseCode() : ResponseCode::UNKNOWN_CODE;
+          if (ResponseCode::NO_CONTENT == code || ResponseCode::OK == code || ResponseCode::NOT_FOUND == code) {
+            manifest.remove(uri);
+            deletedCount++;
+          } else {
+            LOG(DEBUG) << "Batch writer could not delete " << uri << ", response code: " << code;
+          }
+        } catch (std::exception& ref) {
+          LOG(DEBUG) << "Exception deleting " << uri << ": " << ref.what();
+        }
+      }));
+    }
+    return pplx::when_all(deletes.begin(),deletes.end()).then([this,gone,first,window] () {
+      return deleteAsync(gone,first + window,window);
+    });
+  }
+
+  void begin() {
+    if (started.exchange(true)) {
+      return; // stop starting the work twice
+    }
+    // Parameters are fixed for the duration of the run
+    long workers = (parallelTasks < 1) ? 1 : parallelTasks;
+    runBatchSize = (batchSize < 1) ? 1 : batchSize;
+    runRetry = retry;
+    if (!runRetry.deadLetterFile.empty() && !deadLetters.open(runRetry.deadLetterFile)) {
+      LOG(DEBUG) << "Batch writer could not open dead letter file: " << runRetry.deadLetterFile;
+    }
+    if (adaptive) {
+      // start enough workers for the maximum, and let the limiter decide how many may send at once. Workers held
+      // back by the limiter hold no thread.
+      tuner.reset(adaptiveParams,parallelTasks,runBatchSize);
+      workers = tuner.getMaxParallelTasks();
+      limiter.setLimit(tuner.getParallelTasks());
+    } else {
+      limiter.setLimit(0); // unlimited - bounded by the number of workers
+    }
+    nextIdx = 0;
+    completedCount = 0;
+    failedCount = 0;
+    skippedCount = 0;
+    deletedCount = 0;
+    retryCount = 0;
+    inFlight = 0;
+    activeWorkers = workers;
+    runningWorkers = workers;
+    complete = false;
+    finished = false;
+    startTime = now();
+    metrics.reset(startTime);
+    calculateProgress(); // initialises correct values for 'complete' in 'overall' progress struct
+
+    sourceExhausted = false;
+    pulledCount = 0;
 
-      //if (0 == i) {
-      //  fetchTask->wait(); // WAIT for the first one...
-      //}
+    if (nullptr == source) {
+      LOG(DEBUG) << "Creating " << workers << " tasks to write " << set.size() << " Documents";
+    } else {
+      LOG(DEBUG) << "Creating " << workers << " tasks to write Documents from a source";
+    }
 
-    } // end loop
+    pullTail = pplx::task_from_result();
+    for (long i = 0;i < workers;i++) {
+      LOG(DEBUG) << "Began document batch writer task... " << i;
+      pplx::task_completion_event<void> done;
+      tasks.push_back(pplx::create_task(done));
+      work(i,done);
+    }
     LOG(DEBUG) << "Tasks initialised";
   }
 
   void stop() {
+    // No further batches are claimed. Batches already sent run to completion.
     cancelled = true;
+    timer.cancelAll(); // retry any batch waiting on a backoff now, so it completes as cancelled
+    if (nullptr != source) {
+      source->cancel(); // wake any worker waiting on the source
+    }
+  }
+
+  void waitAll() {
+    for (auto& task : tasks) {
+      task.wait();
+    }
   }
 
   IConnection* mConn;
-  DocumentSet& set;
+  DocumentSet set;
+  IDocumentSource* source; // if set, used instead of set. Not owned.
+  std::atomic<bool> sourceExhausted;
+  std::atomic<long> pulledCount;
+  std::mutex sourceMutex; // guards pullTail
   int parallelTasks;
   int batchSize;
   TransactionMode mode;
+  bool adaptive;
+  AdaptiveBatchParameters adaptiveParams;
+  BatchTuner tuner;
+  mlclient::internals::ConcurrencyLimiter limiter;
   std::vector<IBatchNotifiable*> toNotify;
 
-  bool complete;
-  bool cancelled;
-  bool finished;
+  std::atomic<bool> complete;
+  std::atomic<bool> cancelled;
+  std::atomic<bool> finished;
+  std::atomic<bool> started;
+
+  std::atomic<long> nextIdx; // the shared batch cursor
+  std::atomic<long> completedCount; // includes failed and skipped URIs
+  std::atomic<long> failedCount;
+  std::atomic<long> skippedCount; // unchanged per the sync manifest, or committed in a previous run per the journal
+  std::atomic<long> deletedCount;
+  std::atomic<long> activeWorkers;
+  std::atomic<long> runningWorkers; // still uploading. The last to finish deletes missing documents, if syncing
+  long runBatchSize;
+
+  BatchJournal journal;
+  bool resuming;
+  mlclient::internals::SyncManifest manifest;
+  bool syncing;
+  bool deleteMissing;
+
+  RetryParameters retry;
+  RetryParameters runRetry; // fixed for the duration of the run
+  DeadLetterFile deadLetters;
+  std::atomic<long> retryCount;
+  std::mutex rngMutex;
+  std::mt19937 rng; // backoff jitter
+  BackoffTimer timer;
+
+  BatchMetrics metrics;
+  std::atomic<int> inFlight;
 
   Progress overall;
   Progress latest;
 
-  std::vector<std::string> completeUris; // includes failed URIs
-
-  std::map<long,pplx::task<void>*> tasks;
+  std::vector<pplx::task<void>> tasks;
+  pplx::task<void> pullTail; // the last pull from the source. Each pull follows the last, to serialise next().
 
   long startTime;
 
+  std::mutex progressMutex;
+  std::mutex notifyMutex;
 };
 
 
@@ -249,12 +1275,41 @@ DocumentBatchWriter::~DocumentBatchWriter() {
 
 void DocumentBatchWriter::assignDocuments(DocumentSet&& set) {
   mImpl->set = std::move(set);
+  mImpl->source = nullptr;
+}
+
+void DocumentBatchWriter::assignSource(IDocumentSource* source) {
+  mImpl->set.clear();
+  mImpl->source = source;
 }
 
-void DocumentBatchWriter::setBatchParameters(const int parallelTasks,const int batchSize,const TransactionMode& mode) {
+void DocumentBatchWriter::setBatchParameters(const int parallelTasks,const int batchSize,const TransactionMode& mode,
+    const RetryParameters& retry) {
   mImpl->parallelTasks = parallelTasks;
   mImpl->batchSize = batchSize;
   mImpl->mode = mode;
+  mImpl->retry = retry;
+  mImpl->adaptive = false;
+}
+void DocumentBatchWriter::setAdaptiveBatchParameters(const AdaptiveBatchParameters& params,const TransactionMode& mode,
+    const RetryParameters& retry) {
+  mImpl->adaptiveParams = params;
+  mImpl->mode = mode;
+  mImpl->retry = retry;
+  mImpl->adaptive = true;
+}
+bool DocumentBatchWriter::setJournal(const std::string& journalFile,const bool resume) {
+  mImpl->resuming = resume;
+  return mImpl->journal.open(journalFile,resume);
+}
+bool DocumentBatchWriter::setSyncManifest(const std::string& manifestFile,const bool deleteMissing) {
+  mImpl->deleteMissing = deleteMissing;
+  mImpl->syncing = mImpl->manifest.load(manifestFile);
+  return mImpl->syncing;
+}
+
+const bool DocumentBatchWriter::isAdaptive() const {
+  return mImpl->adaptive;
 }
 const int DocumentBatchWriter::getParallelTasks() const {
   return mImpl->parallelTasks;
@@ -265,27 +1320,33 @@ const int DocumentBatchWriter::getBatchSize() const {
 const TransactionMode DocumentBatchWriter::getMode() const {
   return mImpl->mode;
 }
+const RetryParameters& DocumentBatchWriter::getRetryParameters() const {
+  return mImpl->retry;
+}
 
 void DocumentBatchWriter::addBatchListener(IBatchNotifiable* notifiable) {
+  std::lock_guard<std::mutex> lck(mImpl->notifyMutex);
   mImpl->toNotify.push_back(notifiable);
 }
 void DocumentBatchWriter::removeBatchListener(IBatchNotifiable* notifiable) {
-  //mImpl->toNotify.erase(notifiable);
+  std::lock_guard<std::mutex> lck(mImpl->notifyMutex);
+  mImpl->toNotify.erase(std::remove(mImpl->toNotify.begin(),mImpl->toNotify.end(),notifiable),mImpl->toNotify.end());
 }
 
 void DocumentBatchWriter::send() {
   mImpl->begin();
 }
+pplx::task<void> DocumentBatchWriter::sendAsync() {
+  mImpl->begin();
+  return pplx::when_all(mImpl->tasks.begin(),mImpl->tasks.end());
+}
+
 void DocumentBatchWriter::stop() {
   mImpl->stop();
 }
 
 void DocumentBatchWriter::wait() const {
-  for (auto taskIter = mImpl->tasks.begin(); taskIter != mImpl->tasks.end();++taskIter) {
-    if (!taskIter->second->is_done()) {
-      taskIter->second->wait();
-    }
-  }
+  mImpl->waitAll();
 }
 
 const bool DocumentBatchWriter::isComplete() const {
@@ -302,7 +1363,7 @@ const bool DocumentBatchWriter::isFinished() const {
 }
 
 const Progress DocumentBatchWriter::getProgress() const {
-  return mImpl->overall;
+  return mImpl->getProgress();
 }
 
 
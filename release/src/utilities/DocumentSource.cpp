@@ -0,0 +1,121 @@
+/**
+ * \file DocumentSource.cpp
+ *
+ * \date 16 Oct 2026
+ */
+
+#include <mlclient/utilities/DocumentSource.hpp>
+#include <mlclient/Document.hpp>
+#include <mlclient/logging.hpp>
+#include <mlclient/mlclient.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace mlclient {
+
+namespace utilities {
+
+IDocumentSource::~IDocumentSource() {
+  ;
+}
+
+void IDocumentSource::cancel() {
+  ;
+}
+
+const long IDocumentSource::getFailureCount() const {
+  return 0;
+}
+
+
+
+class BoundedDocumentQueue::Impl {
+public:
+  Impl(const long cap) : mutex(), notFull(), notEmpty(), queue(), capacity(cap < 1 ? 1 : cap), closed(false) {
+    ;
+  }
+
+  mutable std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+  std::deque<Document> queue;
+  long capacity;
+  bool closed;
+};
+
+BoundedDocumentQueue::BoundedDocumentQueue(const long capacity) : mImpl(mlclient::make_unique<Impl>(capacity)) {
+  ;
+}
+
+BoundedDocumentQueue::~BoundedDocumentQueue() {
+  ;
+}
+
+bool BoundedDocumentQueue::push(Document&& doc) {
+  std::unique_lock<std::mutex> lck(mImpl->mutex);
+  mImpl->notFull.wait(lck,[this] {return mImpl->closed || (long)mImpl->queue.size() < mImpl->capacity;});
+  if (mImpl->closed) {
+    LOG(DEBUG) << "BoundedDocumentQueue::push queue closed. Discarding document: " << doc.getUri();
+    delete doc.getContent();
+    return false;
+  }
+  mImpl->queue.push_back(std::move(doc));
+  lck.unlock();
+  mImpl->notEmpty.notify_one();
+  return true;
+}
+
+void BoundedDocumentQueue::close() {
+  {
+    std::lock_guard<std::mutex> lck(mImpl->mutex);
+    mImpl->closed = true;
+  }
+  mImpl->notEmpty.notify_all();
+  mImpl->notFull.notify_all();
+}
+
+const bool BoundedDocumentQueue::isClosed() const {
+  std::lock_guard<std::mutex> lck(mImpl->mutex);
+  return mImpl->closed;
+}
+
+const long BoundedDocumentQueue::size() const {
+  std::lock_guard<std::mutex> lck(mImpl->mutex);
+  return mImpl->queue.size();
+}
+
+const long BoundedDocumentQueue::getCapacity() const {
+  return mImpl->capacity;
+}
+
+bool BoundedDocumentQueue::next(Document& out) {
+  std::unique_lock<std::mutex> lck(mImpl->mutex);
+  mImpl->notEmpty.wait(lck,[this] {return mImpl->closed || !mImpl->queue.empty();});
+  if (mImpl->queue.empty()) {
+    return false; // closed and drained
+  }
+  out = std::move(mImpl->queue.front());
+  mImpl->queue.pop_front();
+  lck.unlock();
+  mImpl->notFull.notify_one();
+  return true;
+}
+
+void BoundedDocumentQueue::cancel() {
+  {
+    std::lock_guard<std::mutex> lck(mImpl->mutex);
+    mImpl->closed = true;
+    for (auto& doc : mImpl->queue) {
+      delete doc.getContent();
+    }
+    mImpl->queue.clear();
+  }
+  mImpl->notEmpty.notify_all();
+  mImpl->notFull.notify_all();
+}
+
+} // end namespace utilities
+
+} // end namespace mlclient
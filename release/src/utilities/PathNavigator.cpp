@@ -27,6 +27,43 @@
 namespace mlclient {
 namespace utilities {
 
+namespace {
+
+/*
+ * Applies each level of path from start onwards, reusing key for each level's name so that no strings are copied
+ */
+IDocumentNode* walk(const IDocumentNode* node,const std::string& path,size_t start,std::string& key) {
+  while (true) {
+    size_t location = path.find('/',start);
+    if (std::string::npos == location) {
+      if (start == path.size()) {
+        throw mlclient::InvalidFormatException("No element or property at lower level of path");
+      }
+      location = path.size();
+    } else if (start == location) { // should never happen, but could be double slash - TODO support double slash not absolute paths
+      start++;
+      location = path.find('/',start);
+      if (std::string::npos == location) {
+        location = path.size();
+      }
+    }
+    key.assign(path,start,location - start);
+
+    IDocumentNode* child = node->at(key);
+    if (location + 1 >= path.size()) {
+      // at end of path
+      return child;
+    }
+    if (nullptr == child) {
+      throw mlclient::InvalidFormatException("No element or property named " + key + " in path");
+    }
+    node = child;
+    start = location + 1;
+  }
+}
+
+} // end anonymous namespace
+
 IDocumentNode* PathNavigator::navigate(const IDocumentNavigator* nav,const std::string& path) {
   size_t location = path.find('/');
   size_t start = 0;
@@ -36,50 +73,27 @@ IDocumentNode* PathNavigator::navigate(const IDocumentNavigator* nav,const std::
   if (0 == location) {
       start = 1;
       location = path.find('/',start);
+      if (std::string::npos == location) {
+        location = path.size();
+      }
   }
-  std::string curLevel = path.substr(start,location);
-  std::string lower = "";
-  if (location != path.size()) {
-    lower = path.substr(location + 1);
-  }
+  std::string key(path,start,location - start);
 
-  IDocumentNode* child = nav->at(curLevel);
-  if (lower.size() == 0) {
+  IDocumentNode* child = nav->at(key);
+  if (location + 1 >= path.size()) {
       // at end of path
       return child;
-  } else {
-      return at(child,lower);
   }
+  if (nullptr == child) {
+    throw mlclient::InvalidFormatException("No element or property named " + key + " in path");
+  }
+  return walk(child,path,location + 1,key);
 }
 
 IDocumentNode* PathNavigator::at(const IDocumentNode* node,const std::string& subpath) {
-  size_t location = subpath.find('/');
-  size_t start = 0;
-  if (std::string::npos == location) {
-    if (subpath.size() == 0) {
-      throw mlclient::InvalidFormatException("No element or property at lower level of path");
-    }
-    location = subpath.size();
-  } else {
-    if (0 == location) { // should never happen, but could be double slash - TODO support double slash not absolute paths
-      start = 1;
-      location = subpath.find('/',start);
-    }
-  }
-  std::string curLevel = subpath.substr(start,location);
-  std::string lower = "";
-  if (location != subpath.size()) {
-    lower = subpath.substr(location + 1);
-  }
-
-  IDocumentNode* child = node->at(curLevel);
-  if (lower.size() == 0) {
-      // at end of path
-      return child;
-  } else {
-      return at(child,lower);
-  }
+  std::string key;
+  return walk(node,subpath,0,key);
 }
 
 } // end namespace utilities
-} // end namespace mlclient
\ No newline at end of file
+} // end namespace mlclient
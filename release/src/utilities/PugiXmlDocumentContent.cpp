@@ -6,6 +6,7 @@
  */
 
 #include <mlclient/utilities/PugiXmlDocumentContent.hpp>
+#include <mlclient/internals/NodeArena.hpp>
 #include <mlclient/logging.hpp>
 #include <mlclient/InvalidFormatException.hpp>
 #include <mlclient/ext/pugixml/pugixml.hpp>
@@ -23,6 +24,23 @@ namespace utilities {
 const std::regex RE_INTEGER("^[0-9]+$");
 const std::regex RE_DOUBLE("^[0-9]+\\.[0-9]+$");
 
+namespace {
+
+/*
+ * Makes a node in the arena, or with new (for the caller to own) if there is no arena
+ */
+template<class T,class... Args> IDocumentNode* makeNode(internals::NodeArena* arena,Args&&... args) {
+  if (nullptr == arena) {
+    return new T(std::forward<Args>(args)...);
+  }
+  return arena->make<T>(*arena,std::forward<Args>(args)...);
+}
+
+IDocumentNode* findNode(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> doc,pugi::xml_node& parent,
+    const std::string& key);
+
+} // end anonymous namespace
+
 PugiXmlContainerNode::PugiXmlContainerNode() {
   ;
 }
@@ -70,22 +88,31 @@ IDocumentContent* PugiXmlContainerNode::getChildContent() const {
 
 class PugiXmlArrayNode::Impl {
 public:
-  Impl(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key) : doc(doc),parent(parent), key(key) {
+  Impl(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key) : doc(doc),parent(parent),
+    ownKey(nullptr == arena ? key : std::string()), key(nullptr == arena ? ownKey.c_str() : arena->copy(key)), children(arena) {
     ;
   };
   std::shared_ptr<pugi::xml_document> doc;
   pugi::xml_node parent;
-  std::string key;
+  std::string ownKey; // only if not made in an arena, else the key is copied in to the arena
+  const char* key;
+  internals::NodeArenaRef children;
 };
 
 
 
 
-PugiXmlArrayNode::PugiXmlArrayNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key) : mImpl(new Impl(doc,parent,key)) {
+PugiXmlArrayNode::PugiXmlArrayNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key) : mImpl(new Impl(nullptr,doc,parent,key)) {
+  ;
+}
+PugiXmlArrayNode::PugiXmlArrayNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& parent,const std::string& key) :
+    mImpl(arena.make<Impl>(&arena,doc,parent,key)) {
   ;
 }
 PugiXmlArrayNode::~PugiXmlArrayNode() {
-  delete mImpl;
+  if (!mImpl->children.isBorrowed()) { // else the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 bool PugiXmlArrayNode::isArray() const {
@@ -106,13 +133,13 @@ IDocumentNode* PugiXmlArrayNode::at(const std::string& key) const {
   throw mlclient::InvalidFormatException("XML Array does not support string key subscripts");
 }
 IDocumentNode* PugiXmlArrayNode::at(const int32_t idx) const {
-  const auto& children = mImpl->parent.children(mImpl->key.c_str());
+  const auto& children = mImpl->parent.children(mImpl->key);
   pugi::xml_named_node_iterator iter = children.begin();
   const auto& end = children.end();
   int32_t i = 0;
   for (;i <= idx && iter != end;++iter) {
     if (i == idx) {
-      return new PugiXmlDocumentNode(mImpl->doc,*iter);
+      return mImpl->children.make<PugiXmlDocumentNode>(mImpl->doc,*iter);
     }
     i++;
   }
@@ -128,7 +155,7 @@ StringList PugiXmlArrayNode::keys() const {
 }
 
 int32_t PugiXmlArrayNode::size() const {
-  const auto& children = mImpl->parent.children(mImpl->key.c_str());
+  const auto& children = mImpl->parent.children(mImpl->key);
   pugi::xml_named_node_iterator iter = children.begin();
   const auto& end = children.end();
   int32_t i = 0;
@@ -142,19 +169,26 @@ int32_t PugiXmlArrayNode::size() const {
 
 class PugiXmlObjectNode::Impl {
 public:
-  Impl(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& obj) : doc(doc),obj(obj) {
+  Impl(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& obj) : doc(doc),obj(obj),children(arena) {
     ;
   };
 
   std::shared_ptr<pugi::xml_document> doc;
   pugi::xml_node obj;
+  internals::NodeArenaRef children;
 };
 
-PugiXmlObjectNode::PugiXmlObjectNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& obj) : mImpl(new Impl(doc,obj)) {
+PugiXmlObjectNode::PugiXmlObjectNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& obj) : mImpl(new Impl(nullptr,doc,obj)) {
+  ;
+}
+PugiXmlObjectNode::PugiXmlObjectNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_node& obj) :
+    mImpl(arena.make<Impl>(&arena,doc,obj)) {
   ;
 }
 PugiXmlObjectNode::~PugiXmlObjectNode() {
-  delete mImpl;
+  if (!mImpl->children.isBorrowed()) { // else the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 bool PugiXmlObjectNode::isArray() const {
@@ -173,7 +207,7 @@ IDocumentNode* PugiXmlObjectNode::asObject() const {
 
 IDocumentNode* PugiXmlObjectNode::at(const std::string& key) const {
   LOG(DEBUG) << "at(" << key << ") called on '" << mImpl->obj.name() << "' of type: " << mImpl->obj.type();
-  return mlclient::utilities::createNode(mImpl->doc,mImpl->obj,key); // TODO ensure this returns attributes and not just elements
+  return findNode(&mImpl->children.get(),mImpl->doc,mImpl->obj,key); // TODO ensure this returns attributes and not just elements
 }
 IDocumentNode* PugiXmlObjectNode::at(const int32_t idx) const {
   throw mlclient::InvalidFormatException("XML Container Object does not support integer subscripts");
@@ -229,21 +263,28 @@ IDocumentContent* PugiXmlObjectNode::getChildContent() const {
 
 class PugiXmlAttributeNode::Impl {
   public:
-  Impl(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr) : doc(doc),attr(attr) {
+  Impl(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr) : doc(doc),attr(attr),children(arena) {
     ;
   };
 
   std::shared_ptr<pugi::xml_document> doc;
   pugi::xml_attribute attr;
+  internals::NodeArenaRef children; // never has any, but records whether this Impl was made in an arena
 };
 
 
-PugiXmlAttributeNode::PugiXmlAttributeNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr) : mImpl(new Impl(doc,attr)) {
+PugiXmlAttributeNode::PugiXmlAttributeNode(std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr) : mImpl(new Impl(nullptr,doc,attr)) {
+  ;
+}
+PugiXmlAttributeNode::PugiXmlAttributeNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> doc,const pugi::xml_attribute& attr) :
+    mImpl(arena.make<Impl>(&arena,doc,attr)) {
   ;
 }
 
 PugiXmlAttributeNode::~PugiXmlAttributeNode() {
-  delete mImpl;
+  if (!mImpl->children.isBorrowed()) { // else the arena destroys it
+    delete mImpl;
+  }
   mImpl = nullptr;
 }
 bool PugiXmlAttributeNode::isNull() const {
@@ -326,24 +367,29 @@ IDocumentContent* PugiXmlAttributeNode::getChildContent() const {
 
 class PugiXmlDocumentNode::Impl {
 public:
-  Impl(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root) : doc(own_doc),root(root) {
+  Impl(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root) : doc(own_doc),root(root),children(arena) {
     ;
   };
-  Impl(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& parent,const std::string& key) : doc(own_doc),root(parent.child(key.c_str())) {
+  Impl(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& parent,const std::string& key) : doc(own_doc),root(parent.child(key.c_str())),children(nullptr) {
     ;
   };
 
   pugi::xml_node root;
   std::shared_ptr<pugi::xml_document> doc;
+  internals::NodeArenaRef children;
 };
 
 
-PugiXmlDocumentNode::PugiXmlDocumentNode(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root) : mImpl(new Impl(own_doc,root)) {
+PugiXmlDocumentNode::PugiXmlDocumentNode(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root) : mImpl(new Impl(nullptr,own_doc,root)) {
   LOG(DEBUG) << "PugiXmlDocumentNode::ctor for node named '" << root.name() << "'";
   LOG(DEBUG) << "  node text: " << root.text().get();
   LOG(DEBUG) << "  node impl text: " << mImpl->root.text().get();
   ;
 }
+PugiXmlDocumentNode::PugiXmlDocumentNode(internals::NodeArena& arena,std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root) :
+    mImpl(arena.make<Impl>(&arena,own_doc,root)) {
+  ;
+}
 PugiXmlDocumentNode::PugiXmlDocumentNode(std::shared_ptr<pugi::xml_document> own_doc,const pugi::xml_node& root,const std::string& key) : mImpl(new Impl(own_doc,root,key)) {
   LOG(DEBUG) << "PugiXmlDocumentNode::ctor(node,key) for node named '" << root.name() << "'";
   LOG(DEBUG) << "  node text: " << root.text().get();
@@ -357,7 +403,7 @@ PugiXmlDocumentNode::PugiXmlDocumentNode(PugiXmlDocumentNode&& from) : mImpl(fro
 }
 
 PugiXmlDocumentNode::~PugiXmlDocumentNode() {
-  if (nullptr != mImpl) {
+  if (nullptr != mImpl && !mImpl->children.isBorrowed()) { // else moved from, or the arena destroys it
     delete mImpl;
   }
   mImpl = nullptr;
@@ -412,7 +458,7 @@ IDocumentNode* PugiXmlDocumentNode::asObject() const {
 }
 
 IDocumentNode* PugiXmlDocumentNode::at(const std::string& key) const {
-  return mlclient::utilities::createNode(mImpl->doc,mImpl->root,key);
+  return findNode(&mImpl->children.get(),mImpl->doc,mImpl->root,key);
 }
 
 bool PugiXmlDocumentNode::has(const std::string& key) const {
@@ -429,7 +475,7 @@ IDocumentNode* PugiXmlDocumentNode::at(const int32_t idx) const {
   const auto& end = mImpl->root.children().end();
   for (int32_t i = 0;i <= idx && iter != end;i++) {
     if (i == idx) {
-      return new PugiXmlDocumentNode(mImpl->doc,*iter);
+      return mImpl->children.make<PugiXmlDocumentNode>(mImpl->doc,*iter);
     }
   }
   return nullptr;
@@ -474,6 +520,13 @@ IDocumentContent* PugiXmlDocumentNode::getChildContent() const {
 
 
 IDocumentNode* createNode(std::shared_ptr<pugi::xml_document> doc,pugi::xml_node& parent,const std::string& key) {
+  return findNode(nullptr,doc,parent,key);
+}
+
+namespace {
+
+IDocumentNode* findNode(internals::NodeArena* arena,std::shared_ptr<pugi::xml_document> doc,pugi::xml_node& parent,
+    const std::string& key) {
   LOG(DEBUG) << "Trying to find child node or element named: " << key;
   const auto& range = parent.children(key.c_str());
   if (range.begin() == range.end() || (++(range.begin())) == range.end()) {
@@ -487,10 +540,10 @@ IDocumentNode* createNode(std::shared_ptr<pugi::xml_document> doc,pugi::xml_node
       }
       if (isObject) {
         LOG(DEBUG) << " This node is a Pugi XML object node (has one or more element children)";
-        return new PugiXmlObjectNode(doc,child);
+        return makeNode<PugiXmlObjectNode>(arena,doc,child);
       }
       LOG(DEBUG) << "Found an element with a single child of '" << key << "', creating PugiXmlDocumentNode...";
-      return new PugiXmlDocumentNode(doc,child);
+      return makeNode<PugiXmlDocumentNode>(arena,doc,child);
     } else {
       LOG(DEBUG) << "No child with name '" << key << "'";
     }
@@ -499,7 +552,7 @@ IDocumentNode* createNode(std::shared_ptr<pugi::xml_document> doc,pugi::xml_node
   const auto& attr = parent.attribute(key.c_str());
   if (nullptr != attr) {
     LOG(DEBUG) << "Found an XML attribute";
-    return new PugiXmlAttributeNode(doc,attr);
+    return makeNode<PugiXmlAttributeNode>(arena,doc,attr);
   }
   // is an object if one or more children are themselves nodes
   LOG(DEBUG) << "Found an element with multiple children of '" << key << "', creating PugiXmlArrayNode...";
@@ -507,21 +560,24 @@ IDocumentNode* createNode(std::shared_ptr<pugi::xml_document> doc,pugi::xml_node
   //  LOG(DEBUG) << "  Child type: " << iter->type() << " name: " << iter->name();
   //}
   // is array
-  return new PugiXmlArrayNode(doc,parent,key);
+  return makeNode<PugiXmlArrayNode>(arena,doc,parent,key);
 }
 
+} // end anonymous namespace
+
 
 
 
 
 class PugiXmlDocumentNavigator::Impl {
 public:
-  Impl(std::shared_ptr<pugi::xml_document> root,bool firstElementAsRoot) : root(root), firstElementAsRoot(firstElementAsRoot) {
+  Impl(std::shared_ptr<pugi::xml_document> root,bool firstElementAsRoot) : root(root), firstElementAsRoot(firstElementAsRoot), nodes() {
     ;
   };
 
   std::shared_ptr<pugi::xml_document> root;
   bool firstElementAsRoot;
+  internals::NodeArena nodes; // every node reached from this navigator
 };
 
 PugiXmlDocumentNavigator::PugiXmlDocumentNavigator(std::shared_ptr<pugi::xml_document> root,bool firstElementAsRoot) : mImpl(new Impl(root,firstElementAsRoot)) {
@@ -540,9 +596,9 @@ PugiXmlDocumentNavigator::~PugiXmlDocumentNavigator() {
 
 IDocumentNode* PugiXmlDocumentNavigator::firstChild() const {
   if (!mImpl->firstElementAsRoot) {
-    return new PugiXmlDocumentNode(mImpl->root,mImpl->root->root().first_child());
+    return mImpl->nodes.make<PugiXmlDocumentNode>(mImpl->nodes,mImpl->root,mImpl->root->root().first_child());
   }
-  return new PugiXmlDocumentNode(mImpl->root,mImpl->root->root().first_child().first_child());
+  return mImpl->nodes.make<PugiXmlDocumentNode>(mImpl->nodes,mImpl->root,mImpl->root->root().first_child().first_child());
 }
 
 bool PugiXmlDocumentNavigator::has(const std::string& key) const {
@@ -564,7 +620,7 @@ bool PugiXmlDocumentNavigator::has(const std::string& key) const {
 
 IDocumentNode* PugiXmlDocumentNavigator::at(const std::string& key) const {
   if (!mImpl->firstElementAsRoot) {
-    return new PugiXmlDocumentNode(mImpl->root,mImpl->root->root().child(key.c_str()));
+    return mImpl->nodes.make<PugiXmlDocumentNode>(mImpl->nodes,mImpl->root,mImpl->root->root().child(key.c_str()));
   }
   // else call child on the top level element
   const auto& range = mImpl->root->children();
@@ -582,14 +638,14 @@ IDocumentNode* PugiXmlDocumentNavigator::at(const std::string& key) const {
   }
   LOG(DEBUG) << "Child element count for " << key << " is " << childCount;
   if (1 == childCount) {
-    return new PugiXmlDocumentNode(mImpl->root,range.begin()->child(key.c_str()));
+    return mImpl->nodes.make<PugiXmlDocumentNode>(mImpl->nodes,mImpl->root,range.begin()->child(key.c_str()));
   } else if (childCount > 1) {
-    return new PugiXmlArrayNode(mImpl->root,mImpl->root->first_child(),key);
+    return mImpl->nodes.make<PugiXmlArrayNode>(mImpl->nodes,mImpl->root,mImpl->root->first_child(),key);
   }
   const pugi::xml_attribute& attr = mImpl->root->first_child().attribute(key.c_str());
   if (nullptr != attr) {
     LOG(DEBUG) << "Found attribute under root document element";
-    return new PugiXmlAttributeNode(mImpl->root,attr);
+    return mImpl->nodes.make<PugiXmlAttributeNode>(mImpl->nodes,mImpl->root,attr);
   }
   return nullptr; // empty XML document
 
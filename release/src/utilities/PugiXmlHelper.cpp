@@ -81,7 +81,8 @@ std::unique_ptr<pugi::xml_document> PugiXmlHelper::fromResponse(const Response&
   if (resp.getResponseType() == ResponseType::XML) {
     //pugi::xml_document* doc = new pugi::xml_document;
     std::unique_ptr<pugi::xml_document> doc = mlclient::make_unique<pugi::xml_document>();
-    pugi::xml_parse_result result = doc->load_string(resp.getContent().c_str());
+    // load_buffer avoids the strlen of load_string. Pugi must still take its own copy, as the Response may not outlive doc.
+    pugi::xml_parse_result result = doc->load_buffer(resp.getContentData(),resp.getContentLength());
 
     if (result) {
       return doc;
@@ -0,0 +1,130 @@
+/*
+ * CredentialsTest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+#include "CredentialsTest.hpp"
+#include "mlclient/internals/Credentials.hpp"
+
+#include "mlclient/logging.hpp"
+
+using namespace mlclient::internals;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CredentialsTest);
+
+namespace {
+
+/*
+ * Exposes the protected response generation, as AuthenticatingProxy uses it
+ */
+class TestCredentials : public Credentials {
+public:
+  TestCredentials(const std::string& user,const std::string& pass,const std::string& cnonce) :
+    Credentials(user,pass,cnonce,0) {
+    ;
+  }
+
+  std::string respond(const std::string& method,const std::string& uri) {
+    return authenticate(method,uri);
+  }
+};
+
+bool contains(const std::string& header,const std::string& part) {
+  return std::string::npos != header.find(part);
+}
+
+} // end anonymous namespace
+
+void CredentialsTest::setUp(void) {
+  LOG(DEBUG) << "ENTERING TEST SUITE CredentialsTest";
+}
+
+void CredentialsTest::tearDown(void) {
+  LOG(DEBUG) << "LEAVING TEST SUITE CredentialsTest";
+}
+
+void CredentialsTest::testQuotedValues() {
+  Credentials creds("user","pass");
+  creds.parseWWWAuthenticateHeader(
+      "Digest realm=\"public, private\", qop=\"auth\", nonce=\"abc123\", opaque=\"say \\\"hi\\\"\"");
+  CPPUNIT_ASSERT_MESSAGE("realm with a comma was split",std::string("public, private") == creds.getRealm());
+  CPPUNIT_ASSERT_MESSAGE("nonce is wrong",std::string("abc123") == creds.getNonce());
+  CPPUNIT_ASSERT_MESSAGE("qop is wrong",std::string("auth") == creds.getQop());
+  CPPUNIT_ASSERT_MESSAGE("escaped quotes were not unescaped",std::string("say \"hi\"") == creds.getOpaque());
+  CPPUNIT_ASSERT_MESSAGE("stale should default to false",!creds.isStale());
+  CPPUNIT_ASSERT_MESSAGE("should be able to authenticate",creds.canAuthenticate());
+}
+
+void CredentialsTest::testUnquotedTokens() {
+  Credentials creds("user","pass");
+  creds.parseWWWAuthenticateHeader("digest realm=public,nonce=n1 , qop=auth,algorithm=MD5");
+  CPPUNIT_ASSERT_MESSAGE("realm is wrong",std::string("public") == creds.getRealm());
+  CPPUNIT_ASSERT_MESSAGE("nonce is wrong",std::string("n1") == creds.getNonce());
+  CPPUNIT_ASSERT_MESSAGE("qop is wrong",std::string("auth") == creds.getQop());
+  CPPUNIT_ASSERT_MESSAGE("opaque should be empty",creds.getOpaque().empty());
+}
+
+void CredentialsTest::testMultipleChallenges() {
+  Credentials creds("user","pass");
+  creds.parseWWWAuthenticateHeader(
+      "Basic realm=\"basic, realm\", Digest realm=\"digest\", nonce=\"n2\", qop=\"auth\", Negotiate");
+  CPPUNIT_ASSERT_MESSAGE("realm was not taken from the Digest challenge",std::string("digest") == creds.getRealm());
+  CPPUNIT_ASSERT_MESSAGE("nonce is wrong",std::string("n2") == creds.getNonce());
+  CPPUNIT_ASSERT_MESSAGE("qop is wrong",std::string("auth") == creds.getQop());
+
+  Credentials basicOnly("user","pass");
+  basicOnly.parseWWWAuthenticateHeader("Basic realm=\"public\"");
+  CPPUNIT_ASSERT_MESSAGE("a Basic challenge should not set a realm",basicOnly.getRealm().empty());
+  CPPUNIT_ASSERT_MESSAGE("a Basic challenge should not allow Digest",!basicOnly.canAuthenticate());
+}
+
+void CredentialsTest::testQopList() {
+  Credentials creds("user","pass");
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n\", qop=\"auth-int, auth\"");
+  CPPUNIT_ASSERT_MESSAGE("auth was not chosen from the qop list",std::string("auth") == creds.getQop());
+
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n\", qop=\"auth-int\"");
+  CPPUNIT_ASSERT_MESSAGE("auth-int alone is not supported",creds.getQop().empty());
+}
+
+void CredentialsTest::testStale() {
+  Credentials creds("user","pass");
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n1\", stale=TRUE");
+  CPPUNIT_ASSERT_MESSAGE("stale=TRUE should be stale",creds.isStale());
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n2\", stale=\"false\"");
+  CPPUNIT_ASSERT_MESSAGE("stale=false should not be stale",!creds.isStale());
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n3\", stale=true");
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n4\"");
+  CPPUNIT_ASSERT_MESSAGE("stale should reset with each challenge",!creds.isStale());
+}
+
+void CredentialsTest::testRfc2617Response() {
+  // The example in section 3.5 of RFC 2617
+  TestCredentials creds("Mufasa","Circle Of Life","0a4f113b");
+  creds.parseWWWAuthenticateHeader("Digest realm=\"testrealm@host.com\", qop=\"auth,auth-int\", "
+      "nonce=\"dcd98b7102dd2f0e8b11d0f600bfb0c093\", opaque=\"5ccc069c403ebaf9f0171e9517f40e41\"");
+  std::string header = creds.respond("GET","/dir/index.html");
+  CPPUNIT_ASSERT_MESSAGE("nc should be 1 for the first request",contains(header,"nc=00000001,"));
+  CPPUNIT_ASSERT_MESSAGE("response does not match RFC 2617: " + header,
+      contains(header,"response=\"6629fae49393a05397450978507c4ef1\""));
+  CPPUNIT_ASSERT_MESSAGE("opaque was not echoed",contains(header,"opaque=\"5ccc069c403ebaf9f0171e9517f40e41\""));
+}
+
+void CredentialsTest::testNonceCountReset() {
+  TestCredentials creds("user","pass","cnonce");
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n1\", qop=\"auth\"");
+  CPPUNIT_ASSERT_MESSAGE("first request should be nc 1",contains(creds.respond("GET","/a"),"nc=00000001,"));
+  CPPUNIT_ASSERT_MESSAGE("second request should be nc 2",contains(creds.respond("GET","/b"),"nc=00000002,"));
+
+  // the same nonce again (E.g. a repeated challenge) continues the count
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n1\", qop=\"auth\"");
+  CPPUNIT_ASSERT_MESSAGE("same nonce should continue at nc 3",contains(creds.respond("GET","/c"),"nc=00000003,"));
+
+  // a new nonce starts again
+  creds.parseWWWAuthenticateHeader("Digest realm=\"r\", nonce=\"n2\", qop=\"auth\", stale=true");
+  CPPUNIT_ASSERT_MESSAGE("new nonce should restart at nc 1",contains(creds.respond("GET","/d"),"nc=00000001,"));
+}
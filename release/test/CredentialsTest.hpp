@@ -0,0 +1,40 @@
+/*
+ * CredentialsTest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef TEST_CREDENTIALSTEST_HPP_
+#define TEST_CREDENTIALSTEST_HPP_
+
+#include <cppunit/Test.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/*
+ * Tests Digest challenge parsing and response generation. Needs no server.
+ */
+class CredentialsTest : public CppUnit::TestCase {
+  CPPUNIT_TEST_SUITE(CredentialsTest);
+    CPPUNIT_TEST(testQuotedValues);
+    CPPUNIT_TEST(testUnquotedTokens);
+    CPPUNIT_TEST(testMultipleChallenges);
+    CPPUNIT_TEST(testQopList);
+    CPPUNIT_TEST(testStale);
+    CPPUNIT_TEST(testRfc2617Response);
+    CPPUNIT_TEST(testNonceCountReset);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp();
+  void tearDown();
+
+  void testQuotedValues(void);
+  void testUnquotedTokens(void);
+  void testMultipleChallenges(void);
+  void testQopList(void);
+  void testStale(void);
+  void testRfc2617Response(void);
+  void testNonceCountReset(void);
+};
+
+#endif /* TEST_CREDENTIALSTEST_HPP_ */
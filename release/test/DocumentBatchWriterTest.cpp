@@ -23,6 +23,10 @@
 #include "mlclient/utilities/ResponseHelper.hpp"
 
 #include <string>
+#include <atomic>
+#include <memory>
+
+#include <cpprest/http_client.h>
 
 #include "mlclient/logging.hpp"
 
@@ -52,6 +56,88 @@ public:
   std::exception ex;
 };
 
+/*
+ * Fails the first batch requests as a dropped connection or timeout would, then saves every batch. Never contacts a
+ * server. If missingResponse is set failures return no response, as IConnection's synchronous defaults do.
+ */
+class FlakyConnection : public mlclient::Connection {
+public:
+  FlakyConnection(const int failures,const bool missingResponse = false) : failures(failures),
+      missingResponse(missingResponse), attempts(0) {
+    ;
+  }
+
+  ResponseTask saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive) override {
+    if (attempts++ < failures) {
+      if (missingResponse) {
+        return pplx::task_from_result(std::shared_ptr<Response>());
+      }
+      return pplx::task_from_exception<std::shared_ptr<Response>>(
+          web::http::http_exception("Connection reset by peer"));
+    }
+    std::shared_ptr<Response> resp = std::make_shared<Response>();
+    resp->setResponseCode(ResponseCode::OK);
+    return pplx::task_from_result(resp);
+  }
+
+  const int failures;
+  const bool missingResponse;
+  std::atomic<int> attempts;
+};
+
+/*
+ * Rejects every batch holding a document whose URI contains "bad", as the server would for invalid content. Never
+ * contacts a server.
+ */
+class RejectingConnection : public mlclient::Connection {
+public:
+  RejectingConnection() : attempts(0) {
+    ;
+  }
+
+  ResponseTask saveDocumentsAsync(const DocumentSet& documents,const long startPosInclusive,
+      const long endPosInclusive) override {
+    attempts++;
+    std::shared_ptr<Response> resp = std::make_shared<Response>();
+    resp->setResponseCode(ResponseCode::OK);
+    for (long idx = startPosInclusive;idx <= endPosInclusive;idx++) {
+      if (std::string::npos != documents.at(idx).getUri().find("bad")) {
+        resp->setResponseCode(ResponseCode::BAD_REQUEST);
+      }
+    }
+    return pplx::task_from_result(resp);
+  }
+
+  std::atomic<int> attempts;
+};
+
+/*
+ * Sends count small text documents in batches of 5 through conn, waiting for the upload to finish
+ */
+Progress sendThrough(IConnection& conn,const long count,const int maxRetries,const long badIdx = -1) {
+  DocumentSet set;
+  std::vector<std::unique_ptr<GenericTextDocumentContent>> contents;
+  for (long i = 0;i < count;i++) {
+    contents.emplace_back(new GenericTextDocumentContent());
+    contents.back()->setContent("document " + std::to_string(i));
+    set.push_back(Document("/mlcpptest/" + std::string((i == badIdx) ? "bad/" : "flaky/") + std::to_string(i) + ".txt",
+        contents.back().get()));
+  }
+  RetryParameters retry;
+  retry.maxRetries = maxRetries;
+  retry.initialBackoff = 1;
+  retry.maxBackoff = 4;
+
+  DocumentBatchWriter writer(&conn);
+  writer.setBatchParameters(2,5,TransactionMode::PER_BATCH,retry);
+  writer.assignDocuments(std::move(set));
+  writer.send();
+  writer.wait();
+  CPPUNIT_ASSERT_MESSAGE("Writer not set to complete",writer.isComplete());
+  return writer.getProgress();
+}
+
 
 void DocumentBatchWriterTest::setUp(void) {
   LOG(DEBUG) << "ENTERING TEST SUITE DocumentBatchWriterTest::setUp";
@@ -112,3 +198,80 @@ void DocumentBatchWriterTest::testFolder(void) {
 }
 
 
+
+void DocumentBatchWriterTest::testTransportFailureRetried(void) {
+  TIMED_FUNC(testTransportFailureRetried);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering DocumentBatchWriterTest::testTransportFailureRetried";
+
+  FlakyConnection conn(3);
+  Progress p = sendThrough(conn,20,5);
+  CPPUNIT_ASSERT_MESSAGE("Every document should be saved",20 == p.completed && 0 == p.failed);
+  CPPUNIT_ASSERT_MESSAGE("Each transport failure should be retried",3 == p.retries);
+  CPPUNIT_ASSERT_MESSAGE("Each batch should be sent once it succeeds",4 + 3 == conn.attempts.load());
+}
+
+void DocumentBatchWriterTest::testTransportFailureExhausted(void) {
+  TIMED_FUNC(testTransportFailureExhausted);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering DocumentBatchWriterTest::testTransportFailureExhausted";
+
+  FlakyConnection conn(1000);
+  Progress p = sendThrough(conn,20,2);
+  CPPUNIT_ASSERT_MESSAGE("Every document should fail",20 == p.completed && 20 == p.failed);
+  CPPUNIT_ASSERT_MESSAGE("Each batch should be retried maxRetries times, and not split",4 * 2 == p.retries &&
+      4 * 3 == conn.attempts.load());
+}
+
+void DocumentBatchWriterTest::testMissingResponseRetried(void) {
+  TIMED_FUNC(testMissingResponseRetried);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering DocumentBatchWriterTest::testMissingResponseRetried";
+
+  FlakyConnection conn(2,true);
+  Progress p = sendThrough(conn,20,5);
+  CPPUNIT_ASSERT_MESSAGE("Every document should be saved",20 == p.completed && 0 == p.failed);
+  CPPUNIT_ASSERT_MESSAGE("Each missing response should be retried",2 == p.retries);
+}
+
+void DocumentBatchWriterTest::testRejectedBatchSplit(void) {
+  TIMED_FUNC(testRejectedBatchSplit);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering DocumentBatchWriterTest::testRejectedBatchSplit";
+
+  RejectingConnection conn;
+  Progress p = sendThrough(conn,20,3,7);
+  CPPUNIT_ASSERT_MESSAGE("Only the bad document should fail",20 == p.completed && 1 == p.failed);
+  CPPUNIT_ASSERT_MESSAGE("A rejected batch should not be retried",0 == p.retries);
+  // batch 5-9 is split in to 5-6 and 7-9, then 7-9 in to 7 and 8-9
+  CPPUNIT_ASSERT_MESSAGE("The rejected batch should be split to isolate the document",4 + 4 == conn.attempts.load());
+}
+
+void DocumentBatchWriterTest::testAdaptiveManyTasks(void) {
+  TIMED_FUNC(testAdaptiveManyTasks);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering DocumentBatchWriterTest::testAdaptiveManyTasks";
+
+  DocumentSet set;
+  std::vector<std::unique_ptr<GenericTextDocumentContent>> contents;
+  for (long i = 0;i < 200;i++) {
+    contents.emplace_back(new GenericTextDocumentContent());
+    contents.back()->setContent("document " + std::to_string(i));
+    set.push_back(Document("/mlcpptest/adaptive/" + std::to_string(i) + ".txt",contents.back().get()));
+  }
+  // more tasks than the pplx scheduler has threads, which must not starve the requests' own continuations
+  AdaptiveBatchParameters params;
+  params.minParallelTasks = 64;
+  params.maxParallelTasks = 256;
+  params.maxBatchSize = 2;
+
+  FlakyConnection conn(2);
+  DocumentBatchWriter writer(&conn);
+  writer.setAdaptiveBatchParameters(params,TransactionMode::PER_BATCH,RetryParameters());
+  writer.assignDocuments(std::move(set));
+  writer.send();
+  writer.wait();
+  CPPUNIT_ASSERT_MESSAGE("Writer not set to complete",writer.isComplete());
+  const Progress p = writer.getProgress();
+  CPPUNIT_ASSERT_MESSAGE("Every document should be saved",200 == p.completed && 0 == p.failed);
+}
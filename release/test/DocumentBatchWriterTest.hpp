@@ -28,12 +28,22 @@ using namespace mlclient;
 class DocumentBatchWriterTest : public CppUnit::TestCase {
   CPPUNIT_TEST_SUITE(DocumentBatchWriterTest);
     CPPUNIT_TEST(testFolder);
+    CPPUNIT_TEST(testTransportFailureRetried);
+    CPPUNIT_TEST(testTransportFailureExhausted);
+    CPPUNIT_TEST(testMissingResponseRetried);
+    CPPUNIT_TEST(testRejectedBatchSplit);
+    CPPUNIT_TEST(testAdaptiveManyTasks);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp();
   void tearDown();
 
   void testFolder(void);
+  void testTransportFailureRetried(void);
+  void testTransportFailureExhausted(void);
+  void testMissingResponseRetried(void);
+  void testRejectedBatchSplit(void);
+  void testAdaptiveManyTasks(void);
 private:
   IConnection* ml;
 };
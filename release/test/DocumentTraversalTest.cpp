@@ -360,3 +360,58 @@ void DocumentTraversalTest::testSubDocumentExtraction() {
   //delete newNav;
 }
 
+
+void DocumentTraversalTest::testNavigatorOwnsNodes() {
+  TIMED_FUNC(testNavigatorOwnsNodes);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering testNavigatorOwnsNodes";
+
+  std::string raw = "<root><el1>val1</el1><obj1><subel1>subval1</subel1></obj1></root>";
+  std::shared_ptr<pugi::xml_document> xml = std::make_shared<pugi::xml_document>();
+  xml->load_string(raw.c_str());
+
+  // every node holds the document, so its use count shows how many nodes are still alive
+  IDocumentNavigator* nav = new mlclient::utilities::PugiXmlDocumentNavigator(xml,true);
+  IDocumentNode* obj1 = nav->at("obj1");
+  CPPUNIT_ASSERT_MESSAGE("obj1 is null",nullptr != obj1);
+  IDocumentNode* subel1 = obj1->at("subel1");
+  CPPUNIT_ASSERT_MESSAGE("subel1 value is wrong","subval1" == subel1->asString());
+  CPPUNIT_ASSERT_MESSAGE("el1 value is wrong","val1" == nav->at("el1")->asString());
+  CPPUNIT_ASSERT_MESSAGE("nodes should be alive while the navigator is",xml.use_count() > 1);
+
+  // the nodes are not deleted by the caller - deleting the navigator destroys (and so invalidates) them all
+  delete nav;
+  CPPUNIT_ASSERT_MESSAGE("deleting the navigator should destroy every node reached from it",1 == xml.use_count());
+
+  LOG(DEBUG) << " Leaving testNavigatorOwnsNodes";
+}
+
+void DocumentTraversalTest::testDirectNodeOwnsChildren() {
+  TIMED_FUNC(testDirectNodeOwnsChildren);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering testDirectNodeOwnsChildren";
+
+  std::string raw = "<root><el1>val1</el1><obj1><subel1>subval1</subel1></obj1></root>";
+  std::shared_ptr<pugi::xml_document> xml = std::make_shared<pugi::xml_document>();
+  xml->load_string(raw.c_str());
+
+  IDocumentNavigator* nav = new mlclient::utilities::PugiXmlDocumentNavigator(xml,true);
+  IDocumentNode* fromNav = nav->at("el1");
+  CPPUNIT_ASSERT_MESSAGE("el1 is null",nullptr != fromNav);
+
+  // a directly created node owns the children reached from it, independent of any navigator
+  IDocumentNode* root = new mlclient::utilities::PugiXmlDocumentNode(xml,xml->document_element());
+  IDocumentNode* subel1 = root->at("obj1")->at("subel1");
+  CPPUNIT_ASSERT_MESSAGE("subel1 is null",nullptr != subel1);
+  const long withNavigator = xml.use_count();
+
+  delete nav;
+  CPPUNIT_ASSERT_MESSAGE("deleting the navigator should only destroy its own nodes",
+      xml.use_count() < withNavigator && xml.use_count() > 2);
+  CPPUNIT_ASSERT_MESSAGE("children of the direct node should survive the navigator","subval1" == subel1->asString());
+
+  delete root;
+  CPPUNIT_ASSERT_MESSAGE("deleting the node should destroy its children",1 == xml.use_count());
+
+  LOG(DEBUG) << " Leaving testDirectNodeOwnsChildren";
+}
@@ -26,6 +26,8 @@ class DocumentTraversalTest : public CppUnit::TestCase {
   CPPUNIT_TEST(testJsonTraversal);
   CPPUNIT_TEST(testXmlTraversal);
   CPPUNIT_TEST(testSubDocumentExtraction);
+  CPPUNIT_TEST(testNavigatorOwnsNodes);
+  CPPUNIT_TEST(testDirectNodeOwnsChildren);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp();
@@ -34,6 +36,8 @@ public:
   void testJsonTraversal(void);
   void testXmlTraversal(void);
   void testSubDocumentExtraction(void);
+  void testNavigatorOwnsNodes(void);
+  void testDirectNodeOwnsChildren(void);
 
   void testResult(IDocumentNode* root);
   void testResultN(IDocumentNavigator* root);
@@ -0,0 +1,161 @@
+/*
+ * MultipartStreamTest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "MultipartStreamTest.hpp"
+#include "mlclient/internals/FileStream.hpp"
+#include "mlclient/internals/MultipartStream.hpp"
+
+#include "mlclient/logging.hpp"
+
+using namespace mlclient::internals;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MultipartStreamTest);
+
+namespace {
+
+std::unique_ptr<std::istream> streamOf(const std::string& content) {
+  return std::unique_ptr<std::istream>(new std::istringstream(content));
+}
+
+void writeFile(const std::string& filename,const std::string& content) {
+  std::ofstream out(filename,std::ios::binary | std::ios::trunc);
+  out << content;
+}
+
+std::string readAll(std::istream& in) {
+  return std::string(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+}
+
+} // end anonymous namespace
+
+void MultipartStreamTest::setUp(void) {
+  LOG(DEBUG) << "ENTERING TEST SUITE MultipartStreamTest";
+}
+
+void MultipartStreamTest::tearDown(void) {
+  LOG(DEBUG) << "LEAVING TEST SUITE MultipartStreamTest";
+}
+
+void MultipartStreamTest::testConcatenation() {
+  MultipartStream ms;
+  std::string header("--BOUNDARY\r\n");
+  ms.buffer().append(header);
+  ms.buffer().append(std::string("Content-Type: application/json\r\n\r\n"));
+  ms.buffer().append(streamOf("{\"a\":1}"),7);
+  ms.buffer().append(std::string("\r\n--BOUNDARY--\r\n"));
+
+  const std::string expected("--BOUNDARY\r\nContent-Type: application/json\r\n\r\n{\"a\":1}\r\n--BOUNDARY--\r\n");
+  CPPUNIT_ASSERT_MESSAGE("length is wrong",expected.size() == ms.buffer().getLength());
+  CPPUNIT_ASSERT_MESSAGE("content is wrong",expected == readAll(ms));
+}
+
+void MultipartStreamTest::testLargeStream() {
+  // bigger than the read buffer, so the stream is read in several chunks
+  std::string content;
+  for (int i = 0;i < 200 * 1024;i++) {
+    content.push_back((char)('a' + (i % 26)));
+  }
+  MultipartStream ms;
+  ms.buffer().append(std::string("head"));
+  ms.buffer().append(streamOf(content),content.size());
+  ms.buffer().append(std::string("tail"));
+
+  const std::string read = readAll(ms);
+  CPPUNIT_ASSERT_MESSAGE("length is wrong",content.size() + 8 == ms.buffer().getLength());
+  CPPUNIT_ASSERT_MESSAGE("content is wrong",("head" + content + "tail") == read);
+}
+
+void MultipartStreamTest::testRewind() {
+  MultipartStream ms;
+  ms.buffer().append(std::string("one,"));
+  ms.buffer().append(streamOf("two,"),4);
+  ms.buffer().append(std::string("three"));
+
+  char partial[6];
+  ms.read(partial,6);
+  CPPUNIT_ASSERT_MESSAGE("partial read is wrong",std::string("one,tw") == std::string(partial,6));
+  CPPUNIT_ASSERT_MESSAGE("tell is wrong",6 == ms.tellg());
+
+  ms.seekg(0,std::ios::beg);
+  CPPUNIT_ASSERT_MESSAGE("rewind failed",!ms.fail());
+  CPPUNIT_ASSERT_MESSAGE("content after rewind is wrong",std::string("one,two,three") == readAll(ms));
+
+  // and again, from the end
+  ms.clear();
+  ms.seekg(0,std::ios::beg);
+  CPPUNIT_ASSERT_MESSAGE("second rewind failed",!ms.fail());
+  CPPUNIT_ASSERT_MESSAGE("content after second rewind is wrong",std::string("one,two,three") == readAll(ms));
+
+  // only rewinding is supported
+  ms.clear();
+  ms.seekg(3,std::ios::beg);
+  CPPUNIT_ASSERT_MESSAGE("seeking elsewhere should fail",ms.fail());
+}
+
+void MultipartStreamTest::testShortStream() {
+  // E.g. a file truncated after its length was taken
+  MultipartStream ms;
+  ms.buffer().append(std::string("head,"));
+  ms.buffer().append(streamOf("abc"),10);
+  ms.buffer().append(std::string(",tail"));
+
+  CPPUNIT_ASSERT_MESSAGE("declared length is wrong",20 == ms.buffer().getLength());
+  const std::string read = readAll(ms);
+  CPPUNIT_ASSERT_MESSAGE("should end where the stream ran out",std::string("head,abc") == read);
+}
+
+void MultipartStreamTest::testEmpty() {
+  MultipartStream ms;
+  ms.buffer().append(std::string(""));
+  ms.buffer().append(streamOf(""),0);
+  CPPUNIT_ASSERT_MESSAGE("length should be zero",0 == ms.buffer().getLength());
+  CPPUNIT_ASSERT_MESSAGE("should read nothing",readAll(ms).empty());
+}
+
+void MultipartStreamTest::testFile() {
+  const std::string filename("MultipartStreamTest-file.txt");
+  std::string content;
+  for (int i = 0;i < 100 * 1024;i++) {
+    content.push_back((char)('0' + (i % 10)));
+  }
+  writeFile(filename,content);
+
+  std::unique_ptr<std::istream> file(new FileStream(filename));
+  CPPUNIT_ASSERT_MESSAGE("file should have opened",file->good());
+  CPPUNIT_ASSERT_MESSAGE("file length is wrong",content.size() == FileStream::lengthOf(*file,-1));
+  MultipartStream ms;
+  ms.buffer().append(std::string("head"));
+  ms.buffer().append(std::move(file),content.size());
+  CPPUNIT_ASSERT_MESSAGE("content is wrong",("head" + content) == readAll(ms));
+
+  ms.clear();
+  ms.seekg(0,std::ios::beg);
+  CPPUNIT_ASSERT_MESSAGE("content after rewind is wrong",("head" + content) == readAll(ms));
+
+  FileStream missing("MultipartStreamTest-missing.txt");
+  CPPUNIT_ASSERT_MESSAGE("missing file should fail",missing.fail());
+  std::remove(filename.c_str());
+}
+
+void MultipartStreamTest::testTruncatedFile() {
+  const std::string filename("MultipartStreamTest-truncated.txt");
+  writeFile(filename,"0123456789");
+
+  MultipartStream ms;
+  ms.buffer().append(std::unique_ptr<std::istream>(new FileStream(filename)),10);
+  writeFile(filename,"0123"); // truncated after opening, mid upload
+  ms.buffer().append(std::string(",tail"));
+  CPPUNIT_ASSERT_MESSAGE("should end where the file now ends",std::string("0123") == readAll(ms));
+  std::remove(filename.c_str());
+}
@@ -0,0 +1,40 @@
+/*
+ * MultipartStreamTest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef TEST_MULTIPARTSTREAMTEST_HPP_
+#define TEST_MULTIPARTSTREAMTEST_HPP_
+
+#include <cppunit/Test.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/*
+ * Tests the lazily read multipart body stream. Needs no server.
+ */
+class MultipartStreamTest : public CppUnit::TestCase {
+  CPPUNIT_TEST_SUITE(MultipartStreamTest);
+    CPPUNIT_TEST(testConcatenation);
+    CPPUNIT_TEST(testLargeStream);
+    CPPUNIT_TEST(testRewind);
+    CPPUNIT_TEST(testShortStream);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testFile);
+    CPPUNIT_TEST(testTruncatedFile);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp();
+  void tearDown();
+
+  void testConcatenation(void);
+  void testLargeStream(void);
+  void testRewind(void);
+  void testShortStream(void);
+  void testEmpty(void);
+  void testFile(void);
+  void testTruncatedFile(void);
+};
+
+#endif /* TEST_MULTIPARTSTREAMTEST_HPP_ */
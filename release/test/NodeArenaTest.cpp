@@ -0,0 +1,192 @@
+/*
+ * NodeArenaTest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "NodeArenaTest.hpp"
+#include "mlclient/internals/NodeArena.hpp"
+
+#include "mlclient/logging.hpp"
+
+using namespace mlclient::internals;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeArenaTest);
+
+namespace {
+
+/*
+ * Records its id in a shared list when destroyed
+ */
+class Recorder {
+public:
+  Recorder(std::vector<int>& destroyed,const int id) : destroyed(destroyed), id(id) {
+    ;
+  }
+  ~Recorder() {
+    destroyed.push_back(id);
+  }
+
+  std::vector<int>& destroyed;
+  int id;
+};
+
+class Thrower {
+public:
+  Thrower(std::vector<int>& destroyed) : destroyed(destroyed) {
+    throw std::runtime_error("constructor failed");
+  }
+  ~Thrower() {
+    destroyed.push_back(-1);
+  }
+
+  std::vector<int>& destroyed;
+};
+
+struct alignas(16) Aligned {
+  double values[2];
+};
+
+struct Large {
+  char data[100 * 1024];
+};
+
+/*
+ * A node that makes its children through a NodeArenaRef, as the document node Impls do
+ */
+class Node {
+public:
+  Node(std::vector<int>& destroyed,const int id) : destroyed(destroyed), id(id), children(nullptr) {
+    ;
+  }
+  Node(NodeArena& arena,std::vector<int>& destroyed,const int id) : destroyed(destroyed), id(id), children(&arena) {
+    ;
+  }
+  ~Node() {
+    destroyed.push_back(id);
+  }
+
+  Node* child(const int childId) {
+    return children.make<Node>(destroyed,childId);
+  }
+
+  std::vector<int>& destroyed;
+  int id;
+  NodeArenaRef children;
+};
+
+} // end anonymous namespace
+
+void NodeArenaTest::setUp(void) {
+  LOG(DEBUG) << "ENTERING TEST SUITE NodeArenaTest";
+}
+
+void NodeArenaTest::tearDown(void) {
+  LOG(DEBUG) << "LEAVING TEST SUITE NodeArenaTest";
+}
+
+void NodeArenaTest::testDestructionOrder() {
+  std::vector<int> destroyed;
+  {
+    NodeArena arena;
+    for (int id = 0;id < 1000;id++) { // spans several blocks
+      arena.make<Recorder>(destroyed,id);
+    }
+    CPPUNIT_ASSERT_MESSAGE("nothing should be destroyed while the arena lives",destroyed.empty());
+  }
+  CPPUNIT_ASSERT_MESSAGE("every object should be destroyed",1000 == destroyed.size());
+  for (int i = 0;i < 1000;i++) {
+    CPPUNIT_ASSERT_MESSAGE("objects should be destroyed in reverse order",999 - i == destroyed[i]);
+  }
+}
+
+void NodeArenaTest::testLazyFirstBlock() {
+  std::vector<int> destroyed; // outlives the arena
+  NodeArena arena;
+  CPPUNIT_ASSERT_MESSAGE("a new arena should reserve nothing",0 == arena.getReservedBytes());
+  CPPUNIT_ASSERT_MESSAGE("the arena itself should be small",sizeof(NodeArena) <= 8 * sizeof(void*));
+
+  arena.make<Recorder>(destroyed,1);
+  CPPUNIT_ASSERT_MESSAGE("the first block should be small",256 == arena.getReservedBytes());
+
+  std::size_t previous = arena.getReservedBytes();
+  std::size_t blocks = 1;
+  for (int id = 0;id < 20000;id++) {
+    arena.make<Recorder>(destroyed,id);
+    if (arena.getReservedBytes() != previous) {
+      const std::size_t block = arena.getReservedBytes() - previous;
+      CPPUNIT_ASSERT_MESSAGE("blocks should double up to 64 KB",
+          block == (std::size_t)256 << blocks || (block == 64 * 1024 && ((std::size_t)256 << blocks) > 64 * 1024));
+      previous = arena.getReservedBytes();
+      blocks++;
+    }
+  }
+  CPPUNIT_ASSERT_MESSAGE("should have grown beyond the largest block size",blocks > 9);
+}
+
+void NodeArenaTest::testAlignmentAndLargeObjects() {
+  NodeArena arena;
+  const char* text = arena.copy("a");
+  CPPUNIT_ASSERT_MESSAGE("copy should be null terminated",0 == std::strcmp("a",text));
+  for (int i = 0;i < 100;i++) {
+    Aligned* aligned = arena.make<Aligned>();
+    CPPUNIT_ASSERT_MESSAGE("object should be aligned",0 == reinterpret_cast<std::uintptr_t>(aligned) % 16);
+    arena.copy(std::string(i,'x'));
+  }
+  Large* large = arena.make<Large>();
+  std::memset(large->data,1,sizeof(large->data)); // ASan reports any overrun
+  CPPUNIT_ASSERT_MESSAGE("a large object should get a block of its own",arena.getReservedBytes() > sizeof(Large));
+  const std::string after("made after a large object");
+  CPPUNIT_ASSERT_MESSAGE("copy after a large object is wrong",after == arena.copy(after));
+}
+
+void NodeArenaTest::testThrowingConstructor() {
+  std::vector<int> destroyed;
+  {
+    NodeArena arena;
+    arena.make<Recorder>(destroyed,1);
+    bool thrown = false;
+    try {
+      arena.make<Thrower>(destroyed);
+    } catch (std::runtime_error&) {
+      thrown = true;
+    }
+    CPPUNIT_ASSERT_MESSAGE("constructor exception should propagate",thrown);
+    arena.make<Recorder>(destroyed,2);
+  }
+  CPPUNIT_ASSERT_MESSAGE("only constructed objects should be destroyed",
+      2 == destroyed.size() && 2 == destroyed[0] && 1 == destroyed[1]);
+}
+
+void NodeArenaTest::testRefOwnership() {
+  std::vector<int> destroyed;
+  {
+    // a node made in an arena borrows it, so its children go when the arena does
+    NodeArena arena;
+    Node* parent = arena.make<Node>(arena,destroyed,1);
+    CPPUNIT_ASSERT_MESSAGE("arena node should borrow its arena",parent->children.isBorrowed());
+    parent->child(2)->child(3);
+  }
+  CPPUNIT_ASSERT_MESSAGE("arena nodes should be destroyed newest first",
+      3 == destroyed.size() && 3 == destroyed[0] && 2 == destroyed[1] && 1 == destroyed[2]);
+
+  // a directly created node owns an arena made on first use, and frees its children along with itself
+  destroyed.clear();
+  Node* direct = new Node(destroyed,1);
+  CPPUNIT_ASSERT_MESSAGE("direct node should not borrow an arena",!direct->children.isBorrowed());
+  Node* child = direct->child(2);
+  Node* grandchild = child->child(3);
+  CPPUNIT_ASSERT_MESSAGE("children should share the direct node's arena",
+      child->children.isBorrowed() && grandchild->children.isBorrowed());
+  CPPUNIT_ASSERT_MESSAGE("children should survive until the node is deleted",destroyed.empty() && 3 == grandchild->id);
+  delete direct;
+  CPPUNIT_ASSERT_MESSAGE("deleting the node should free its children after itself",
+      3 == destroyed.size() && 1 == destroyed[0] && 3 == destroyed[1] && 2 == destroyed[2]);
+}
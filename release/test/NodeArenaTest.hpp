@@ -0,0 +1,36 @@
+/*
+ * NodeArenaTest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef TEST_NODEARENATEST_HPP_
+#define TEST_NODEARENATEST_HPP_
+
+#include <cppunit/Test.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/*
+ * Tests the arena document nodes are made in. Needs no server.
+ */
+class NodeArenaTest : public CppUnit::TestCase {
+  CPPUNIT_TEST_SUITE(NodeArenaTest);
+    CPPUNIT_TEST(testDestructionOrder);
+    CPPUNIT_TEST(testLazyFirstBlock);
+    CPPUNIT_TEST(testAlignmentAndLargeObjects);
+    CPPUNIT_TEST(testThrowingConstructor);
+    CPPUNIT_TEST(testRefOwnership);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp();
+  void tearDown();
+
+  void testDestructionOrder(void);
+  void testLazyFirstBlock(void);
+  void testAlignmentAndLargeObjects(void);
+  void testThrowingConstructor(void);
+  void testRefOwnership(void);
+};
+
+#endif /* TEST_NODEARENATEST_HPP_ */
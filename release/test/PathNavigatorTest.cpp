@@ -136,4 +136,50 @@ void PathNavigatorTest::testJsonPathExtended() {
   CPPUNIT_ASSERT_MESSAGE("subel1 string from at is null","" !=val2);
 
 
-};
\ No newline at end of file
+};
+
+void PathNavigatorTest::testNavigatorOwnsPathNodes() {
+  TIMED_FUNC(testNavigatorOwnsPathNodes);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering PathNavigatorTest::testNavigatorOwnsPathNodes";
+
+  std::string raw = "<root><obj1><obj2><subel1>subval1</subel1></obj2></obj1></root>";
+  std::shared_ptr<pugi::xml_document> xml = std::make_shared<pugi::xml_document>();
+  xml->load_string(raw.c_str());
+
+  // every node holds the document, so its use count shows how many nodes are still alive
+  IDocumentNavigator* nav = new PugiXmlDocumentNavigator(xml,true);
+  IDocumentNode* subel1 = mlclient::utilities::PathNavigator::navigate(nav,"obj1/obj2/subel1");
+  CPPUNIT_ASSERT_MESSAGE("subel1 value is wrong","subval1" == subel1->asString());
+  IDocumentNode* obj2 = mlclient::utilities::PathNavigator::navigate(nav,"obj1/obj2");
+  IDocumentNode* subelAgain = mlclient::utilities::PathNavigator::at(obj2,"subel1");
+  CPPUNIT_ASSERT_MESSAGE("subel1 from at value is wrong","subval1" == subelAgain->asString());
+
+  // the intermediate and final nodes all belong to the navigator
+  delete nav;
+  CPPUNIT_ASSERT_MESSAGE("deleting the navigator should destroy every node on the paths",1 == xml.use_count());
+};
+
+void PathNavigatorTest::testDirectNodeOwnsPathNodes() {
+  TIMED_FUNC(testDirectNodeOwnsPathNodes);
+  LOG(DEBUG) << " --------------------------------------------";
+  LOG(DEBUG) << " Entering PathNavigatorTest::testDirectNodeOwnsPathNodes";
+
+  std::string raw = "<root><obj1><obj2><subel1>subval1</subel1></obj2></obj1></root>";
+  std::shared_ptr<pugi::xml_document> xml = std::make_shared<pugi::xml_document>();
+  xml->load_string(raw.c_str());
+
+  IDocumentNavigator* nav = new PugiXmlDocumentNavigator(xml,true);
+  CPPUNIT_ASSERT_MESSAGE("navigator path is null",nullptr != mlclient::utilities::PathNavigator::navigate(nav,"obj1/obj2"));
+
+  // nodes reached by path from a directly created node belong to that node, not to any navigator
+  IDocumentNode* root = new PugiXmlDocumentNode(xml,xml->document_element());
+  IDocumentNode* subel1 = mlclient::utilities::PathNavigator::at(root,"obj1/obj2/subel1");
+  CPPUNIT_ASSERT_MESSAGE("subel1 is null",nullptr != subel1);
+
+  delete nav;
+  CPPUNIT_ASSERT_MESSAGE("path nodes of the direct node should survive the navigator","subval1" == subel1->asString());
+
+  delete root;
+  CPPUNIT_ASSERT_MESSAGE("deleting the node should destroy its path nodes",1 == xml.use_count());
+};
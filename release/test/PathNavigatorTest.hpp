@@ -23,6 +23,8 @@ class PathNavigatorTest : public CppUnit::TestCase {
     CPPUNIT_TEST(testXmlPath);
     CPPUNIT_TEST(testJsonPath);
     CPPUNIT_TEST(testJsonPathExtended);
+    CPPUNIT_TEST(testNavigatorOwnsPathNodes);
+    CPPUNIT_TEST(testDirectNodeOwnsPathNodes);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp();
@@ -31,6 +33,8 @@ public:
   void testXmlPath(void);
   void testJsonPath(void);
   void testJsonPathExtended(void);
+  void testNavigatorOwnsPathNodes(void);
+  void testDirectNodeOwnsPathNodes(void);
 private:
   IConnection* ml;
 };
@@ -0,0 +1,329 @@
+/*
+ * SearchResponseDecoderTest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+#include <vector>
+
+#include "SearchResponseDecoderTest.hpp"
+#include "mlclient/internals/SearchResponseDecoder.hpp"
+
+#include "mlclient/logging.hpp"
+
+using namespace mlclient::internals;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SearchResponseDecoderTest);
+
+namespace {
+
+/*
+ * What the tests check of each row, copied as the decoder reuses its Row
+ */
+struct Decoded {
+  long index;
+  std::string uri;
+  std::string path;
+  long score;
+  double confidence;
+  std::string mimeType;
+  std::string format;
+  std::string content;
+  std::string snippet;
+  std::string matches;
+  std::string result;
+};
+
+std::string text(const DecodedSpan& span) {
+  return span.empty() ? std::string() : std::string(span.data,span.length);
+}
+
+bool decode(SearchResponseDecoder& decoder,const std::string& body,const bool isXml,std::vector<Decoded>& rows) {
+  auto handler = [&rows] (const SearchResponseDecoder::Row& row) {
+    Decoded d;
+    d.index = row.index;
+    d.uri = row.uri;
+    d.path = row.path;
+    d.score = row.score;
+    d.confidence = row.confidence;
+    d.mimeType = row.mimeType;
+    d.format = row.format;
+    d.content = text(row.content);
+    d.snippet = text(row.snippet);
+    d.matches = text(row.matches);
+    d.result = text(row.result);
+    rows.push_back(d);
+  };
+  return isXml ? decoder.decodeXml(body.data(),body.size(),handler) :
+      decoder.decodeJson(body.data(),body.size(),handler);
+}
+
+const std::string JSON_RESPONSE =
+    "{\"snippet-format\":\"snippet\",\"total\":25,\"start\":11,\"page-length\":2,\"results\":["
+    "{\"index\":11,\"uri\":\"/doc/11.json\",\"path\":\"fn:doc(\\\"/doc/11.json\\\")\",\"score\":92160,"
+    "\"confidence\":0.4,\"fitness\":0.7,\"href\":\"/v1/documents?uri=%2Fdoc%2F11.json\",\"mimetype\":\"application/json\","
+    "\"format\":\"json\",\"matches\":[{\"path\":\"fn:doc(\\\"/doc/11.json\\\")/text\",\"match-text\":[\"a \","
+    "{\"highlight\":\"word\"}]}]},"
+    "{\"index\":12,\"uri\":\"/doc/12.xml\",\"path\":\"fn:doc(\\\"/doc/12.xml\\\")\",\"score\":46080,"
+    "\"confidence\":0.2,\"fitness\":0.5,\"mimetype\":\"application/xml\",\"format\":\"xml\",\"matches\":[]}],"
+    "\"qtext\":\"word\",\"metrics\":{\"query-resolution-time\":\"PT0.002S\",\"snippet-resolution-time\":\"PT0.001S\","
+    "\"total-time\":\"PT0.004S\"}}";
+
+const std::string XML_RESPONSE =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<search:response snippet-format=\"snippet\" total=\"25\" start=\"11\" page-length=\"2\" "
+    "xmlns:search=\"http://marklogic.com/appservices/search\">\n"
+    "  <search:result index=\"11\" uri=\"/doc/11.xml\" path=\"fn:doc(&quot;/doc/11.xml&quot;)\" score=\"92160\" "
+    "confidence=\"0.4\" fitness=\"0.7\" mimetype=\"application/xml\" format=\"xml\">\n"
+    "    <search:snippet><search:match path=\"fn:doc(&quot;/doc/11.xml&quot;)/a\">a "
+    "<search:highlight>word</search:highlight></search:match></search:snippet>\n"
+    "  </search:result>\n"
+    "  <search:result index=\"12\" uri=\"/doc/12.xml\" path=\"fn:doc(&quot;/doc/12.xml&quot;)\" score=\"46080\" "
+    "confidence=\"0.2\" fitness=\"0.5\" mimetype=\"application/xml\" format=\"xml\"/>\n"
+    "  <search:qtext>word</search:qtext>\n"
+    "  <search:metrics>\n"
+    "    <search:query-resolution-time>PT0.002S</search:query-resolution-time>\n"
+    "    <search:snippet-resolution-time>PT0.001S</search:snippet-resolution-time>\n"
+    "    <search:total-time>PT0.004S</search:total-time>\n"
+    "  </search:metrics>\n"
+    "</search:response>";
+
+} // end anonymous namespace
+
+void SearchResponseDecoderTest::setUp(void) {
+  LOG(DEBUG) << "ENTERING TEST SUITE SearchResponseDecoderTest";
+}
+
+void SearchResponseDecoderTest::tearDown(void) {
+  LOG(DEBUG) << "LEAVING TEST SUITE SearchResponseDecoderTest";
+}
+
+void SearchResponseDecoderTest::testJsonResponse() {
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,JSON_RESPONSE,false,rows));
+  const SearchResponseDecoder::Summary& summary = decoder.getSummary();
+  CPPUNIT_ASSERT_MESSAGE("snippet format is wrong",summary.hasSnippetFormat && "snippet" == summary.snippetFormat);
+  CPPUNIT_ASSERT_MESSAGE("total is wrong",25 == summary.total);
+  CPPUNIT_ASSERT_MESSAGE("start is wrong",11 == summary.start);
+  CPPUNIT_ASSERT_MESSAGE("page length is wrong",2 == summary.pageLength);
+  CPPUNIT_ASSERT_MESSAGE("metrics are wrong",summary.hasMetrics && "PT0.002S" == summary.queryResolutionTime &&
+      "PT0.001S" == summary.snippetResolutionTime && "PT0.004S" == summary.totalTime);
+
+  CPPUNIT_ASSERT_MESSAGE("should have two rows",2 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("index is wrong",11 == rows[0].index && 12 == rows[1].index);
+  CPPUNIT_ASSERT_MESSAGE("uri is wrong","/doc/11.json" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("escaped path is wrong","fn:doc(\"/doc/11.json\")" == rows[0].path);
+  CPPUNIT_ASSERT_MESSAGE("score is wrong",92160 == rows[0].score);
+  CPPUNIT_ASSERT_MESSAGE("confidence is wrong",rows[0].confidence > 0.39 && rows[0].confidence < 0.41);
+  CPPUNIT_ASSERT_MESSAGE("mime type is wrong","application/json" == rows[0].mimeType);
+  CPPUNIT_ASSERT_MESSAGE("format is wrong","json" == rows[0].format && "xml" == rows[1].format);
+  CPPUNIT_ASSERT_MESSAGE("matches should be the raw array",'[' == rows[0].matches[0] &&
+      std::string::npos != rows[0].matches.find("{\"highlight\":\"word\"}"));
+  CPPUNIT_ASSERT_MESSAGE("empty matches should be present","[]" == rows[1].matches);
+  CPPUNIT_ASSERT_MESSAGE("content should be absent",rows[0].content.empty());
+  CPPUNIT_ASSERT_MESSAGE("result should be the whole object",'{' == rows[1].result.front() &&
+      '}' == rows[1].result.back() && std::string::npos != rows[1].result.find("/doc/12.xml"));
+}
+
+void SearchResponseDecoderTest::testXmlResponse() {
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,XML_RESPONSE,true,rows));
+  const SearchResponseDecoder::Summary& summary = decoder.getSummary();
+  CPPUNIT_ASSERT_MESSAGE("snippet format is wrong",summary.hasSnippetFormat && "snippet" == summary.snippetFormat);
+  CPPUNIT_ASSERT_MESSAGE("total is wrong",25 == summary.total);
+  CPPUNIT_ASSERT_MESSAGE("start is wrong",11 == summary.start);
+  CPPUNIT_ASSERT_MESSAGE("page length is wrong",2 == summary.pageLength);
+  CPPUNIT_ASSERT_MESSAGE("metrics are wrong",summary.hasMetrics && "PT0.002S" == summary.queryResolutionTime &&
+      "PT0.001S" == summary.snippetResolutionTime && "PT0.004S" == summary.totalTime);
+
+  CPPUNIT_ASSERT_MESSAGE("should have two rows",2 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("index is wrong",11 == rows[0].index && 12 == rows[1].index);
+  CPPUNIT_ASSERT_MESSAGE("uri is wrong","/doc/11.xml" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("path entities were not replaced","fn:doc(\"/doc/11.xml\")" == rows[0].path);
+  CPPUNIT_ASSERT_MESSAGE("score is wrong",92160 == rows[0].score && 46080 == rows[1].score);
+  CPPUNIT_ASSERT_MESSAGE("snippet should be the whole element",0 == rows[0].snippet.find("<search:snippet>") &&
+      std::string::npos != rows[0].snippet.find("</search:snippet>"));
+  CPPUNIT_ASSERT_MESSAGE("self closing result should have no snippet",rows[1].snippet.empty());
+  CPPUNIT_ASSERT_MESSAGE("self closing result should be the whole tag",'/' == rows[1].result[rows[1].result.size() - 2]);
+}
+
+void SearchResponseDecoderTest::testJsonEscapes() {
+  // escaped quotes and backslashes, control characters, a BMP character, and a surrogate pair (U+1F600)
+  const std::string body =
+      "{\"snippet-format\":\"raw\",\"total\":1,\"start\":1,\"page-length\":10,\"results\":[{\"index\":1,"
+      "\"uri\":\"/a \\\"quoted\\\" \\\\ \\/ name\\t\\n.json\",\"path\":\"caf\\u00e9 \\ud83d\\ude00\","
+      "\"content\":{\"text\":\"}]\\\"{[\"},\"format\":\"json\"}]}";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,false,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("escapes in uri are wrong","/a \"quoted\" \\ / name\t\n.json" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("unicode escapes are wrong","caf\xC3\xA9 \xF0\x9F\x98\x80" == rows[0].path);
+  CPPUNIT_ASSERT_MESSAGE("brackets within strings should not end the content",
+      "{\"text\":\"}]\\\"{[\"}" == rows[0].content);
+
+  // an unpaired high surrogate is replaced, and the following escape kept
+  std::string out;
+  const std::string lone("\"\\ud83dx\\ud83d\\u0041\"");
+  CPPUNIT_ASSERT_MESSAGE("lone surrogate should decode",
+      SearchResponseDecoder::jsonString(DecodedSpan{lone.data(),lone.size()},out));
+  CPPUNIT_ASSERT_MESSAGE("lone surrogates are wrong","\xED\xA0\xBDx\xEF\xBF\xBD" "A" == out);
+
+  const std::string bad("\"\\uZZZZ\"");
+  CPPUNIT_ASSERT_MESSAGE("invalid escape should fail",
+      !SearchResponseDecoder::jsonString(DecodedSpan{bad.data(),bad.size()},out));
+}
+
+void SearchResponseDecoderTest::testXmlEscapes() {
+  const std::string body =
+      "<search:response snippet-format=\"raw\" total=\"1\" start=\"1\" page-length=\"10\">"
+      "<search:result index=\"1\" uri=\"/a&amp;b &lt;c&gt; &apos;d&apos; caf&#233; &#x1F600;.xml\" "
+      "path='single &quot;quoted&quot; &unknown; &#xZZ;' format=\"xml\"/>"
+      "</search:response>";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,true,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("references in uri are wrong",
+      "/a&b <c> 'd' caf\xC3\xA9 \xF0\x9F\x98\x80.xml" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("unknown references should be kept","single \"quoted\" &unknown; &#xZZ;" == rows[0].path);
+}
+
+void SearchResponseDecoderTest::testXmlCdataAndComments() {
+  // markup inside comments and CDATA must not be taken for elements
+  const std::string body =
+      "<?xml version=\"1.0\"?>\n"
+      "<!DOCTYPE search:response [ <!ENTITY x \"y\"> ]>\n"
+      "<!-- <search:result index=\"99\"/> -->\n"
+      "<search:response snippet-format=\"raw\" total=\"1\" start=\"1\" page-length=\"10\">"
+      "<!-- a comment with > and </search:response> -->"
+      "<search:result index=\"1\" uri=\"/cdata.xml\" format=\"xml\">"
+      "<search:content><doc><![CDATA[<search:result index=\"2\"/> ]] > ]]></doc><!-- </search:content> --></search:content>"
+      "</search:result>"
+      "<?pi <search:result?>"
+      "<search:metrics><search:total-time><!-- c -->PT<![CDATA[0.1]]>S</search:total-time></search:metrics>"
+      "</search:response>";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,true,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size() && 1 == rows[0].index);
+  CPPUNIT_ASSERT_MESSAGE("content should include the CDATA and comment",
+      std::string::npos != rows[0].content.find("]] > ]]>") &&
+      std::string::npos != rows[0].content.find("<!-- </search:content> -->") &&
+      0 == rows[0].content.find("<search:content>"));
+  CPPUNIT_ASSERT_MESSAGE("metric text should join CDATA and skip comments","PT0.1S" == decoder.getSummary().totalTime);
+}
+
+void SearchResponseDecoderTest::testJsonSingleResultObject() {
+  const std::string body =
+      "{\"snippet-format\":\"raw\",\"total\":1,\"start\":1,\"page-length\":10,"
+      "\"result\":{\"index\":1,\"uri\":\"/single.json\",\"content\":{\"a\":1},\"format\":\"json\"}}";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,false,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("uri is wrong","/single.json" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("content is wrong","{\"a\":1}" == rows[0].content);
+
+  const std::string nullResults = "{\"total\":0,\"results\":null}";
+  rows.clear();
+  CPPUNIT_ASSERT_MESSAGE("null results should decode",decode(decoder,nullResults,false,rows));
+  CPPUNIT_ASSERT_MESSAGE("null results should have no rows",rows.empty());
+}
+
+void SearchResponseDecoderTest::testJsonNoMetricsOrSnippet() {
+  const std::string body =
+      "{\"total\":1,\"start\":1,\"page-length\":10,\"results\":[{\"index\":1,\"uri\":\"/plain.json\"}]}";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,false,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have no snippet format",!decoder.getSummary().hasSnippetFormat);
+  CPPUNIT_ASSERT_MESSAGE("should have no metrics",!decoder.getSummary().hasMetrics &&
+      decoder.getSummary().totalTime.empty());
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size());
+  CPPUNIT_ASSERT_MESSAGE("snippet, content and matches should be absent",
+      rows[0].snippet.empty() && rows[0].content.empty() && rows[0].matches.empty());
+}
+
+void SearchResponseDecoderTest::testXmlNoMetricsOrSnippet() {
+  const std::string body =
+      "<search:response total=\"1\" start=\"1\" page-length=\"10\">"
+      "<search:result index=\"1\" uri=\"/plain.xml\"></search:result>"
+      "</search:response>";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,true,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have no snippet format",!decoder.getSummary().hasSnippetFormat);
+  CPPUNIT_ASSERT_MESSAGE("should have no metrics",!decoder.getSummary().hasMetrics);
+  CPPUNIT_ASSERT_MESSAGE("should have one row",1 == rows.size() && "/plain.xml" == rows[0].uri);
+  CPPUNIT_ASSERT_MESSAGE("snippet, content and matches should be absent",
+      rows[0].snippet.empty() && rows[0].content.empty() && rows[0].matches.empty());
+}
+
+void SearchResponseDecoderTest::testJsonTruncated() {
+  // cut part way through the second result - the first is still handled
+  const std::size_t cut = JSON_RESPONSE.find("/doc/12.xml");
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("truncated body should fail",!decode(decoder,JSON_RESPONSE.substr(0,cut),false,rows));
+  CPPUNIT_ASSERT_MESSAGE("should report an error",!decoder.getError().empty());
+  CPPUNIT_ASSERT_MESSAGE("rows before the error should be handled",1 == rows.size() && "/doc/11.json" == rows[0].uri);
+
+  // every prefix must fail (or succeed) cleanly, never reading past the end
+  for (std::size_t length = 0;length < JSON_RESPONSE.size();length++) {
+    std::vector<Decoded> partial;
+    CPPUNIT_ASSERT_MESSAGE("prefix should fail",!decode(decoder,JSON_RESPONSE.substr(0,length),false,partial));
+  }
+}
+
+void SearchResponseDecoderTest::testXmlTruncated() {
+  const std::size_t cut = XML_RESPONSE.find("/doc/12.xml");
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("truncated body should fail",!decode(decoder,XML_RESPONSE.substr(0,cut),true,rows));
+  CPPUNIT_ASSERT_MESSAGE("should report an error",!decoder.getError().empty());
+  CPPUNIT_ASSERT_MESSAGE("rows before the error should be handled",1 == rows.size() && "/doc/11.xml" == rows[0].uri);
+
+  const std::size_t end = XML_RESPONSE.find("</search:response>");
+  for (std::size_t length = 0;length < end;length++) {
+    std::vector<Decoded> partial;
+    CPPUNIT_ASSERT_MESSAGE("prefix should fail",!decode(decoder,XML_RESPONSE.substr(0,length),true,partial));
+  }
+}
+
+void SearchResponseDecoderTest::testJsonErrorResponse() {
+  // not a search response - decodes, but has no results or summary. SearchResultSet checks the status code first.
+  const std::string body =
+      "{\"errorResponse\":{\"statusCode\":400,\"status\":\"Bad Request\",\"messageCode\":\"REST-INVALIDPARAM\","
+      "\"message\":\"REST-INVALIDPARAM: (err:FOER0000) Invalid parameter: start\"}}";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,false,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have no rows",rows.empty());
+  CPPUNIT_ASSERT_MESSAGE("should have no summary",!decoder.getSummary().hasSnippetFormat &&
+      0 == decoder.getSummary().total);
+
+  const std::string notJson = "<html><body>502 Bad Gateway</body></html>";
+  CPPUNIT_ASSERT_MESSAGE("a non JSON body should fail",!decode(decoder,notJson,false,rows));
+}
+
+void SearchResponseDecoderTest::testXmlErrorResponse() {
+  const std::string body =
+      "<?xml version=\"1.0\"?>"
+      "<error-response xmlns=\"http://marklogic.com/xdmp/error\"><status-code>400</status-code>"
+      "<status>Bad Request</status><message-code>REST-INVALIDPARAM</message-code>"
+      "<message>REST-INVALIDPARAM: Invalid parameter: start</message></error-response>";
+  SearchResponseDecoder decoder;
+  std::vector<Decoded> rows;
+  CPPUNIT_ASSERT_MESSAGE("should decode",decode(decoder,body,true,rows));
+  CPPUNIT_ASSERT_MESSAGE("should have no rows",rows.empty());
+  CPPUNIT_ASSERT_MESSAGE("should have no summary",!decoder.getSummary().hasSnippetFormat &&
+      0 == decoder.getSummary().total);
+
+  const std::string notXml = "502 Bad Gateway";
+  CPPUNIT_ASSERT_MESSAGE("a body without elements should fail",!decode(decoder,notXml,true,rows));
+}
@@ -0,0 +1,50 @@
+/*
+ * SearchResponseDecoderTest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef TEST_SEARCHRESPONSEDECODERTEST_HPP_
+#define TEST_SEARCHRESPONSEDECODERTEST_HPP_
+
+#include <cppunit/Test.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/*
+ * Tests the single pass search response decoder against JSON and XML response fixtures. Needs no server.
+ */
+class SearchResponseDecoderTest : public CppUnit::TestCase {
+  CPPUNIT_TEST_SUITE(SearchResponseDecoderTest);
+    CPPUNIT_TEST(testJsonResponse);
+    CPPUNIT_TEST(testXmlResponse);
+    CPPUNIT_TEST(testJsonEscapes);
+    CPPUNIT_TEST(testXmlEscapes);
+    CPPUNIT_TEST(testXmlCdataAndComments);
+    CPPUNIT_TEST(testJsonSingleResultObject);
+    CPPUNIT_TEST(testJsonNoMetricsOrSnippet);
+    CPPUNIT_TEST(testXmlNoMetricsOrSnippet);
+    CPPUNIT_TEST(testJsonTruncated);
+    CPPUNIT_TEST(testXmlTruncated);
+    CPPUNIT_TEST(testJsonErrorResponse);
+    CPPUNIT_TEST(testXmlErrorResponse);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp();
+  void tearDown();
+
+  void testJsonResponse(void);
+  void testXmlResponse(void);
+  void testJsonEscapes(void);
+  void testXmlEscapes(void);
+  void testXmlCdataAndComments(void);
+  void testJsonSingleResultObject(void);
+  void testJsonNoMetricsOrSnippet(void);
+  void testXmlNoMetricsOrSnippet(void);
+  void testJsonTruncated(void);
+  void testXmlTruncated(void);
+  void testJsonErrorResponse(void);
+  void testXmlErrorResponse(void);
+};
+
+#endif /* TEST_SEARCHRESPONSEDECODERTEST_HPP_ */
@@ -0,0 +1,192 @@
+/*
+ * SyncManifestTest.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SyncManifestTest.hpp"
+#include "mlclient/internals/SyncManifest.hpp"
+#include "mlclient/Document.hpp"
+#include "mlclient/DocumentContent.hpp"
+
+#include "mlclient/logging.hpp"
+
+using namespace mlclient;
+using namespace mlclient::internals;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SyncManifestTest);
+
+namespace {
+
+const std::string MANIFEST("SyncManifestTest.manifest");
+const std::string CONTENT_FILE("SyncManifestTest.bin");
+
+Document textDocument(const std::string& uri,const std::string& text) {
+  GenericTextDocumentContent* content = new GenericTextDocumentContent();
+  content->setContent(text);
+  return Document(uri,content);
+}
+
+std::uint64_t hashOf(const char* text,const std::uint64_t seed = 0) {
+  return xxhash64(text,std::strlen(text),seed);
+}
+
+/*
+ * Checks then commits doc, as a successful upload would. Returns whether it was unchanged.
+ */
+bool upload(SyncManifest& manifest,const Document& doc) {
+  SyncManifest::Entry entry;
+  const bool unchanged = manifest.check(doc,entry);
+  if (!unchanged) {
+    manifest.commit(doc.getUri(),entry);
+  }
+  return unchanged;
+}
+
+} // end anonymous namespace
+
+void SyncManifestTest::setUp(void) {
+  LOG(DEBUG) << "ENTERING TEST SUITE SyncManifestTest";
+  std::remove(MANIFEST.c_str());
+}
+
+void SyncManifestTest::tearDown(void) {
+  std::remove(MANIFEST.c_str());
+  std::remove(CONTENT_FILE.c_str());
+  LOG(DEBUG) << "LEAVING TEST SUITE SyncManifestTest";
+}
+
+void SyncManifestTest::testXxhash64Vectors() {
+  // published XXH64 values, covering the short (< 32 byte) and striped paths
+  CPPUNIT_ASSERT_MESSAGE("empty input",0xEF46DB3751D8E999ULL == xxhash64(nullptr,0));
+  CPPUNIT_ASSERT_MESSAGE("'a'",0xD24EC4F1A98C6E5BULL == hashOf("a"));
+  CPPUNIT_ASSERT_MESSAGE("'abc'",0x44BC2CF5AD770999ULL == hashOf("abc"));
+  CPPUNIT_ASSERT_MESSAGE("'xxhash'",0x32DD38952C4BC720ULL == hashOf("xxhash"));
+  CPPUNIT_ASSERT_MESSAGE("39 bytes",0xFBCEA83C8A378BF1ULL == hashOf("Nobody inspects the spammish repetition"));
+  // and seeded, as given by the reference algorithm
+  CPPUNIT_ASSERT_MESSAGE("'xxhash' with seed 20",0x48B35AA98DC04F56ULL == hashOf("xxhash",20));
+}
+
+void SyncManifestTest::testXxhash64Pieces() {
+  std::string data;
+  for (int i = 0;i < 1000;i++) {
+    data += (char)(i * 31 + 7);
+  }
+  // every piece size from a byte to more than a stripe, so pieces start and end at every point within a stripe
+  for (size_t length : {0,1,31,32,33,100,1000}) {
+    const std::uint64_t expected = xxhash64(data.data(),length,5);
+    for (size_t piece = 1;piece <= 70;piece++) {
+      XxHash64 hash(5);
+      for (size_t offset = 0;offset < length;offset += piece) {
+        hash.update(data.data() + offset,std::min(piece,length - offset));
+      }
+      CPPUNIT_ASSERT_MESSAGE("pieces of " + std::to_string(piece) + " bytes of " + std::to_string(length),
+          expected == hash.digest());
+    }
+  }
+}
+
+void SyncManifestTest::testFileHashedInPieces() {
+  // larger than the manifest reads at once, and not a whole number of stripes
+  std::string data;
+  for (int i = 0;i < 600 * 1024 + 13;i++) {
+    data += (char)(i % 251);
+  }
+  {
+    std::ofstream out(CONTENT_FILE,std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(data.data(),data.size());
+  }
+  FileDocumentContent content(CONTENT_FILE);
+  Document doc("/large.bin",&content);
+  SyncManifest manifest;
+  manifest.load(MANIFEST);
+  SyncManifest::Entry entry;
+  CPPUNIT_ASSERT_MESSAGE("a new file should be sent",!manifest.check(doc,entry));
+  CPPUNIT_ASSERT_MESSAGE("the whole file should be hashed",
+      data.size() == entry.size && xxhash64(data.data(),data.size()) == entry.contentHash);
+}
+
+void SyncManifestTest::testUnchangedAfterRoundTrip() {
+  Document one = textDocument("/one.txt","first document");
+  Document two = textDocument("/two.txt","second document");
+  {
+    SyncManifest manifest;
+    CPPUNIT_ASSERT_MESSAGE("a missing manifest should load as empty",manifest.load(MANIFEST));
+    CPPUNIT_ASSERT_MESSAGE("first upload should send one",!upload(manifest,one));
+    CPPUNIT_ASSERT_MESSAGE("first upload should send two",!upload(manifest,two));
+    CPPUNIT_ASSERT_MESSAGE("manifest should save",manifest.save());
+  }
+  SyncManifest reloaded;
+  CPPUNIT_ASSERT_MESSAGE("manifest should reload",reloaded.load(MANIFEST));
+  CPPUNIT_ASSERT_MESSAGE("one should be unchanged",upload(reloaded,one));
+  CPPUNIT_ASSERT_MESSAGE("two should be unchanged",upload(reloaded,two));
+  CPPUNIT_ASSERT_MESSAGE("nothing should be unseen",reloaded.getUnseen().empty());
+  delete one.getContent();
+  delete two.getContent();
+}
+
+void SyncManifestTest::testChangedContentAndMetadata() {
+  Document doc = textDocument("/doc.txt","original");
+  {
+    SyncManifest manifest;
+    manifest.load(MANIFEST);
+    upload(manifest,doc);
+    manifest.save();
+  }
+  SyncManifest reloaded;
+  reloaded.load(MANIFEST);
+  Document edited = textDocument("/doc.txt","edited");
+  CPPUNIT_ASSERT_MESSAGE("changed content should be sent",!upload(reloaded,edited));
+  Document moved = textDocument("/doc.txt","edited");
+  CollectionSet cols;
+  cols.push_back("newcollection");
+  moved.setCollections(cols);
+  CPPUNIT_ASSERT_MESSAGE("changed collections should be sent",!upload(reloaded,moved));
+  CPPUNIT_ASSERT_MESSAGE("the same again should be skipped",upload(reloaded,moved));
+  delete doc.getContent();
+  delete edited.getContent();
+  delete moved.getContent();
+}
+
+void SyncManifestTest::testUnseen() {
+  Document keep = textDocument("/keep.txt","keep");
+  Document gone = textDocument("/gone.txt","gone");
+  {
+    SyncManifest manifest;
+    manifest.load(MANIFEST);
+    upload(manifest,keep);
+    upload(manifest,gone);
+    manifest.save();
+  }
+  SyncManifest reloaded;
+  reloaded.load(MANIFEST);
+  upload(reloaded,keep);
+  const std::vector<std::string> unseen = reloaded.getUnseen();
+  CPPUNIT_ASSERT_MESSAGE("only gone should be unseen",1 == unseen.size() && std::string("/gone.txt") == unseen[0]);
+  reloaded.remove("/gone.txt");
+  CPPUNIT_ASSERT_MESSAGE("removed URIs should not be unseen",reloaded.getUnseen().empty());
+  delete keep.getContent();
+  delete gone.getContent();
+}
+
+void SyncManifestTest::testEscapedUris() {
+  Document odd = textDocument("/with\ttab\nand newline\\.txt","odd");
+  {
+    SyncManifest manifest;
+    manifest.load(MANIFEST);
+    upload(manifest,odd);
+    manifest.save();
+  }
+  SyncManifest reloaded;
+  reloaded.load(MANIFEST);
+  CPPUNIT_ASSERT_MESSAGE("URI with separators should survive the round trip",upload(reloaded,odd));
+  delete odd.getContent();
+}
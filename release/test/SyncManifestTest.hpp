@@ -0,0 +1,40 @@
+/*
+ * SyncManifestTest.hpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef TEST_SYNCMANIFESTTEST_HPP_
+#define TEST_SYNCMANIFESTTEST_HPP_
+
+#include <cppunit/Test.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/*
+ * Tests the incremental sync manifest and its content hash. Needs no server.
+ */
+class SyncManifestTest : public CppUnit::TestCase {
+  CPPUNIT_TEST_SUITE(SyncManifestTest);
+    CPPUNIT_TEST(testXxhash64Vectors);
+    CPPUNIT_TEST(testXxhash64Pieces);
+    CPPUNIT_TEST(testFileHashedInPieces);
+    CPPUNIT_TEST(testUnchangedAfterRoundTrip);
+    CPPUNIT_TEST(testChangedContentAndMetadata);
+    CPPUNIT_TEST(testUnseen);
+    CPPUNIT_TEST(testEscapedUris);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp();
+  void tearDown();
+
+  void testXxhash64Vectors(void);
+  void testXxhash64Pieces(void);
+  void testFileHashedInPieces(void);
+  void testUnchangedAfterRoundTrip(void);
+  void testChangedContentAndMetadata(void);
+  void testUnseen(void);
+  void testEscapedUris(void);
+};
+
+#endif /* TEST_SYNCMANIFESTTEST_HPP_ */